@@ -0,0 +1,99 @@
+// Builds many short lists, like the name and value pairs of an event being
+// logged, in a Vector and in a SmallVector, and reports heap allocations and
+// time per list. Up to the inline size the SmallVector makes none.
+//
+// Usage: small_vector_bench [lists per size]
+
+#include "small_vector.h"
+#include "vector.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    long g_allocations{0};
+
+    // One name and value pair of a logged event.
+    struct Property
+    {
+        const char* m_name{nullptr};
+        long m_value{0};
+    };
+
+    const int INLINE_SIZE = 8;
+
+    struct Result
+    {
+        double m_nsPerList{0};
+        double m_allocationsPerList{0};
+        long m_checksum{0};
+    };
+
+    template<typename List>
+    Result Build(int lists, int length)
+    {
+        Result result;
+        const long allocations = g_allocations;
+        const Clock::time_point start = Clock::now();
+
+        for (int l = 0; l < lists; ++l)
+        {
+            List list;
+            for (int i = 0; i < length; ++i)
+            {
+                list.emplace_back(Property{"property", l + i});
+            }
+            for (const Property& property : list)
+            {
+                result.m_checksum += property.m_value;
+            }
+        }
+
+        result.m_nsPerList = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / lists;
+        result.m_allocationsPerList = static_cast<double>(g_allocations - allocations) / lists;
+        return result;
+    }
+
+    void Print(const char* name, int length, const Result& result)
+    {
+        std::printf("%-16s %7d %12.2f %14.2f %16ld\n", name, length, result.m_nsPerList, result.m_allocationsPerList, result.m_checksum);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char** argv)
+{
+    const int lists = argc > 1 ? std::stoi(argv[1]) : 1000000;
+
+    std::printf("%-16s %7s %12s %14s %16s\n", "list", "length", "ns/list", "allocs/list", "checksum");
+    for (const int length : {1, 2, 4, 8, 16, 32})
+    {
+        Print("Vector", length, Build<Container::Vector<Property>>(lists, length));
+        Print("SmallVector<8>", length, Build<Container::SmallVector<Property, INLINE_SIZE>>(lists, length));
+    }
+    return EXIT_SUCCESS;
+}
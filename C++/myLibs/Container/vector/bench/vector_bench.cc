@@ -0,0 +1,280 @@
+// Appends N elements one at a time and reports the cost per append, which
+// stays flat as N grows when growth is geometric. The old behaviour, a new
+// array and a full copy on every insert, is timed alongside for the smaller
+// sizes. Then counts the element copies growth makes for a type that can be
+// moved without throwing, and one that can't, and times resizing a numeric
+// buffer that is filled right after, with value-init zeroing it first and
+// default-init not. Last, removes every third element with erase_if and with
+// remove one at a time, and inserts a block in the middle with one range
+// insert and with insertBefore one at a time.
+//
+// Usage: vector_bench [largest N]
+
+#include "vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Appends the way Vector did before it had a capacity.
+    struct CopyEveryInsert
+    {
+        int* m_data{nullptr};
+        int m_length{0};
+
+        CopyEveryInsert() = default;
+        CopyEveryInsert(const CopyEveryInsert&) = delete;
+        CopyEveryInsert& operator=(const CopyEveryInsert&) = delete;
+        ~CopyEveryInsert() { delete[] m_data; }
+
+        void InsertAtEnd(int value)
+        {
+            int* data = new int[static_cast<unsigned long>(m_length + 1)];
+            for (int i = 0; i < m_length; ++i)
+            {
+                data[i] = m_data[i];
+            }
+            data[m_length] = value;
+            delete[] m_data;
+            m_data = data;
+            ++m_length;
+        }
+    };
+
+    struct Result
+    {
+        double m_nsPerAppend{0};
+        int m_reallocations{0};
+        long m_checksum{0};
+    };
+
+    Result AppendVector(int n, bool reserve)
+    {
+        Result result;
+        const Clock::time_point start = Clock::now();
+
+        Container::Vector<int> vector;
+        if (reserve)
+        {
+            vector.reserve(n);
+        }
+        int capacity = vector.getCapacity();
+        for (int i = 0; i < n; ++i)
+        {
+            vector.push_back(i);
+            if (vector.getCapacity() != capacity)
+            {
+                capacity = vector.getCapacity();
+                ++result.m_reallocations;
+            }
+        }
+        for (const int value : vector)
+        {
+            result.m_checksum += value;
+        }
+
+        result.m_nsPerAppend = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+        return result;
+    }
+
+    Result AppendCopyEveryInsert(int n)
+    {
+        Result result;
+        const Clock::time_point start = Clock::now();
+
+        CopyEveryInsert vector;
+        for (int i = 0; i < n; ++i)
+        {
+            vector.InsertAtEnd(i);
+        }
+        result.m_reallocations = n;
+        for (int i = 0; i < vector.m_length; ++i)
+        {
+            result.m_checksum += vector.m_data[i];
+        }
+
+        result.m_nsPerAppend = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+        return result;
+    }
+
+    // Counts how it is copied and moved.
+    template<bool NoexceptMove>
+    struct Tracked
+    {
+        static inline long s_copies{0};
+        static inline long s_moves{0};
+
+        std::string m_value{};
+
+        Tracked() = default;
+        explicit Tracked(int value) : m_value(std::to_string(value)) {}
+        Tracked(const Tracked& other) : m_value{other.m_value} { ++s_copies; }
+        Tracked(Tracked&& other) noexcept(NoexceptMove) : m_value{std::move(other.m_value)} { ++s_moves; }
+        Tracked& operator=(const Tracked& other) { m_value = other.m_value; ++s_copies; return *this; }
+        Tracked& operator=(Tracked&& other) noexcept(NoexceptMove) { m_value = std::move(other.m_value); ++s_moves; return *this; }
+    };
+
+    template<bool NoexceptMove>
+    void CountRelocations(const char* name, int n)
+    {
+        using Element = Tracked<NoexceptMove>;
+        Element::s_copies = 0;
+        Element::s_moves = 0;
+
+        const Clock::time_point start = Clock::now();
+        Container::Vector<Element> vector;
+        for (int i = 0; i < n; ++i)
+        {
+            vector.push_back(Element{i});
+        }
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+        std::printf("%-18s %9d %12.2f %14ld %16ld\n", name, n, ns, Element::s_copies, Element::s_moves);
+    }
+
+    template<typename... Init>
+    void ResizeAndFill(const char* name, int n, Init... init)
+    {
+        const int rounds = std::max(1, 10000000 / n);
+        double checksum = 0;
+
+        const Clock::time_point start = Clock::now();
+        for (int round = 0; round < rounds; ++round)
+        {
+            Container::Vector<double> vector;
+            vector.resize(n, init...);
+            for (double& value : vector)
+            {
+                value = round;
+            }
+            checksum += vector[n - 1];
+        }
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / rounds / n;
+
+        std::printf("%-18s %9d %12.3f %16.0f\n", name, n, ns, checksum);
+    }
+
+    void Fill(Container::Vector<int>& vector, int n)
+    {
+        vector.reserve(n);
+        for (int i = 0; i < n; ++i)
+        {
+            vector.push_back(i);
+        }
+    }
+
+    double NsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    void Filter(int n, bool one_at_a_time)
+    {
+        Container::Vector<int> vector;
+        Fill(vector, n);
+
+        const Clock::time_point start = Clock::now();
+        if (one_at_a_time)
+        {
+            for (int i = vector.getLength() - 1; i >= 0; --i)
+            {
+                if (vector[i] % 3 == 0)
+                {
+                    vector.remove(i);
+                }
+            }
+        }
+        else
+        {
+            vector.erase_if([](int value) { return value % 3 == 0; });
+        }
+        const double ns = NsSince(start);
+
+        std::printf("%-18s %9d %12.2f %16d\n", one_at_a_time ? "remove each" : "erase_if", n, ns / n, vector.getLength());
+    }
+
+    void InsertBlock(int n, bool one_at_a_time)
+    {
+        Container::Vector<int> vector;
+        Fill(vector, n);
+        Container::Vector<int> block;
+        Fill(block, n / 10);
+
+        const Clock::time_point start = Clock::now();
+        if (one_at_a_time)
+        {
+            int index = n / 2;
+            for (const int value : block)
+            {
+                vector.insertBefore(value, index++);
+            }
+        }
+        else
+        {
+            vector.insert(n / 2, block.begin(), block.end());
+        }
+        const double ns = NsSince(start);
+
+        std::printf("%-18s %9d %12.2f %16d\n", one_at_a_time ? "insertBefore each" : "range insert", n, ns / n, vector.getLength());
+    }
+
+    void Print(const char* name, int n, const Result& result)
+    {
+        std::printf("%-18s %9d %12.2f %14d %16ld\n", name, n, result.m_nsPerAppend, result.m_reallocations, result.m_checksum);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int largest = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    // Beyond this the full copy per insert takes too long to wait for.
+    const int largest_copy = 10000;
+
+    std::printf("%-18s %9s %12s %14s %16s\n", "append", "n", "ns/append", "reallocations", "checksum");
+    for (int n = 1000; n <= largest; n *= 10)
+    {
+        Print("push_back", n, AppendVector(n, false));
+        Print("reserve+push_back", n, AppendVector(n, true));
+        if (n <= largest_copy)
+        {
+            Print("copy every insert", n, AppendCopyEveryInsert(n));
+        }
+    }
+
+    std::printf("\n%-18s %9s %12s %14s %16s\n", "relocate", "n", "ns/append", "copies", "moves");
+    for (int n = 1000; n <= largest; n *= 10)
+    {
+        CountRelocations<true>("noexcept move", n);
+        CountRelocations<false>("throwing move", n);
+    }
+
+    std::printf("\n%-18s %9s %12s %16s\n", "resize+fill", "n", "ns/element", "checksum");
+    for (int n = 1000; n <= largest * 10; n *= 10)
+    {
+        ResizeAndFill("value-init", n);
+        ResizeAndFill("default-init", n, Container::defaultInit);
+    }
+
+    // One at a time is K x N, only run it where that finishes.
+    const int largest_each = 100000;
+    std::printf("\n%-18s %9s %12s %16s\n", "bulk", "n", "ns/element", "length after");
+    for (int n = 1000; n <= largest; n *= 10)
+    {
+        Filter(n, false);
+        if (n <= largest_each)
+        {
+            Filter(n, true);
+        }
+        InsertBlock(n, false);
+        if (n <= largest_each)
+        {
+            InsertBlock(n, true);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include "vector.h"
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace Container
+{
+    // Inline storage of a SmallVector, a base class so it is there before the
+    // Vector that uses it is constructed.
+    template<typename T, int N>
+    struct InlineStorage
+    {
+        alignas(T) std::byte m_storage[sizeof(T) * N];
+
+        T* storage(void) {return reinterpret_cast<T*>(m_storage);}
+    };
+
+    // Vector keeping up to N elements inside itself, so small ones never
+    // touch the heap. Past N it grows onto the heap like a Vector, and goes
+    // back inline on shrink_to_fit once the elements fit again.
+    //
+    // Moving one that is inline moves its elements one by one.
+    template<typename T, int N, typename Alloc = std::allocator<T>>
+    class SmallVector : private InlineStorage<T, N>, private Vector<T, Alloc>
+    {
+    private:// Private verables
+        using Base = Vector<T, Alloc>;
+        using Traits = typename Base::Traits;
+
+        static_assert(N > 0, "SmallVector needs room for at least one element");
+
+
+    public:// Public verables
+        using allocator_type = Alloc;
+
+
+    private:// Private Methods
+        SmallVector(const SmallVector&) = delete;
+
+        using InlineStorage<T, N>::storage;
+
+
+    public:// Public Methods
+        SmallVector(void) : Base(storage(), N, Alloc{}) {}
+
+        explicit SmallVector(const Alloc& allocator) : Base(storage(), N, allocator) {}
+
+        SmallVector(int length, const Alloc& allocator = Alloc{});
+
+        SmallVector(std::initializer_list<T> list, const Alloc& allocator = Alloc{});
+
+        SmallVector(SmallVector&& vector) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        SmallVector& operator=(std::initializer_list<T> list){Base::operator=(list); return *this;}
+
+        SmallVector& operator=(const SmallVector& vector){Base::operator=(vector); return *this;}
+
+        SmallVector& operator=(SmallVector&& vector);
+
+        ~SmallVector(void) = default;
+
+        // Whether the elements are in the inline storage
+        bool isSmall(void) const {return Base::isInline();}
+
+        using Base::get_allocator;
+        using Base::erase;
+        using Base::begin;
+        using Base::end;
+        using Base::operator[];
+        using Base::getLength;
+        using Base::getCapacity;
+        using Base::reallocate;
+        using Base::resize;
+        using Base::reserve;
+        using Base::shrink_to_fit;
+        using Base::emplace_back;
+        using Base::emplace;
+        using Base::push_back;
+        using Base::pop_back;
+        using Base::insertBefore;
+        using Base::remove;
+        using Base::insert;
+        using Base::erase_if;
+        using Base::insertAtBeginning;
+        using Base::insertAtEnd;
+    };
+
+
+
+
+
+    template<typename T, int N, typename Alloc>
+    SmallVector<T, N, Alloc>::SmallVector(int length, const Alloc& allocator)
+        : Base(storage(), N, allocator)
+    {
+        if(length < 0)
+        {
+            throw std::runtime_error("We can't have the length less than zero!");
+        }
+
+        resize(length);
+    }
+
+    template<typename T, int N, typename Alloc>
+    SmallVector<T, N, Alloc>::SmallVector(std::initializer_list<T> list, const Alloc& allocator)
+        : Base(storage(), N, allocator)
+    {
+        Base::operator=(list);
+    }
+
+    template<typename T, int N, typename Alloc>
+    SmallVector<T, N, Alloc>::SmallVector(SmallVector&& vector) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : Base(storage(), N, vector.m_allocator)
+    {
+        // Inline elements always fit our own inline storage, so this doesn't
+        // allocate.
+        Base::takeFrom(vector);
+    }
+
+    template<typename T, int N, typename Alloc>
+    SmallVector<T, N, Alloc>& SmallVector<T, N, Alloc>::operator=(SmallVector&& vector)
+    {
+        if(this == &vector)
+        {
+            return *this;
+        }
+
+        Base::erase();
+
+        if constexpr(Traits::propagate_on_container_move_assignment::value)
+        {
+            this->m_allocator = std::move(vector.m_allocator);
+        }
+
+        Base::takeFrom(vector);
+        return *this;
+    }
+
+    namespace pmr
+    {
+        // SmallVector spilling into a std::pmr::memory_resource.
+        template<typename T, int N>
+        using SmallVector = Container::SmallVector<T, N, std::pmr::polymorphic_allocator<T>>;
+    }
+}
+#endif
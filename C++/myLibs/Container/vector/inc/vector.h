@@ -1,39 +1,131 @@
 #ifndef INT_ARRAY_H
 #define INT_ARRAY_H
 
+#include <algorithm>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace Container
 {
-    template<typename T>
+    // Tag for resize: new elements are default-initialized, which leaves
+    // numbers and other trivial types unset instead of zeroing them.
+    struct DefaultInit {};
+    inline constexpr DefaultInit defaultInit{};
+
+    // Alloc is a standard allocator, std::pmr::polymorphic_allocator to take
+    // memory from a std::pmr::memory_resource. Elements are constructed
+    // through it, so they get the allocator too if they use one.
+    template<typename T, typename Alloc = std::allocator<T>>
     class Vector
     {
-    private:// Private verables
+    protected:// Protected verables
+        using Traits = std::allocator_traits<Alloc>;
+
+        // Room for m_capacity elements, the first m_length are constructed
+        // and the rest is raw memory.
         T* m_data;
         int m_length;
+        int m_capacity;
+        [[no_unique_address]] Alloc m_allocator;
 
+        // Storage inside a SmallVector, used while the elements fit and
+        // never freed. nullptr in a Vector.
+        T* m_inlineData;
+        int m_inlineCapacity;
 
-    public:// Public verables
 
+    public:// Public verables
+        // Lets std::pmr containers of vectors hand their memory resource on.
+        using allocator_type = Alloc;
 
     private:// Private Methods
         Vector(const Vector&) = delete;
 
 
+    protected:// Protected Methods
+        // For SmallVector, starts out using the inline storage.
+        Vector(T* inlineData, int inlineCapacity, const Alloc& allocator)
+            : m_data{inlineData}, m_length{0}, m_capacity{inlineCapacity}, m_allocator{allocator},
+              m_inlineData{inlineData}, m_inlineCapacity{inlineCapacity} {}
+
+        bool isInline(void) const { return m_data == m_inlineData; }
+
+        // Frees m_data unless it is the inline storage.
+        void releaseStorage(void);
+
+        // Takes the elements of vector, leaving it empty. Its storage is
+        // taken over if it is on the heap and can be freed through our
+        // allocator, otherwise the elements are moved one by one, like
+        // std::pmr containers do. This must be empty.
+        void takeFrom(Vector& vector);
+
+        // Trivially copyable elements are moved around as bytes.
+        static constexpr bool isTrivial{std::is_trivially_copyable_v<T>};
+
+        T* allocate(int capacity);
+
+        void deallocate(T* data, int capacity);
+
+        template<typename... Args>
+        void construct(T* at, Args&&... args){Traits::construct(m_allocator, at, std::forward<Args>(args)...);}
+
+        void destroy(T* first, T* last);
+
+        // Constructs count elements at destination with make(at, index),
+        // either all of them or, if one throws, none.
+        template<typename Make>
+        void constructEach(T* destination, int count, Make make);
+
+        // Moves the elements to storage for exactly capacity elements, the
+        // inline storage if they fit.
+        void reallocateStorage(int capacity);
+
+        // Constructs count elements in the raw memory at destination from
+        // those at source, which must not overlap. Copies if moving T could
+        // throw. Either all are constructed or none, the source elements are
+        // left for the caller to destroy.
+        void relocate(T* source, int count, T* destination);
+
+        // Makes room for at least length elements, doubling the capacity so
+        // that appending one at a time costs amortized O(1).
+        void grow(int length);
+
+        // Replaces the elements with copies of count elements from source.
+        void assign(const T* source, int count);
+
+
     public:// Public Methods
-        Vector(void) : m_data{nullptr}, m_length{0} {}
+        Vector(void) : Vector(nullptr, 0, Alloc{}) {}
+
+        explicit Vector(const Alloc& allocator) : Vector(nullptr, 0, allocator) {}
 
-        Vector(int length);
+        Vector(int length, const Alloc& allocator = Alloc{});
 
-        Vector(std::initializer_list<T> list);
+        Vector(std::initializer_list<T> list, const Alloc& allocator = Alloc{});
 
         Vector& operator=(std::initializer_list<T> list);
 
-        Vector& operator=(Vector& vector);
+        Vector(Vector&& vector) noexcept;
+
+        // Moves the elements one by one only if vector's memory can't be
+        // freed through allocator.
+        Vector(Vector&& vector, const Alloc& allocator);
+
+        Vector& operator=(const Vector& vector);
+
+        Vector& operator=(Vector&& vector) noexcept(Traits::propagate_on_container_move_assignment::value ||
+                                                    Traits::is_always_equal::value);
 
         ~Vector(void);
 
+        Alloc get_allocator(void) const { return m_allocator; }
+
         void erase(void);
 
         T* begin(void) {return m_data;}
@@ -44,215 +136,749 @@ namespace Container
 
         int getLength(void) { return m_length; }
 
+        int getCapacity(void) { return m_capacity; }
+
         // Will remove every element from the vector and then resize
         void reallocate(int length);
 
-        // Will resize without delete the elements
+        // Will resize without delete the elements, new elements are
+        // value-initialized
         void resize(int length);
 
-        void insertBefore(T value, int index);
+        // Same, but new elements are default-initialized
+        void resize(int length, DefaultInit);
+
+        // Makes room for capacity elements without changing the length
+        void reserve(int capacity);
+
+        // Frees the room not used by elements
+        void shrink_to_fit(void);
+
+        // Constructs an element from args at the end
+        template<typename... Args>
+        T& emplace_back(Args&&... args);
+
+        // Constructs an element from args before index
+        template<typename... Args>
+        T& emplace(int index, Args&&... args);
+
+        void push_back(const T& value){emplace_back(value);}
+
+        void push_back(T&& value){emplace_back(std::move(value));}
+
+        void pop_back(void);
+
+        template<typename U>
+        void insertBefore(U&& value, int index){emplace(index, std::forward<U>(value));}
 
         void remove(int index);
 
-        void insertAtBeginning(T value){insertBefore(value, 0);}
+        // Inserts copies of the elements in [first, last) before index, in
+        // one pass over the tail. The range must not be in this vector.
+        template<typename It>
+        void insert(int index, It first, It last);
+
+        // Removes the elements from index first up to, not including, last
+        void erase(int first, int last);
+
+        // Removes every element pred is true for in one pass, keeping the
+        // order of the rest. Returns how many were removed.
+        template<typename Pred>
+        int erase_if(Pred pred);
 
-        void insertAtEnd(T value){insertBefore(value, m_length);}
+        template<typename U>
+        void insertAtBeginning(U&& value){emplace(0, std::forward<U>(value));}
+
+        template<typename U>
+        void insertAtEnd(U&& value){emplace_back(std::forward<U>(value));}
     };
 
 
 
 
 
-    template<typename T>
-    Vector<T>::Vector(int length) : m_data{nullptr}, m_length{length}
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>::Vector(int length, const Alloc& allocator)
+        : Vector(nullptr, 0, allocator)
     {
         if(length < 0)
         {
             throw std::runtime_error("We can't have the length less than zero!");
         }
 
-        if(length > 0)
-        {
-            m_data = new T[(long unsigned int)length];
-        }
+        resize(length);
     }
 
-    template<typename T>
-    Vector<T>::Vector(std::initializer_list<T> list)
-        : Vector(static_cast<int>(list.size()))
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>::Vector(std::initializer_list<T> list, const Alloc& allocator)
+        : Vector(nullptr, 0, allocator)
     {
-        int counter{};
-        for(const auto& elem : list)
-        {
-            m_data[counter] = elem;
-            ++counter;
-        }
+        assign(list.begin(), static_cast<int>(list.size()));
+    }
+
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>::Vector(Vector&& vector) noexcept
+        : m_data{std::exchange(vector.m_data, nullptr)},
+          m_length{std::exchange(vector.m_length, 0)},
+          m_capacity{std::exchange(vector.m_capacity, 0)},
+          m_allocator{std::move(vector.m_allocator)},
+          m_inlineData{nullptr},
+          m_inlineCapacity{0}
+    {
+
     }
 
-    template<typename T>
-    Vector<T>::~Vector(void)
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>::Vector(Vector&& vector, const Alloc& allocator)
+        : Vector(allocator)
     {
-        delete[] m_data;
+        takeFrom(vector);
+    }
+
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>::~Vector(void)
+    {
+        erase();
+    }
+
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>& Vector<T, Alloc>::operator=(std::initializer_list<T> list)
+    {
+        assign(list.begin(), static_cast<int>(list.size()));
+        return *this;
     }
 
-    template<typename T>
-    Vector<T>& Vector<T>::operator=(std::initializer_list<T> list)
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>& Vector<T, Alloc>::operator=(const Vector<T, Alloc>& vector)
     {
-        if(m_length <= static_cast<int>(list.size()))
+        if(this == &vector)
         {
-            resize(static_cast<int>(list.size()));
+            return *this;
         }
-        int counter{};
-        for(auto elem : list)
+
+        // Storage from our allocator can't be kept if we take theirs.
+        if constexpr(Traits::propagate_on_container_copy_assignment::value)
         {
-            m_data[counter] = elem;
-            ++counter;
+            if(m_allocator != vector.m_allocator)
+            {
+                erase();
+            }
+            m_allocator = vector.m_allocator;
         }
+
+        assign(vector.m_data, vector.m_length);
         return *this;
     }
 
-    template<typename T>
-    Vector<T>& Vector<T>::operator=(Vector<T>& vector)
+    template<typename T, typename Alloc>
+    Vector<T, Alloc>& Vector<T, Alloc>::operator=(Vector<T, Alloc>&& vector)
+        noexcept(Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value)
     {
         if(this == &vector)
         {
             return *this;
         }
 
-        m_length = vector.m_length;
+        erase();
 
-        for(int counter{}; auto elem : vector)
+        if constexpr(Traits::propagate_on_container_move_assignment::value)
         {
-            m_data[counter] = elem;
-            ++counter;
+            m_allocator = std::move(vector.m_allocator);
         }
+
+        takeFrom(vector);
         return *this;
     }
 
-    template<typename T>
-    void Vector<T>::erase(void)
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::erase(void)
     {
-        delete[] m_data;
+        destroy(m_data, m_data + m_length);
+        releaseStorage();
 
-        m_data = nullptr;
+        m_data = m_inlineData;
         m_length = 0;
+        m_capacity = m_inlineCapacity;
     }
 
-    template<typename T>
-    T& Vector<T>::operator[](int index)
+    template<typename T, typename Alloc>
+    T& Vector<T, Alloc>::operator[](int index)
     {
-        if(index < 0 || index > m_length)
+        if(index < 0 || index >= m_length)
         {
             throw std::runtime_error("Infilled index");
         }
         return m_data[index];
     }
 
-    template<typename T>
-    void Vector<T>::reallocate(int length)
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::reallocate(int length)
     {
         erase();
 
         if(length <= 0)
             return;
 
+        if(length > m_capacity)
+        {
+            m_data = allocate(length);
+            m_capacity = length;
+        }
+        constructEach(m_data, length, [this](T* at, int){construct(at);});
         m_length = length;
-        m_data = new T[(unsigned long)length];
     }
 
-    template<typename T>
-    void Vector<T>::resize(int length)
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::resize(int length)
     {
-        if(length == m_length)
+        if(length < 0)
         {
-            return;
+            throw std::runtime_error("We can't have the length less than zero!");
+        }
+
+        if(length < m_length)
+        {
+            destroy(m_data + length, m_data + m_length);
         }
-        else if(length <= 0)
+        else if(length > m_length)
         {
-            erase();
-            return;
+            if(length > m_capacity)
+            {
+                grow(length);
+            }
+            constructEach(m_data + m_length, length - m_length, [this](T* at, int){construct(at);});
         }
 
-        T* newData{new T[(unsigned long)length]};
+        m_length = length;
+    }
 
-        if(m_length > 0)
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::resize(int length, DefaultInit)
+    {
+        if(length < 0)
         {
-            int elemToCopy{(m_length > length)? length : m_length};
+            throw std::runtime_error("We can't have the length less than zero!");
+        }
 
-            for(int counter{0}; counter < elemToCopy ; ++counter)
+        if(length < m_length)
+        {
+            destroy(m_data + length, m_data + m_length);
+        }
+        else if(length > m_length)
+        {
+            if(length > m_capacity)
+            {
+                grow(length);
+            }
+            // Only trivial types are left unset, the rest is built the same
+            // way as by resize(length) to go through the allocator.
+            if constexpr(std::is_trivially_default_constructible_v<T>)
             {
-                newData[counter] = m_data[counter];
+                std::uninitialized_default_construct(m_data + m_length, m_data + length);
             }
+            else
+            {
+                constructEach(m_data + m_length, length - m_length, [this](T* at, int){construct(at);});
+            }
+        }
 
+        m_length = length;
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::reserve(int capacity)
+    {
+        if(capacity > m_capacity)
+        {
+            reallocateStorage(capacity);
         }
+    }
 
-        delete[] m_data;
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::shrink_to_fit(void)
+    {
+        if(m_length == 0)
+        {
+            erase();
+        }
+        else if(!isInline() && m_capacity > m_length)
+        {
+            reallocateStorage(m_length);
+        }
+    }
 
-        m_data = newData;
+    template<typename T, typename Alloc>
+    template<typename... Args>
+    T& Vector<T, Alloc>::emplace_back(Args&&... args)
+    {
+        if(m_length < m_capacity)
+        {
+            construct(m_data + m_length, std::forward<Args>(args)...);
+            ++m_length;
+            return m_data[m_length - 1];
+        }
 
-        m_length = length;
+        // Full. args may refer to our elements, so the new element is built
+        // in the new storage before they move there.
+        const int capacity{std::max(m_length + 1, 2 * m_capacity)};
+        T* newData{allocate(capacity)};
+        try
+        {
+            construct(newData + m_length, std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            deallocate(newData, capacity);
+            throw;
+        }
+
+        try
+        {
+            relocate(m_data, m_length, newData);
+        }
+        catch(...)
+        {
+            destroy(newData + m_length, newData + m_length + 1);
+            deallocate(newData, capacity);
+            throw;
+        }
+
+        destroy(m_data, m_data + m_length);
+        releaseStorage();
+
+        m_data = newData;
+        m_capacity = capacity;
+        ++m_length;
+        return m_data[m_length - 1];
     }
 
-    template<typename T>
-    void Vector<T>::insertBefore(T value, int index)
+    template<typename T, typename Alloc>
+    template<typename... Args>
+    T& Vector<T, Alloc>::emplace(int index, Args&&... args)
     {
         if(index < 0 || index > m_length)
         {
             throw std::runtime_error("Infilled index");
         }
 
-        T* newData = new T[(unsigned long)(m_length+1)];
+        if(index == m_length)
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
 
-        for(int before{0}; before < index; ++before)
+        // args may refer to our elements, build it before they move.
+        T element(std::forward<Args>(args)...);
+
+        if(m_length == m_capacity)
         {
-            newData[before] = m_data[before];
+            grow(m_length + 1);
         }
 
-        newData[index] = value;
+        // Shift the tail up by one in place, the last element moves into
+        // raw memory.
+        if constexpr(isTrivial)
+        {
+            std::memmove(m_data + index + 1, m_data + index, sizeof(T) * static_cast<std::size_t>(m_length - index));
+            construct(m_data + index, std::move(element));
+        }
+        else
+        {
+            construct(m_data + m_length, std::move(m_data[m_length - 1]));
+            std::move_backward(m_data + index, m_data + m_length - 1, m_data + m_length);
+            m_data[index] = std::move(element);
+        }
+        ++m_length;
+        return m_data[index];
+    }
 
-        for(int after{index}; after < m_length; ++after)
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::pop_back(void)
+    {
+        if(m_length == 0)
         {
-            newData[after + 1] = m_data[after];
+            throw std::runtime_error("The vector is empty!");
         }
 
-        delete[] m_data;
+        --m_length;
+        destroy(m_data + m_length, m_data + m_length + 1);
+    }
 
-        m_data = newData;
-        ++m_length;
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::remove(int index)
+    {
+        if(index < 0 || index >= m_length)
+        {
+            throw std::runtime_error("Infilled index");
+        }
+
+        erase(index, index + 1);
     }
 
-    template<typename T>
-    void Vector<T>::remove(int index)
+    template<typename T, typename Alloc>
+    template<typename It>
+    void Vector<T, Alloc>::insert(int index, It first, It last)
     {
         if(index < 0 || index > m_length)
         {
             throw std::runtime_error("Infilled index");
         }
 
-        if(m_length == 1)
+        // Single pass, the length isn't known up front.
+        if constexpr(!std::forward_iterator<It>)
         {
-            erase();
+            for(; first != last; ++first, ++index)
+            {
+                emplace(index, *first);
+            }
             return;
         }
+        else
+        {
+            const int count{static_cast<int>(std::distance(first, last))};
+            if(count == 0)
+            {
+                return;
+            }
+
+            // 1. No room: build the new storage around the new elements.
+            if(m_length + count > m_capacity)
+            {
+                const int capacity{std::max(m_length + count, 2 * m_capacity)};
+                T* newData{allocate(capacity)};
+                int built{0};
+                try
+                {
+                    constructEach(newData + index, count, [this, &first](T* at, int){construct(at, *first); ++first;});
+                    built = count;
+                    relocate(m_data, index, newData);
+                    built += index;
+                    relocate(m_data + index, m_length - index, newData + index + count);
+                }
+                catch(...)
+                {
+                    destroy(newData + index + count - built, newData + index + count);
+                    deallocate(newData, capacity);
+                    throw;
+                }
+
+                destroy(m_data, m_data + m_length);
+                releaseStorage();
+
+                m_data = newData;
+                m_capacity = capacity;
+                m_length += count;
+                return;
+            }
 
-        T* newData = new T[(unsigned long)(m_length -1)];
+            // 2. Room: shift the tail up by count in place.
+            const int tail{m_length - index};
+            if constexpr(isTrivial)
+            {
+                std::memmove(m_data + index + count, m_data + index, sizeof(T) * static_cast<std::size_t>(tail));
+                for(T* at{m_data + index}; first != last; ++first, ++at)
+                {
+                    construct(at, *first);
+                }
+                m_length += count;
+            }
+            else if(tail > count)
+            {
+                // The end of the tail moves into raw memory, the rest is
+                // assigned over.
+                const int length{m_length};
+                constructEach(m_data + length, count, [this, length, count](T* at, int i)
+                {
+                    construct(at, std::move(m_data[length - count + i]));
+                });
+                m_length += count;
+                std::move_backward(m_data + index, m_data + length - count, m_data + length);
+                std::copy(first, last, m_data + index);
+            }
+            else
+            {
+                // The new elements past the old end and then the whole tail
+                // go into raw memory, the rest of the new ones over the tail.
+                const int length{m_length};
+                It middle{std::next(first, tail)};
+                constructEach(m_data + length, count - tail, [this, &middle](T* at, int){construct(at, *middle); ++middle;});
+                m_length += count - tail;
+                constructEach(m_data + index + count, tail, [this, index](T* at, int i)
+                {
+                    construct(at, std::move(m_data[index + i]));
+                });
+                m_length += tail;
+                std::copy_n(first, tail, m_data + index);
+            }
+        }
+    }
 
-        for(int before{0}; before < index; ++before)
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::erase(int first, int last)
+    {
+        if(first < 0 || first > last || last > m_length)
         {
-            newData[before] = m_data[before];
+            throw std::runtime_error("Infilled index");
         }
 
+        // Shift the tail down in place.
+        if constexpr(isTrivial)
+        {
+            if(m_length - last > 0)
+            {
+                std::memmove(m_data + first, m_data + last, sizeof(T) * static_cast<std::size_t>(m_length - last));
+            }
+        }
+        else
+        {
+            std::move(m_data + last, m_data + m_length, m_data + first);
+            destroy(m_data + m_length - (last - first), m_data + m_length);
+        }
+        m_length -= last - first;
+    }
 
-        for(int after{index + 1}; after< m_length; ++after)
+    template<typename T, typename Alloc>
+    template<typename Pred>
+    int Vector<T, Alloc>::erase_if(Pred pred)
+    {
+        // pred is called once per element, in order, like std::remove_if.
+        T* const end{m_data + m_length};
+        T* write{m_data};
+        while(write != end && !pred(*write))
+        {
+            ++write;
+        }
+        if(write == end)
         {
-            newData[after - 1] = m_data[after];
+            return 0;
         }
 
-        delete[] m_data;
+        if constexpr(isTrivial)
+        {
+            // Move each run of kept elements down with one memmove, when
+            // the run ends.
+            T* run{write + 1};
+            for(T* read{write + 1}; read != end; ++read)
+            {
+                if(pred(*read))
+                {
+                    const std::size_t runLength{static_cast<std::size_t>(read - run)};
+                    if(runLength > 0)
+                    {
+                        std::memmove(write, run, sizeof(T) * runLength);
+                        write += runLength;
+                    }
+                    run = read + 1;
+                }
+            }
+            const std::size_t runLength{static_cast<std::size_t>(end - run)};
+            if(runLength > 0)
+            {
+                std::memmove(write, run, sizeof(T) * runLength);
+                write += runLength;
+            }
+        }
+        else
+        {
+            for(T* read{write + 1}; read != end; ++read)
+            {
+                if(!pred(*read))
+                {
+                    *write = std::move(*read);
+                    ++write;
+                }
+            }
+        }
+
+        const int removed{static_cast<int>(end - write)};
+        destroy(write, end);
+        m_length -= removed;
+        return removed;
+    }
+
+    template<typename T, typename Alloc>
+    T* Vector<T, Alloc>::allocate(int capacity)
+    {
+        return Traits::allocate(m_allocator, static_cast<std::size_t>(capacity));
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::deallocate(T* data, int capacity)
+    {
+        if(data != nullptr)
+        {
+            Traits::deallocate(m_allocator, data, static_cast<std::size_t>(capacity));
+        }
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::releaseStorage(void)
+    {
+        if(!isInline())
+        {
+            deallocate(m_data, m_capacity);
+        }
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::takeFrom(Vector& vector)
+    {
+        if(!vector.isInline() && m_allocator == vector.m_allocator)
+        {
+            m_data = std::exchange(vector.m_data, vector.m_inlineData);
+            m_length = std::exchange(vector.m_length, 0);
+            m_capacity = std::exchange(vector.m_capacity, vector.m_inlineCapacity);
+            return;
+        }
+
+        reserve(vector.m_length);
+        relocate(vector.m_data, vector.m_length, m_data);
+        m_length = vector.m_length;
+        vector.erase();
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::destroy(T* first, T* last)
+    {
+        if constexpr(!std::is_trivially_destructible_v<T>)
+        {
+            for(; first != last; ++first)
+            {
+                Traits::destroy(m_allocator, first);
+            }
+        }
+    }
+
+    template<typename T, typename Alloc>
+    template<typename Make>
+    void Vector<T, Alloc>::constructEach(T* destination, int count, Make make)
+    {
+        int counter{0};
+        try
+        {
+            for(; counter < count; ++counter)
+            {
+                make(destination + counter, counter);
+            }
+        }
+        catch(...)
+        {
+            destroy(destination, destination + counter);
+            throw;
+        }
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::reallocateStorage(int capacity)
+    {
+        const bool toInline{capacity <= m_inlineCapacity};
+        if(toInline)
+        {
+            capacity = m_inlineCapacity;
+        }
+        T* newData{toInline ? m_inlineData : allocate(capacity)};
+
+        try
+        {
+            relocate(m_data, m_length, newData);
+        }
+        catch(...)
+        {
+            if(!toInline)
+            {
+                deallocate(newData, capacity);
+            }
+            throw;
+        }
+
+        destroy(m_data, m_data + m_length);
+        releaseStorage();
 
         m_data = newData;
-        --m_length;
+        m_capacity = capacity;
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::relocate(T* source, int count, T* destination)
+    {
+        if constexpr(isTrivial)
+        {
+            if(count > 0)
+            {
+                std::memcpy(destination, source, sizeof(T) * static_cast<std::size_t>(count));
+            }
+        }
+        else
+        {
+            constructEach(destination, count, [this, source](T* at, int index)
+            {
+                construct(at, std::move_if_noexcept(source[index]));
+            });
+        }
     }
 
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::grow(int length)
+    {
+        reallocateStorage(std::max(length, 2 * m_capacity));
+    }
+
+    template<typename T, typename Alloc>
+    void Vector<T, Alloc>::assign(const T* source, int count)
+    {
+        if(count > m_capacity)
+        {
+            // Nothing to reuse, copy straight into new storage.
+            T* newData{allocate(count)};
+            try
+            {
+                constructEach(newData, count, [this, source](T* at, int index){construct(at, source[index]);});
+            }
+            catch(...)
+            {
+                deallocate(newData, count);
+                throw;
+            }
+
+            erase();
+            m_data = newData;
+            m_capacity = count;
+            m_length = count;
+            return;
+        }
+
+        if constexpr(isTrivial)
+        {
+            if(count > 0)
+            {
+                std::memcpy(m_data, source, sizeof(T) * static_cast<std::size_t>(count));
+            }
+        }
+        else
+        {
+            // Assign over the elements there are, construct or destroy the
+            // rest.
+            const int common{std::min(count, m_length)};
+            std::copy_n(source, common, m_data);
+            if(count > m_length)
+            {
+                constructEach(m_data + common, count - common, [this, source, common](T* at, int index)
+                {
+                    construct(at, source[common + index]);
+                });
+            }
+            else
+            {
+                destroy(m_data + count, m_data + m_length);
+            }
+        }
+        m_length = count;
+    }
+
+    namespace pmr
+    {
+        // Vector taking its memory from a std::pmr::memory_resource.
+        template<typename T>
+        using Vector = Container::Vector<T, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 #endif
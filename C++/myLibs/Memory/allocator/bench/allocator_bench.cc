@@ -0,0 +1,175 @@
+// Churns memory on several threads at once, from the global heap and from
+// per-thread arenas and pools, and reports the throughput of each.
+//
+// frame vectors: each frame builds a few dozen Container::Vector of random
+// length and drops them all, from the heap or from an arena reset per frame.
+// fixed churn: frees a random one of a set of live 64 byte blocks and
+// allocates a new one, from the heap or from a pool.
+//
+// Usage: allocator_bench [frames per thread]
+
+#include "arena_resource.h"
+#include "pool_resource.h"
+#include "vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int VECTORS_PER_FRAME = 32;
+    const int MAX_VECTOR_LENGTH = 256;
+    const std::size_t BLOCK_SIZE = 64;
+    const std::size_t LIVE_BLOCKS = 1024;
+    const int CHURN_PER_FRAME = 4096;
+
+    long HeapFrames(int frames, unsigned int seed)
+    {
+        std::mt19937 random{seed};
+        std::uniform_int_distribution<int> length(1, MAX_VECTOR_LENGTH);
+        long total = 0;
+
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            Container::Vector<Container::Vector<int>> vectors;
+            for (int v = 0; v < VECTORS_PER_FRAME; ++v)
+            {
+                Container::Vector<int>& vector = vectors.emplace_back();
+                const int n = length(random);
+                for (int i = 0; i < n; ++i)
+                {
+                    vector.push_back(i);
+                }
+                total += vector.getLength();
+            }
+        }
+        return total;
+    }
+
+    long ArenaFrames(int frames, unsigned int seed)
+    {
+        std::mt19937 random{seed};
+        std::uniform_int_distribution<int> length(1, MAX_VECTOR_LENGTH);
+        Memory::ArenaResource arena;
+        long total = 0;
+
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            {
+                // The outer vector hands the arena on to the vectors it holds.
+                Container::pmr::Vector<Container::pmr::Vector<int>> vectors{&arena};
+                for (int v = 0; v < VECTORS_PER_FRAME; ++v)
+                {
+                    Container::pmr::Vector<int>& vector = vectors.emplace_back();
+                    const int n = length(random);
+                    for (int i = 0; i < n; ++i)
+                    {
+                        vector.push_back(i);
+                    }
+                    total += vector.getLength();
+                }
+            }
+            arena.reset();
+        }
+        return total;
+    }
+
+    long Churn(int frames, unsigned int seed, std::pmr::memory_resource* resource)
+    {
+        std::mt19937 random{seed};
+        std::uniform_int_distribution<std::size_t> pick(0, LIVE_BLOCKS - 1);
+        std::vector<void*> live(LIVE_BLOCKS);
+        long total = 0;
+
+        for (void*& block : live)
+        {
+            block = resource->allocate(BLOCK_SIZE);
+        }
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            for (int i = 0; i < CHURN_PER_FRAME; ++i)
+            {
+                void*& block = live[pick(random)];
+                resource->deallocate(block, BLOCK_SIZE);
+                block = resource->allocate(BLOCK_SIZE);
+                *static_cast<char*>(block) = 1;
+                ++total;
+            }
+        }
+        for (void* block : live)
+        {
+            resource->deallocate(block, BLOCK_SIZE);
+        }
+        return total;
+    }
+
+    long HeapChurn(int frames, unsigned int seed)
+    {
+        return Churn(frames, seed, std::pmr::new_delete_resource());
+    }
+
+    long PoolChurn(int frames, unsigned int seed)
+    {
+        Memory::PoolResource pool{BLOCK_SIZE};
+        return Churn(frames, seed, &pool);
+    }
+
+    // Runs work on each of threads threads at once, returns the operations
+    // per second over all of them.
+    double Run(int threads, int frames, long (*work)(int, unsigned int))
+    {
+        std::vector<long> totals(static_cast<std::size_t>(threads));
+        std::vector<std::thread> workers;
+
+        const Clock::time_point start = Clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&totals, t, frames, work]()
+            {
+                totals[static_cast<std::size_t>(t)] = work(frames, static_cast<unsigned int>(t + 1));
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        long total = 0;
+        for (const long t : totals)
+        {
+            total += t;
+        }
+        return static_cast<double>(total) / seconds;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::stoi(argv[1]) : 2000;
+    // At least 4, to see contention even on small machines.
+    const int most = static_cast<int>(std::max(4u, std::thread::hardware_concurrency()));
+
+    std::printf("%-14s %8s %16s %16s %8s\n", "workload", "threads", "heap Mops/s", "resource Mops/s", "speedup");
+    for (int threads = 1; threads <= most; threads *= 2)
+    {
+        const double heap = Run(threads, frames, HeapFrames);
+        const double arena = Run(threads, frames, ArenaFrames);
+        std::printf("%-14s %8d %16.1f %16.1f %7.2fx\n", "frame vectors", threads, heap / 1e6, arena / 1e6, arena / heap);
+    }
+    for (int threads = 1; threads <= most; threads *= 2)
+    {
+        const double heap = Run(threads, frames, HeapChurn);
+        const double pool = Run(threads, frames, PoolChurn);
+        std::printf("%-14s %8d %16.1f %16.1f %7.2fx\n", "fixed churn", threads, heap / 1e6, pool / 1e6, pool / heap);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#ifndef ARENA_RESOURCE_H
+#define ARENA_RESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace Memory
+{
+    // Bump allocator: hands out memory by advancing an offset, frees nothing
+    // until reset, which takes every allocation back at once in O(1).
+    //
+    // Meant for short lived data, like the vectors built while handling one
+    // frame. Memory comes from upstream in blocks, a new block twice the size
+    // of the last one when the current is full. reset() keeps the blocks for
+    // reuse, they go back upstream on destruction.
+    //
+    // Not synchronized, use one arena per thread.
+    class ArenaResource : public std::pmr::memory_resource
+    {
+    public: // Public methods
+        explicit ArenaResource(std::size_t blockSize = 64 * 1024,
+                               std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        ~ArenaResource() override;
+
+        ArenaResource(const ArenaResource&) = delete;
+        ArenaResource& operator=(const ArenaResource&) = delete;
+
+        // Takes back every allocation. Whatever was built in the arena must
+        // not be used afterwards, and is not destroyed.
+        void reset();
+
+        // Bytes handed out since the last reset, alignment padding included.
+        std::size_t getUsed() const { return m_used; }
+        // Bytes taken from upstream.
+        std::size_t getReserved() const { return m_reserved; }
+        std::size_t getBlockCount() const { return m_blocks.size(); }
+
+    private: // Private types
+        struct Block
+        {
+            std::byte* m_data;
+            std::size_t m_size;
+        };
+
+    private: // Private methods
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        // Does nothing, memory is taken back by reset.
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        // Carves bytes out of the current block, nullptr if they don't fit.
+        void* tryAllocate(std::size_t bytes, std::size_t alignment);
+
+    private: // Private variables
+        std::pmr::memory_resource* m_upstream;
+        std::size_t m_blockSize;
+
+        std::vector<Block> m_blocks{};
+        // Block being carved up, and how much of it is used.
+        std::size_t m_current{0};
+        std::size_t m_offset{0};
+
+        std::size_t m_used{0};
+        std::size_t m_reserved{0};
+    };
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef POOL_RESOURCE_H
+#define POOL_RESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace Memory
+{
+    // Fixed size allocator: every allocation is one slot of the same size,
+    // freed slots go on a free list and are handed out again first, so
+    // allocating and freeing are a few instructions each.
+    //
+    // Slots come from upstream a chunk at a time. Requests bigger than a
+    // slot, or aligned more strictly, are passed upstream.
+    //
+    // Not synchronized, use one pool per thread.
+    class PoolResource : public std::pmr::memory_resource
+    {
+    public: // Public methods
+        explicit PoolResource(std::size_t slotSize,
+                              std::size_t slotsPerChunk = 256,
+                              std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        ~PoolResource() override;
+
+        PoolResource(const PoolResource&) = delete;
+        PoolResource& operator=(const PoolResource&) = delete;
+
+        std::size_t getSlotSize() const { return m_slotSize; }
+
+        // Slots handed out and not freed yet.
+        std::size_t getInUse() const { return m_inUse; }
+        std::size_t getChunkCount() const { return m_chunks.size(); }
+        // Requests that didn't fit a slot and went upstream.
+        std::size_t getUpstreamCount() const { return m_upstreamCount; }
+
+    private: // Private types
+        // A free slot holds the link to the next.
+        struct FreeSlot
+        {
+            FreeSlot* m_next;
+        };
+
+    private: // Private methods
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        bool fits(std::size_t bytes, std::size_t alignment) const;
+
+        // Takes a chunk from upstream and puts its slots on the free list.
+        void addChunk();
+
+    private: // Private variables
+        std::pmr::memory_resource* m_upstream;
+        std::size_t m_slotSize;
+        // Alignment every slot has: the largest power of two the slot size
+        // is a multiple of, up to what upstream guarantees for the chunk.
+        std::size_t m_slotAlignment;
+        std::size_t m_slotsPerChunk;
+
+        std::vector<void*> m_chunks{};
+        FreeSlot* m_free{nullptr};
+
+        std::size_t m_inUse{0};
+        std::size_t m_upstreamCount{0};
+    };
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "arena_resource.h"
+#include <algorithm>
+#include <cstdint>
+
+
+namespace Memory
+{
+    ArenaResource::ArenaResource(std::size_t blockSize, std::pmr::memory_resource* upstream)
+        : m_upstream{upstream},
+          m_blockSize{std::max<std::size_t>(blockSize, 64)}
+    {
+
+    }
+
+    ArenaResource::~ArenaResource()
+    {
+        for (const Block& block : m_blocks)
+        {
+            m_upstream->deallocate(block.m_data, block.m_size, alignof(std::max_align_t));
+        }
+    }
+
+    void ArenaResource::reset()
+    {
+        m_current = 0;
+        m_offset = 0;
+        m_used = 0;
+    }
+
+    void* ArenaResource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        // 1. The current block, then those kept from before the last reset.
+        for (; m_current < m_blocks.size(); ++m_current, m_offset = 0)
+        {
+            if (void* p = tryAllocate(bytes, alignment))
+            {
+                return p;
+            }
+        }
+
+        // 2. A new block, big enough for the request even if it's huge.
+        const std::size_t previous = m_blocks.empty() ? m_blockSize / 2 : m_blocks.back().m_size;
+        const std::size_t size = std::max(previous * 2, bytes + alignment);
+        m_blocks.push_back({static_cast<std::byte*>(m_upstream->allocate(size, alignof(std::max_align_t))), size});
+        m_reserved += size;
+        m_current = m_blocks.size() - 1;
+        m_offset = 0;
+        return tryAllocate(bytes, alignment);
+    }
+
+    void ArenaResource::do_deallocate(void*, std::size_t, std::size_t)
+    {
+
+    }
+
+    bool ArenaResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    void* ArenaResource::tryAllocate(std::size_t bytes, std::size_t alignment)
+    {
+        const Block& block = m_blocks[m_current];
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block.m_data) + m_offset;
+        const std::size_t padding = (alignment - address % alignment) % alignment;
+        if (padding + bytes > block.m_size - m_offset)
+        {
+            return nullptr;
+        }
+
+        void* p = block.m_data + m_offset + padding;
+        m_offset += padding + bytes;
+        m_used += padding + bytes;
+        return p;
+    }
+}
@@ -0,0 +1,85 @@
+#include "pool_resource.h"
+#include <algorithm>
+#include <new>
+
+
+namespace Memory
+{
+    namespace
+    {
+        std::size_t roundUp(std::size_t value, std::size_t multiple)
+        {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+    }
+
+    PoolResource::PoolResource(std::size_t slotSize, std::size_t slotsPerChunk, std::pmr::memory_resource* upstream)
+        : m_upstream{upstream},
+          m_slotSize{roundUp(std::max(slotSize, sizeof(FreeSlot)), alignof(FreeSlot))},
+          m_slotAlignment{std::min(m_slotSize & (~m_slotSize + 1), alignof(std::max_align_t))},
+          m_slotsPerChunk{std::max<std::size_t>(slotsPerChunk, 1)}
+    {
+
+    }
+
+    PoolResource::~PoolResource()
+    {
+        for (void* chunk : m_chunks)
+        {
+            m_upstream->deallocate(chunk, m_slotSize * m_slotsPerChunk, alignof(std::max_align_t));
+        }
+    }
+
+    void* PoolResource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!fits(bytes, alignment))
+        {
+            ++m_upstreamCount;
+            return m_upstream->allocate(bytes, alignment);
+        }
+
+        if (m_free == nullptr)
+        {
+            addChunk();
+        }
+
+        FreeSlot* slot = m_free;
+        m_free = slot->m_next;
+        ++m_inUse;
+        return slot;
+    }
+
+    void PoolResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+    {
+        if (!fits(bytes, alignment))
+        {
+            m_upstream->deallocate(p, bytes, alignment);
+            return;
+        }
+
+        m_free = ::new (p) FreeSlot{m_free};
+        --m_inUse;
+    }
+
+    bool PoolResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    bool PoolResource::fits(std::size_t bytes, std::size_t alignment) const
+    {
+        return bytes <= m_slotSize && alignment <= m_slotAlignment;
+    }
+
+    void PoolResource::addChunk()
+    {
+        std::byte* chunk = static_cast<std::byte*>(m_upstream->allocate(m_slotSize * m_slotsPerChunk, alignof(std::max_align_t)));
+        m_chunks.push_back(chunk);
+
+        // Linked back to front, so slots are handed out in address order.
+        for (std::size_t i = m_slotsPerChunk; i > 0; --i)
+        {
+            m_free = ::new (chunk + (i - 1) * m_slotSize) FreeSlot{m_free};
+        }
+    }
+}
@@ -0,0 +1,325 @@
+// Replays synthetic events through the window manager's handlers against the
+// in-memory FakeBackend and reports the cost per event. Blocking round trips
+// are audited against per-handler budgets, the run fails if a handler goes
+// over its budget.
+//
+// Usage: handler_bench [events per scenario]
+
+#include "auditing_backend.h"
+#include "fake_backend.h"
+#include "window_manager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace
+{
+    // Most blocking round trips a single call of each handler, or step of
+    // Start, may make. A phase not listed may make none. Raise one only with
+    // a reason.
+    const std::pair<const char*, std::size_t> ROUND_TRIP_BUDGETS[] = {
+        // The atoms interned by the constructor.
+        {"Init", 7},
+        // The whole of Start, and each existing window framed.
+        {"Start.RedirectRoot", 1},
+        {"Start.Outputs", 1},
+        {"Start.QueryTree", 1},
+        {"Start.Frame", 2},
+        // Attributes, then every cached property in one batch.
+        {"OnMapRequest", 2},
+        // The XInput2 grab.
+        {"OnButtonPress", 1},
+        // Keyboard grab and output size when the switcher opens.
+        {"OnKeyPress", 2},
+        // The properties changed in a run of events, in one batch.
+        {"RefreshProperties", 1},
+        // Nothing on the paths taken per motion, configure or redraw.
+        {"OnMotionNotify", 0},
+        {"OnPointerEvent", 0},
+        {"OnButtonRelease", 0},
+        {"OnConfigureRequest", 0},
+        {"OnConfigureNotify", 0},
+        {"OnCreateNotify", 0},
+        {"OnReparentNotify", 0},
+        {"OnMapNotify", 0},
+        {"OnUnmapNotify", 0},
+        {"OnDestroyNotify", 0},
+        {"OnExpose", 0},
+        {"OnEnterNotify", 0},
+        {"OnPropertyNotify", 0},
+        {"OnKeyRelease", 0},
+        {"DeliverMotion", 0},
+        {"DeliverConfigures", 0},
+        {"DeliverFocus", 0},
+    };
+
+    struct Bench
+    {
+        WM::FakeBackend* m_fake;
+        WM::AuditingBackend* m_audit;
+        std::unique_ptr<WM::WindowManager> m_wm;
+        std::vector<Window> m_clients;
+        // Events dispatched to WindowManager::HandleEvent.
+        std::size_t m_events;
+        // Windows mapped and destroyed again, for the scenarios that do.
+        std::size_t m_cycles;
+    };
+
+    // Dispatches everything the fake server has queued, including the events
+    // the handlers themselves caused.
+    void Drain(Bench& bench)
+    {
+        XEvent e;
+        while (bench.m_fake->Pending())
+        {
+            bench.m_fake->NextEvent(e);
+            bench.m_wm->HandleEvent(e);
+            ++bench.m_events;
+        }
+    }
+
+    Window MapClient(Bench& bench, int x, int y)
+    {
+        const Window w = bench.m_fake->ClientCreateWindow(x, y, 640, 480);
+        bench.m_fake->ClientMapWindow(w);
+        Drain(bench);
+        return w;
+    }
+
+    // A window manager managing a number of mapped clients.
+    Bench MakeBench(std::size_t num_clients)
+    {
+        auto fake = std::make_unique<WM::FakeBackend>();
+        WM::FakeBackend* fake_ptr = fake.get();
+        auto audit = std::make_unique<WM::AuditingBackend>(std::move(fake));
+        for (const auto& [phase, budget] : ROUND_TRIP_BUDGETS)
+        {
+            audit->SetBudget(phase, budget);
+        }
+        Bench bench{fake_ptr, audit.get(), nullptr, {}, 0, 0};
+        bench.m_wm = std::make_unique<WM::WindowManager>(std::move(audit));
+        bench.m_wm->Start();
+
+        for (std::size_t i = 0; i < num_clients; ++i)
+        {
+            const int offset = static_cast<int>(i % 64) * 10;
+            bench.m_clients.push_back(MapClient(bench, offset, offset));
+        }
+        Drain(bench);
+        bench.m_events = 0;
+        return bench;
+    }
+
+    XEvent MakeButtonEvent(int type, Window w, unsigned int button, int x, int y)
+    {
+        XEvent e;
+        std::memset(&e, 0, sizeof(e));
+        e.xbutton.type = type;
+        e.xbutton.window = w;
+        e.xbutton.button = button;
+        e.xbutton.state = Mod1Mask;
+        e.xbutton.x_root = x;
+        e.xbutton.y_root = y;
+        return e;
+    }
+
+    XEvent MakeMotionEvent(Window w, unsigned int state, int x, int y)
+    {
+        XEvent e;
+        std::memset(&e, 0, sizeof(e));
+        e.xmotion.type = MotionNotify;
+        e.xmotion.window = w;
+        e.xmotion.state = Mod1Mask | state;
+        e.xmotion.x_root = x;
+        e.xmotion.y_root = y;
+        return e;
+    }
+
+    // A window dragged around with the pointer, one motion event at a time
+    // so none get compressed.
+    void Drag(Bench& bench, std::size_t num_events, unsigned int button, unsigned int state)
+    {
+        std::size_t sent = 0;
+        for (std::size_t i = 0; sent < num_events; ++i)
+        {
+            const Window w = bench.m_clients[i % bench.m_clients.size()];
+            bench.m_fake->QueueEvent(MakeButtonEvent(ButtonPress, w, button, 100, 100));
+            Drain(bench);
+
+            for (int step = 0; step < 1000 && sent < num_events; ++step, ++sent)
+            {
+                bench.m_fake->QueueEvent(MakeMotionEvent(w, state, 100 + step % 200, 100 + step % 150));
+                Drain(bench);
+            }
+
+            bench.m_fake->QueueEvent(MakeButtonEvent(ButtonRelease, w, button, 100, 100));
+            Drain(bench);
+        }
+    }
+
+    // The same with XInput2 motion from a 1000 Hz mouse: sub-pixel samples
+    // 1 ms apart, each handled as it arrives.
+    void DragXI2(Bench& bench, std::size_t num_events)
+    {
+        std::size_t sent = 0;
+        Time time = 0;
+        for (std::size_t i = 0; sent < num_events; ++i)
+        {
+            const Window w = bench.m_clients[i % bench.m_clients.size()];
+            bench.m_fake->QueueEvent(MakeButtonEvent(ButtonPress, w, Button1, 100, 100));
+            Drain(bench);
+
+            WM::PointerEvent pointer;
+            pointer.m_type = XI_Motion;
+            pointer.m_device = 2;
+            pointer.m_window = w;
+            pointer.m_state = Mod1Mask | Button1Mask;
+            for (int step = 0; step < 1000 && sent < num_events; ++step, ++sent)
+            {
+                pointer.m_rootX = 100.0 + (step % 200) * 0.75;
+                pointer.m_rootY = 100.0 + (step % 150) * 0.5;
+                pointer.m_time = ++time;
+                bench.m_fake->QueuePointerEvent(pointer);
+                Drain(bench);
+            }
+
+            pointer.m_type = XI_ButtonRelease;
+            pointer.m_button = Button1;
+            pointer.m_time = ++time;
+            bench.m_fake->QueuePointerEvent(pointer);
+            Drain(bench);
+        }
+    }
+
+    void Configure(Bench& bench, std::size_t num_events)
+    {
+        std::mt19937 random{42};
+        std::uniform_int_distribution<int> position{0, 1000};
+        std::uniform_int_distribution<int> size{50, 800};
+
+        for (std::size_t i = 0; i < num_events; ++i)
+        {
+            XWindowChanges changes;
+            std::memset(&changes, 0, sizeof(changes));
+            changes.x = position(random);
+            changes.y = position(random);
+            changes.width = size(random);
+            changes.height = size(random);
+
+            bench.m_fake->ClientConfigureWindow(bench.m_clients[i % bench.m_clients.size()],
+                                                CWX | CWY | CWWidth | CWHeight, changes);
+            Drain(bench);
+        }
+    }
+
+    // Windows opened and closed again: Frame and Unframe.
+    void MapUnmap(Bench& bench, std::size_t num_events)
+    {
+        const std::size_t start = bench.m_events;
+        while (bench.m_events - start < num_events)
+        {
+            const Window w = MapClient(bench, 10, 10);
+            bench.m_fake->ClientUnmapWindow(w);
+            Drain(bench);
+            bench.m_fake->ClientDestroyWindow(w);
+            Drain(bench);
+            ++bench.m_cycles;
+        }
+    }
+
+    // Points the window managers created from now on at a config file with
+    // this text.
+    void UseConfig(const std::string& text)
+    {
+        char dir[] = "/tmp/handler_bench.XXXXXX";
+        if (mkdtemp(dir) == nullptr || mkdir((std::string{dir} + "/wm").c_str(), 0700) != 0)
+        {
+            std::perror("handler_bench: config directory");
+            std::exit(1);
+        }
+        std::ofstream{std::string{dir} + "/wm/config"} << text;
+        setenv("XDG_CONFIG_HOME", dir, 1);
+    }
+
+    // Whether every scenario kept to the round trip budgets.
+    bool g_withinBudgets = true;
+
+    void Run(const char* name, std::size_t num_clients, const std::function<void(Bench&)>& scenario)
+    {
+        Bench bench = MakeBench(num_clients);
+        const std::size_t requests_before = bench.m_fake->GetRequestCount();
+        // Server-side windows with every client managed.
+        const std::size_t num_windows = bench.m_fake->GetWindowCount();
+
+        const auto start = std::chrono::steady_clock::now();
+        scenario(bench);
+        const auto end = std::chrono::steady_clock::now();
+
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        const double events = static_cast<double>(bench.m_events);
+        const double requests = static_cast<double>(bench.m_fake->GetRequestCount() - requests_before);
+        std::printf("%-20s %10zu events %10.1f ns/event %6.2f requests/event %5zu windows\n",
+                    name, bench.m_events, ns / events, requests / events, num_windows);
+
+        // Modes differ in how many events a window causes, compare them per
+        // window.
+        if (bench.m_cycles > 0)
+        {
+            const double cycles = static_cast<double>(bench.m_cycles);
+            std::printf("%-20s %10zu cycles %10.1f ns/cycle %6.2f requests/cycle %5.2f events/cycle\n",
+                        "", bench.m_cycles, ns / cycles, requests / cycles, events / cycles);
+        }
+
+        const std::vector<WM::AuditingBackend::Violation> violations = bench.m_audit->GetViolations();
+        for (const WM::AuditingBackend::Violation& violation : violations)
+        {
+            std::printf("  over budget: %s made %zu round trips, budget %zu\n",
+                        violation.m_phase.c_str(), violation.m_maxRoundTrips, violation.m_budget);
+        }
+        if (!violations.empty())
+        {
+            bench.m_audit->PrintReport(std::clog);
+            g_withinBudgets = false;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_events = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    // Keep the user's configuration and rules out of the measurement.
+    setenv("XDG_CONFIG_HOME", "/nonexistent", 1);
+
+    // The handlers log every action, which would be the only thing measured.
+    std::cout.rdbuf(nullptr);
+    std::cerr.rdbuf(nullptr);
+
+    Run("move", 64, [num_events](Bench& bench) { Drag(bench, num_events, Button1, Button1Mask); });
+    Run("resize", 64, [num_events](Bench& bench) { Drag(bench, num_events, Button3, Button3Mask); });
+    Run("move xi2", 64, [num_events](Bench& bench) { DragXI2(bench, num_events); });
+    Run("configure", 64, [num_events](Bench& bench) { Configure(bench, num_events); });
+    Run("map/unmap", 64, [num_events](Bench& bench) { MapUnmap(bench, num_events); });
+
+    // Clients managed in place, without frame windows.
+    UseConfig("frame_mode = borderless\n");
+    Run("move borderless", 64, [num_events](Bench& bench) { Drag(bench, num_events, Button1, Button1Mask); });
+    Run("map/unmap borderless", 64, [num_events](Bench& bench) { MapUnmap(bench, num_events); });
+
+    return g_withinBudgets ? 0 : 1;
+}
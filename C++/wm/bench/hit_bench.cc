@@ -0,0 +1,101 @@
+// Measures finding the topmost frame under the pointer for growing window
+// counts, with the grid index and with a scan over every frame.
+//
+// Usage: hit_bench [queries per size]
+
+#include "hit_index.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Keeps the optimiser from dropping a result.
+    template <typename T>
+    void Consume(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // The last frame containing pos in raise order, as checking every frame
+    // would find it.
+    Window Scan(const WM::Placement& placement, const std::vector<Window>& raised, const Position<int>& pos)
+    {
+        for (auto i = raised.rbegin(); i != raised.rend(); ++i)
+        {
+            if (placement.GetRect(*i)->Contains(pos))
+            {
+                return *i;
+            }
+        }
+        return None;
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_queries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> position{0, 3600};
+    std::uniform_int_distribution<int> size{100, 1200};
+    std::uniform_int_distribution<int> pointer{0, 3839};
+
+    for (const std::size_t num_windows : {10u, 100u, 1000u, 10000u})
+    {
+        WM::Placement placement;
+        placement.SetOutputs({Rect<int>(0, 0, 3840, 2160)});
+        WM::HitIndex index;
+        std::vector<Window> raised;
+        for (std::size_t i = 0; i < num_windows; ++i)
+        {
+            const Window w = static_cast<Window>(i + 1);
+            placement.Add(w, Rect<int>(position(random), position(random) / 2, size(random), size(random)));
+            index.Raise(w);
+            raised.push_back(w);
+        }
+
+        std::vector<Position<int>> positions;
+        for (std::size_t i = 0; i < num_queries; ++i)
+        {
+            positions.emplace_back(pointer(random), pointer(random) * 9 / 16);
+        }
+
+        // 1. Rebuild, once per geometry change.
+        const auto build_start = std::chrono::steady_clock::now();
+        index.Update(placement);
+        const auto build_end = std::chrono::steady_clock::now();
+
+        // 2. Queries, checked against the scan.
+        std::size_t num_mismatches = 0;
+        const auto index_start = std::chrono::steady_clock::now();
+        for (const Position<int>& pos : positions)
+        {
+            const Window w = index.FindTopmost(pos);
+            Consume(w);
+        }
+        const auto index_end = std::chrono::steady_clock::now();
+        for (const Position<int>& pos : positions)
+        {
+            const Window w = Scan(placement, raised, pos);
+            num_mismatches += w != index.FindTopmost(pos);
+            Consume(w);
+        }
+        const auto scan_end = std::chrono::steady_clock::now();
+
+        std::printf("%6zu windows  rebuild %9.1f us  grid %7.1f ns/query  scan+check %9.1f ns/query  %zu mismatches\n",
+                    num_windows,
+                    std::chrono::duration<double, std::micro>(build_end - build_start).count(),
+                    std::chrono::duration<double, std::nano>(index_end - index_start).count() / static_cast<double>(num_queries),
+                    std::chrono::duration<double, std::nano>(scan_end - index_end).count() / static_cast<double>(num_queries),
+                    num_mismatches);
+    }
+
+    return 0;
+}
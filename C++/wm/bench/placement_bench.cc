@@ -0,0 +1,103 @@
+// Measures window placement with up to 1000 windows on two outputs: placing
+// and adding new windows, moving them and removing them again.
+//
+// Usage: placement_bench [windows]
+
+#include "placement.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct Timings
+    {
+        std::vector<double> m_us{};
+
+        template <typename Fn>
+        void Time(Fn fn)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const auto end = std::chrono::steady_clock::now();
+            m_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        void Report(const char* name)
+        {
+            std::sort(m_us.begin(), m_us.end());
+            double total = 0.0;
+            for (const double us : m_us)
+            {
+                total += us;
+            }
+            std::printf("%-14s %6zu ops  mean %8.2f us  p99 %8.2f us  max %8.2f us\n", name, m_us.size(),
+                        total / static_cast<double>(m_us.size()), m_us[m_us.size() * 99 / 100], m_us.back());
+        }
+    };
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_windows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+
+    WM::Placement placement;
+    placement.SetOutputs({Rect<int>(0, 0, 2560, 1440), Rect<int>(2560, 0, 1920, 1080)});
+
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> width{200, 1200};
+    std::uniform_int_distribution<int> height{150, 900};
+    std::uniform_int_distribution<int> x{0, 4000};
+    std::uniform_int_distribution<int> y{0, 1200};
+
+    // 1. Map windows one by one, each placed among the ones before.
+    Timings place;
+    std::vector<Window> windows;
+    for (std::size_t i = 0; i < num_windows; ++i)
+    {
+        const Window w = static_cast<Window>(i + 1);
+        const Size<int> size(width(random), height(random));
+        const Position<int> near(x(random), y(random));
+        place.Time([&]()
+        {
+            placement.Add(w, Rect<int>(placement.Place(size, near), size));
+        });
+        windows.push_back(w);
+    }
+    place.Report("place + map");
+    std::printf("%zu free rectangles\n", placement.GetFreeRectCount());
+
+    // 2. Move random windows.
+    Timings move;
+    for (std::size_t i = 0; i < num_windows; ++i)
+    {
+        const Window w = windows[static_cast<std::size_t>(random()) % windows.size()];
+        const Rect<int> rect(x(random), y(random), width(random), height(random));
+        move.Time([&]()
+        {
+            placement.Move(w, rect);
+        });
+    }
+    move.Report("move");
+
+    // 3. Unmap them all, in random order.
+    std::shuffle(windows.begin(), windows.end(), random);
+    Timings remove;
+    for (const Window w : windows)
+    {
+        remove.Time([&]()
+        {
+            placement.Remove(w);
+        });
+    }
+    remove.Report("unmap");
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+// Measures the batch rectangle kernels in util.h against plain loops over
+// Rect<int>, for a few window counts.
+//
+// Usage: rect_bench [queries per size]
+
+#include "util.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Keeps the optimiser from dropping a result.
+    template <typename T>
+    void Consume(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename Fn>
+    double NsPerRect(std::size_t num_queries, std::size_t num_rects, Fn fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t q = 0; q < num_queries; ++q)
+        {
+            fn(q);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count()
+            / static_cast<double>(num_queries * num_rects);
+    }
+
+    void Report(const char* name, std::size_t num_rects, double loop_ns, double batch_ns)
+    {
+        std::printf("%-10s %6zu rects  loop %6.3f ns/rect  batch %6.3f ns/rect  %5.1fx  %8.0f rects/ms\n",
+                    name, num_rects, loop_ns, batch_ns, loop_ns / batch_ns, 1e6 / batch_ns);
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_queries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const Rect<int> screen(0, 0, 3840, 2160);
+
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> position{-200, 3800};
+    std::uniform_int_distribution<int> size{50, 1200};
+
+    for (const std::size_t num_rects : {64u, 1000u, 10000u})
+    {
+        std::vector<Rect<int>> aos;
+        RectArray soa;
+        for (std::size_t i = 0; i < num_rects; ++i)
+        {
+            const Rect<int> r(position(random), position(random), size(random), size(random));
+            aos.push_back(r);
+            soa.Push(r);
+        }
+
+        std::vector<Rect<int>> queries;
+        for (std::size_t q = 0; q < 64; ++q)
+        {
+            queries.emplace_back(position(random), position(random), size(random), size(random));
+        }
+
+        // Intersection.
+        {
+            std::vector<Rect<int>> loop_out(num_rects);
+            RectArray batch_out;
+            const double loop_ns = NsPerRect(num_queries, num_rects, [&](std::size_t q)
+            {
+                const Rect<int>& r = queries[q % queries.size()];
+                for (std::size_t i = 0; i < num_rects; ++i)
+                {
+                    loop_out[i] = r & aos[i];
+                }
+                Consume(loop_out);
+            });
+            const double batch_ns = NsPerRect(num_queries, num_rects, [&](std::size_t q)
+            {
+                IntersectRects(queries[q % queries.size()], soa, batch_out);
+                Consume(batch_out);
+            });
+            for (std::size_t i = 0; i < num_rects; ++i)
+            {
+                if (!(batch_out.Get(i) == (queries[(num_queries - 1) % queries.size()] & aos[i])))
+                {
+                    std::fprintf(stderr, "IntersectRects mismatch at %zu\n", i);
+                    return 1;
+                }
+            }
+            Report("intersect", num_rects, loop_ns, batch_ns);
+        }
+
+        // Overlap test.
+        {
+            std::vector<std::uint32_t> indices(num_rects);
+            std::size_t loop_count = 0;
+            std::size_t batch_count = 0;
+            const double loop_ns = NsPerRect(num_queries, num_rects, [&](std::size_t q)
+            {
+                const Rect<int>& r = queries[q % queries.size()];
+                loop_count = 0;
+                for (std::size_t i = 0; i < num_rects; ++i)
+                {
+                    if (r.Intersects(aos[i]))
+                    {
+                        indices[loop_count++] = static_cast<std::uint32_t>(i);
+                    }
+                }
+                Consume(indices);
+            });
+            const double batch_ns = NsPerRect(num_queries, num_rects, [&](std::size_t q)
+            {
+                batch_count = FindIntersecting(queries[q % queries.size()], soa, indices.data());
+                Consume(indices);
+            });
+            if (loop_count != batch_count)
+            {
+                std::fprintf(stderr, "FindIntersecting mismatch: %zu != %zu\n", batch_count, loop_count);
+                return 1;
+            }
+            Report("overlap", num_rects, loop_ns, batch_ns);
+        }
+
+        // Overlap area.
+        {
+            std::int64_t loop_sum = 0;
+            std::int64_t batch_sum = 0;
+            const double loop_ns = NsPerRect(num_queries, num_rects, [&](std::size_t q)
+            {
+                const Rect<int>& r = queries[q % queries.size()];
+                loop_sum = 0;
+                for (std::size_t i = 0; i < num_rects; ++i)
+                {
+                    loop_sum += (r & aos[i]).GetArea();
+                }
+                Consume(loop_sum);
+            });
+            const double batch_ns = NsPerRect(num_queries, num_rects, [&](std::size_t q)
+            {
+                batch_sum = SumIntersectionAreas(queries[q % queries.size()], soa);
+                Consume(batch_sum);
+            });
+            if (loop_sum != batch_sum)
+            {
+                std::fprintf(stderr, "SumIntersectionAreas mismatch\n");
+                return 1;
+            }
+            Report("area", num_rects, loop_ns, batch_ns);
+        }
+
+        // Clamping, on a copy so every pass does the same work.
+        {
+            std::vector<Rect<int>> loop_rects;
+            RectArray batch_rects;
+            const double loop_ns = NsPerRect(num_queries, num_rects, [&](std::size_t)
+            {
+                loop_rects = aos;
+                for (Rect<int>& r : loop_rects)
+                {
+                    r = r.ClampedTo(screen);
+                }
+                Consume(loop_rects);
+            });
+            const double batch_ns = NsPerRect(num_queries, num_rects, [&](std::size_t)
+            {
+                batch_rects = soa;
+                ClampRects(screen, batch_rects);
+                Consume(batch_rects);
+            });
+            for (std::size_t i = 0; i < num_rects; ++i)
+            {
+                if (!(batch_rects.Get(i) == loop_rects[i]))
+                {
+                    std::fprintf(stderr, "ClampRects mismatch at %zu\n", i);
+                    return 1;
+                }
+            }
+            Report("clamp", num_rects, loop_ns, batch_ns);
+        }
+    }
+
+    return 0;
+}
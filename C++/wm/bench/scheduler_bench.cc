@@ -0,0 +1,138 @@
+// Measures how long a click waits behind a storm of ConfigureRequest events,
+// dispatched in arrival order and through the window manager's priority
+// scheduler.
+//
+// Usage: scheduler_bench [clients]
+
+#include "fake_backend.h"
+#include "window_manager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct Bench
+    {
+        WM::FakeBackend* m_fake;
+        std::unique_ptr<WM::WindowManager> m_wm;
+        std::vector<Window> m_clients;
+    };
+
+    // Dispatches everything queued in arrival order, as the event loop did
+    // before events were scheduled, logging included.
+    void DrainInOrder(Bench& bench)
+    {
+        XEvent e;
+        while (bench.m_fake->Pending())
+        {
+            bench.m_fake->NextEvent(e);
+            std::cout << "Received event: " << ToString(e);
+            bench.m_wm->HandleEvent(e);
+        }
+    }
+
+    Bench MakeBench(std::size_t num_clients)
+    {
+        auto fake = std::make_unique<WM::FakeBackend>();
+        Bench bench{fake.get(), nullptr, {}};
+        bench.m_wm = std::make_unique<WM::WindowManager>(std::move(fake));
+        bench.m_wm->Start();
+
+        for (std::size_t i = 0; i < num_clients; ++i)
+        {
+            const int offset = static_cast<int>(i % 64) * 10;
+            const Window w = bench.m_fake->ClientCreateWindow(offset, offset, 640, 480);
+            bench.m_fake->ClientMapWindow(w);
+            DrainInOrder(bench);
+            bench.m_clients.push_back(w);
+        }
+        return bench;
+    }
+
+    // Clients asking to be moved and resized, num_events times over.
+    void QueueStorm(Bench& bench, std::size_t num_events)
+    {
+        std::mt19937 random{42};
+        std::uniform_int_distribution<int> position{0, 1000};
+        std::uniform_int_distribution<int> size{50, 800};
+
+        for (std::size_t i = 0; i < num_events; ++i)
+        {
+            XWindowChanges changes;
+            std::memset(&changes, 0, sizeof(changes));
+            changes.x = position(random);
+            changes.y = position(random);
+            changes.width = size(random);
+            changes.height = size(random);
+            bench.m_fake->ClientConfigureWindow(bench.m_clients[i % bench.m_clients.size()],
+                                                CWX | CWY | CWWidth | CWHeight, changes);
+        }
+    }
+
+    // An Alt+click on a client, which grabs the pointer to move it.
+    void QueueClick(Bench& bench)
+    {
+        XEvent e;
+        std::memset(&e, 0, sizeof(e));
+        e.xbutton.type = ButtonPress;
+        e.xbutton.window = bench.m_clients.front();
+        e.xbutton.button = Button1;
+        e.xbutton.state = Mod1Mask;
+        e.xbutton.x_root = 100;
+        e.xbutton.y_root = 100;
+        bench.m_fake->QueueEvent(e);
+    }
+
+    void Run(const char* name, std::size_t num_clients, std::size_t num_events, bool scheduled)
+    {
+        Bench bench = MakeBench(num_clients);
+        QueueStorm(bench, num_events);
+        QueueClick(bench);
+        const std::size_t requests_before = bench.m_fake->GetRequestCount();
+
+        const auto start = std::chrono::steady_clock::now();
+        if (scheduled)
+        {
+            bench.m_wm->ProcessPendingEvents();
+        }
+        else
+        {
+            DrainInOrder(bench);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        // The fake server has no clock, the wait is estimated from how far
+        // into the requests made the pointer grab came.
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        const double requests = static_cast<double>(bench.m_fake->GetRequestCount() - requests_before);
+        const double before_grab = static_cast<double>(bench.m_fake->GetPointerGrabRequest() - requests_before);
+        std::printf("%-10s %8zu events %10.3f ms to click %10.3f ms to drain\n",
+                    name, num_events, ms * before_grab / requests, ms);
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_clients = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+
+    setenv("XDG_CONFIG_HOME", "/nonexistent", 1);
+    std::cout.rdbuf(nullptr);
+    std::cerr.rdbuf(nullptr);
+
+    for (const std::size_t num_events : {100u, 1000u, 10000u, 100000u})
+    {
+        Run("in order", num_clients, num_events, false);
+        Run("scheduled", num_clients, num_events, true);
+    }
+    return 0;
+}
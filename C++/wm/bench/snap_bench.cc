@@ -0,0 +1,72 @@
+// Measures edge snapping during a drag for growing window counts. The time
+// per motion event should stay flat, it is a binary search per edge.
+//
+// Usage: snap_bench [motion events per size]
+
+#include "edge_index.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+    // Keeps the optimiser from dropping a result.
+    template <typename T>
+    void Consume(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_events = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> position{0, 3600};
+    std::uniform_int_distribution<int> size{100, 1200};
+    std::uniform_int_distribution<int> step{-8, 8};
+
+    for (const std::size_t num_windows : {10u, 100u, 1000u, 10000u})
+    {
+        WM::Placement placement;
+        placement.SetOutputs({Rect<int>(0, 0, 3840, 2160)});
+        for (std::size_t i = 0; i < num_windows; ++i)
+        {
+            placement.Add(static_cast<Window>(i + 1),
+                          Rect<int>(position(random), position(random) / 2, size(random), size(random)));
+        }
+
+        // 1. Rebuild, once per drag.
+        WM::EdgeIndex edges;
+        const auto build_start = std::chrono::steady_clock::now();
+        edges.Update(placement);
+        const auto build_end = std::chrono::steady_clock::now();
+
+        // 2. Drag window 1 around in small steps, as motion events do.
+        Rect<int> dragged = *placement.GetRect(1);
+        std::size_t num_snapped = 0;
+        const auto drag_start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < num_events; ++i)
+        {
+            dragged += Vector2D<int>(step(random), step(random));
+            edges.Update(placement);
+            const Position<int> snapped = edges.SnapPosition(dragged, 1, 12);
+            num_snapped += snapped.m_x != dragged.m_x || snapped.m_y != dragged.m_y;
+            Consume(snapped);
+        }
+        const auto drag_end = std::chrono::steady_clock::now();
+
+        std::printf("%6zu windows  rebuild %9.1f us  snap %7.1f ns/event  %5.1f%% snapped\n", num_windows,
+                    std::chrono::duration<double, std::micro>(build_end - build_start).count(),
+                    std::chrono::duration<double, std::nano>(drag_end - drag_start).count() / static_cast<double>(num_events),
+                    100.0 * static_cast<double>(num_snapped) / static_cast<double>(num_events));
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Measures downscaling window contents to switcher thumbnails, for common
+// window sizes, and how many thumbnails fit the thumbnailer's 4 ms frame
+// budget. Capture round trips come on top, they depend on the server.
+//
+// Usage: thumbnail_bench [thumbnails per size]
+
+#include "pixel_ops.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Keeps the optimiser from dropping a result.
+    template <typename T>
+    void Consume(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef __OPTIMIZE__
+    std::fprintf(stderr, "warning: built without optimisation, numbers are not representative\n");
+#endif
+
+    const std::size_t num_thumbnails = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    constexpr unsigned int THUMBNAIL_WIDTH = 192;
+    constexpr unsigned int THUMBNAIL_HEIGHT = 120;
+    constexpr double FRAME_BUDGET_US = 4000.0;
+
+    std::mt19937 random{42};
+    std::vector<std::uint32_t> thumbnail(std::size_t{THUMBNAIL_WIDTH} * THUMBNAIL_HEIGHT);
+
+    const struct { unsigned int m_width, m_height; } sizes[] = {
+        {640, 480}, {1280, 800}, {1920, 1080}, {3840, 2160},
+    };
+    for (const auto& size : sizes)
+    {
+        // Window contents, alpha byte undefined as in a 24 bit window.
+        std::vector<std::uint32_t> contents(std::size_t{size.m_width} * size.m_height);
+        for (std::uint32_t& pixel : contents)
+        {
+            pixel = static_cast<std::uint32_t>(random());
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < num_thumbnails; ++i)
+        {
+            WM::Pixel::ScaleThumbnailArgb(contents.data(), size.m_width, size.m_height,
+                                          thumbnail.data(), THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, 0x202020);
+            Consume(thumbnail);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        const double per_thumbnail = std::chrono::duration<double, std::micro>(end - start).count()
+                                   / static_cast<double>(num_thumbnails);
+        std::printf("%4ux%-4u  %9.1f us/thumbnail  %6.1f per frame budget\n", size.m_width, size.m_height,
+                    per_thumbnail, FRAME_BUDGET_US / per_thumbnail);
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#ifndef AUDITING_BACKEND_H
+#define AUDITING_BACKEND_H
+
+#include "x_backend.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace WM
+{
+    // Counts blocking round trips while forwarding to another backend.
+    //
+    // Requests that wait for a reply are accounted to the phase the window
+    // manager last named with SetPhase: the handler running, or a step of
+    // Start. Each phase has a budget, the most round trips a single entry
+    // into it may make, e.g. 0 for OnMotionNotify. A phase without one is
+    // allowed none, so a new phase that blocks must be declared. Benchmarks
+    // check the budgets after a run, so a handler that starts to block fails
+    // them instead of slipping in.
+    class AuditingBackend : public XBackend
+    {
+    public: // Public types
+        // A phase over budget.
+        struct Violation
+        {
+            std::string m_phase;
+            std::size_t m_budget;
+            std::size_t m_maxRoundTrips;
+        };
+
+    public: // Public methods
+        explicit AuditingBackend(std::unique_ptr<XBackend> backend);
+
+        AuditingBackend(const AuditingBackend&) = delete;
+        AuditingBackend& operator=(const AuditingBackend&) = delete;
+
+        // Allows each entry into phase at most budget round trips.
+        void SetBudget(std::string_view phase, std::size_t budget);
+
+        // Returns the phases that went over their budget, 0 if not set.
+        std::vector<Violation> GetViolations() const;
+
+        // Writes the round trips of every phase, by request.
+        void PrintReport(std::ostream& out) const;
+
+        std::optional<std::string> GetDisplayName() const override;
+        Window GetRootWindow() const override;
+        Atom InternAtom(const std::string& name) override;
+        void RedirectRoot(long event_mask) override;
+        void SetPhase(const char* name) override;
+
+        int GetConnectionFd() const override;
+        bool Pending() override;
+        void NextEvent(XEvent& e) override;
+        bool CheckTypedWindowEvent(Window w, int type, XEvent& e) override;
+        void Flush() override;
+        void Sync() override;
+
+        bool GrabPointerMotion(Window w, Time time) override;
+        void UngrabPointerMotion(Time time) override;
+        bool GetPointerEvent(XEvent& e, PointerEvent& pointer) override;
+
+        void GrabServer() override;
+        void UngrabServer() override;
+        std::vector<Window> QueryTree(Window w) override;
+        bool GetWindowAttributes(Window w, XWindowAttributes& attributes) override;
+        bool GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height) override;
+
+        Window CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                  unsigned int border_width, unsigned long border, unsigned long background) override;
+        void DestroyWindow(Window w) override;
+        void SelectInput(Window w, long event_mask) override;
+        void ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes) override;
+        void MapWindow(Window w) override;
+        void UnmapWindow(Window w) override;
+        void ReparentWindow(Window w, Window parent, int x, int y) override;
+        void AddToSaveSet(Window w) override;
+        void RemoveFromSaveSet(Window w) override;
+
+        void ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes) override;
+        void MoveWindow(Window w, int x, int y) override;
+        void ResizeWindow(Window w, unsigned int width, unsigned int height) override;
+        void RaiseWindow(Window w) override;
+
+        void SetWindowBorderWidth(Window w, unsigned int width) override;
+        void SetWindowBorder(Window w, unsigned long pixel) override;
+        void SetWindowBackground(Window w, unsigned long pixel) override;
+        void ClearWindow(Window w) override;
+        void CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                      unsigned int width, unsigned int height, int dst_x, int dst_y) override;
+
+        void GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask) override;
+        void GrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        void UngrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        bool GrabKeyboard(Window w, Time time) override;
+        void UngrabKeyboard(Time time) override;
+        KeyCode KeysymToKeycode(KeySym keysym) override;
+
+        void SetInputFocus(Window w) override;
+        void KillClient(Window w) override;
+        bool SendEvent(Window w, long event_mask, XEvent& e) override;
+
+        std::vector<PropertyReply> GetProperties(const std::vector<PropertyRequest>& requests) override;
+        void ChangeProperty(Window w, Atom property, Atom type, int format,
+                            const unsigned char* data, int num_items) override;
+
+    private: // Private types
+        struct Phase
+        {
+            std::size_t m_entries{0};
+            std::size_t m_roundTrips{0};
+            // Most round trips of a single entry.
+            std::size_t m_maxRoundTrips{0};
+            // Round trips by request.
+            std::map<std::string_view, std::size_t> m_requests{};
+        };
+
+    private: // Private methods
+        // Accounts a round trip made by request to the current phase.
+        void CountRoundTrip(std::string_view request);
+
+        // Closes the current entry, updating the most round trips.
+        void EndEntry();
+
+    private: // Private variables
+        std::unique_ptr<XBackend> m_backend;
+
+        // Phase names are the literals passed to SetPhase.
+        std::map<std::string_view, Phase, std::less<>> m_phases{};
+        std::map<std::string, std::size_t, std::less<>> m_budgets{};
+
+        Phase* m_phase;
+        std::size_t m_entryRoundTrips{0};
+    };
+}
+
+#endif
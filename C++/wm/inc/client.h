@@ -0,0 +1,47 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "client_properties.h"
+#include "icon_cache.h"
+#include "resource_sampler.h"
+#include "rules.h"
+#include <memory>
+
+namespace WM
+{
+    // Book keeping for a managed top-level window.
+    struct Client
+    {
+        // The frame the client window has been reparented into, or the
+        // client window itself if it is managed in place.
+        Window m_frame{None};
+        bool m_reparented{true};
+        // Border width the client had, given back when a client managed in
+        // place is let go.
+        unsigned int m_originalBorderWidth{0};
+
+        // Decoded _NET_WM_ICON, drawn in the title bar. Stays nullptr until
+        // the icon loader is done, or if the client has no icon.
+        std::shared_ptr<const Icon> m_icon{};
+
+        // Latest switcher thumbnail, owned by the thumbnailer. None until
+        // the switcher first shows the client.
+        Pixmap m_thumbnail{None};
+
+        // ICCCM and EWMH properties, kept up to date from PropertyNotify.
+        ClientProperties m_properties{};
+
+        // Merged actions of the window rules that matched at Frame time.
+        RuleActions m_actions{};
+
+        // Server resources of the client over time, from X-Resource.
+        ResourceHistory m_resources{};
+    };
+}
+
+#endif
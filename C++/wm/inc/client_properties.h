@@ -0,0 +1,67 @@
+#ifndef CLIENT_PROPERTIES_H
+#define CLIENT_PROPERTIES_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "rules.h"
+#include "x_backend.h"
+#include <string>
+#include <vector>
+
+namespace WM
+{
+    // Atoms of the cached properties without a predefined one.
+    struct PropertyAtoms
+    {
+        Atom m_wmProtocols{None};
+        Atom m_netWmName{None};
+        Atom m_netWmWindowType{None};
+        Atom m_utf8String{None};
+    };
+
+    // The ICCCM and EWMH properties of a client the window manager acts on,
+    // decoded.
+    //
+    // They are read in one batch when the client is framed and again, one
+    // property at a time, when PropertyNotify says one changed, so handlers
+    // read them here instead of asking the server.
+    struct ClientProperties
+    {
+        // WM_CLASS.
+        std::string m_instance{};
+        std::string m_class{};
+        // _NET_WM_NAME, and WM_NAME for clients without it.
+        std::string m_netName{};
+        std::string m_name{};
+        bool m_hasNetName{false};
+        // WM_PROTOCOLS, e.g. WM_DELETE_WINDOW.
+        std::vector<Atom> m_protocols{};
+        // _NET_WM_WINDOW_TYPE, most preferred first.
+        std::vector<Atom> m_windowTypes{};
+        // WM_NORMAL_HINTS flags, e.g. USPosition.
+        long m_normalHintsFlags{0};
+        // WM_HINTS input model and urgency.
+        bool m_input{true};
+        bool m_urgent{false};
+
+        // Returns whether property is one of those cached.
+        static bool IsCached(const PropertyAtoms& atoms, Atom property);
+
+        // Requests to read the properties of w, all of them if properties
+        // is empty.
+        static std::vector<PropertyRequest> GetRequests(const PropertyAtoms& atoms, Window w,
+                                                        const std::vector<Atom>& properties = {});
+
+        // Decodes the reply to a request from GetRequests. A missing
+        // property resets the value to its default.
+        void Store(const PropertyAtoms& atoms, Atom property, const PropertyReply& reply);
+
+        // Class, instance and title, for window rules.
+        WindowIdentity GetIdentity() const;
+    };
+}
+
+#endif
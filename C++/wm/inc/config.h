@@ -0,0 +1,107 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+    #include <X11/keysym.h>
+}
+
+#include <string_view>
+#include <vector>
+
+namespace WM
+{
+    // What a key binding does.
+    enum class KeyAction
+    {
+        // Close the focused window, gracefully if it supports it.
+        Close,
+        // Raise and focus the next window.
+        SwitchNext,
+    };
+
+    // How clients are managed.
+    enum class FrameMode
+    {
+        // Reparented into a frame window with a title bar.
+        Reparent,
+        // Managed in place, decorated with their own border only. Saves a
+        // window and its reparenting traffic per client.
+        Borderless,
+    };
+
+    // What gives a client the input focus.
+    enum class FocusMode
+    {
+        // Switching to it.
+        Click,
+        // The pointer resting on it.
+        Mouse,
+    };
+
+    struct KeyBinding
+    {
+        // Modifier mask, e.g. Mod1Mask.
+        unsigned int m_modifiers;
+        KeySym m_keysym;
+        KeyAction m_action;
+
+        bool operator == (const KeyBinding& other) const = default;
+    };
+
+    // Settings read from $XDG_CONFIG_HOME/wm/config. Members hold the defaults
+    // used for anything the file doesn't set.
+    struct Config
+    {
+        unsigned int m_borderWidth{3};
+        unsigned long m_borderColor{0xff0000};
+        // Frame and title bar background.
+        unsigned long m_backgroundColor{0x0000ff};
+        // How close, in pixels, a dragged frame has to come to an output or
+        // another frame to snap to its edge. It also has to be dragged this
+        // far past the edge to leave it. 0 turns snapping off.
+        unsigned int m_snapDistance{12};
+        // Applies to windows mapped after it is set.
+        FrameMode m_frameMode{FrameMode::Reparent};
+        FocusMode m_focusMode{FocusMode::Click};
+
+        std::vector<KeyBinding> m_keyBindings{
+            {Mod1Mask, XK_F4, KeyAction::Close},
+            {Mod1Mask, XK_Tab, KeyAction::SwitchNext},
+        };
+
+        // Parses a config file of "key = value" lines:
+        //
+        //     border_width = 3
+        //     border_color = #ff0000
+        //     background_color = #0000ff
+        //     snap_distance = 12
+        //     frame_mode = reparent
+        //     focus_mode = click
+        //     bind = Mod1+F4 close
+        //     bind = Mod1+Tab switch_next
+        //
+        // If the file has any bind lines they replace the default bindings.
+        // '#' at the start of a line starts a comment. Throws
+        // std::runtime_error on errors.
+        static Config Parse(std::string_view text);
+    };
+
+    // The changes between two configs, so a reload only touches what changed.
+    struct ConfigDiff
+    {
+        bool m_borderWidth{false};
+        bool m_borderColor{false};
+        bool m_backgroundColor{false};
+
+        std::vector<KeyBinding> m_removedKeys{};
+        std::vector<KeyBinding> m_addedKeys{};
+
+        bool IsEmpty() const;
+    };
+
+    ConfigDiff Diff(const Config& before, const Config& after);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <string>
+#include <vector>
+
+namespace WM
+{
+    // Watches the configuration directory with inotify.
+    //
+    // The directory is watched rather than the files, so editors that save
+    // by writing a new file and renaming it over the old one are noticed too.
+    class ConfigWatcher
+    {
+    public: // Public methods
+        explicit ConfigWatcher(const std::string& directory);
+
+        ~ConfigWatcher();
+
+        ConfigWatcher(const ConfigWatcher&) = delete;
+        ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+        // Readable when files changed, -1 if the directory can't be watched.
+        int GetFd() const { return m_fd; }
+
+        // Returns the names of the files written since the last call, each
+        // name once. Never blocks.
+        std::vector<std::string> ReadChanges();
+
+    private: // Private variables
+        int m_fd;
+    };
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef CONFIGURE_THROTTLE_H
+#define CONFIGURE_THROTTLE_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace WM
+{
+    // Requests of one client that were held back.
+    struct ThrottleStats
+    {
+        Window m_window;
+        std::size_t m_requestCount;
+        // Requests folded into a later one instead of being granted.
+        std::size_t m_collapsedCount;
+    };
+
+    // Rate limits ConfigureRequest per client with a token bucket.
+    //
+    // Each request granted takes a token, and tokens come back at a steady
+    // rate up to a burst limit, so a client resizing now and then never
+    // waits. A client out of tokens has its requests merged into one with
+    // the latest value of every field, granted when the next token is in.
+    // Only the book keeping is here, the window manager configures the
+    // windows.
+    class ConfigureThrottle
+    {
+    public: // Public types
+        using Clock = std::chrono::steady_clock;
+
+    public: // Public methods
+        explicit ConfigureThrottle(double rate = 60.0, double burst = 20.0);
+
+        // Returns true if the request can be granted now. Otherwise it is
+        // kept, merged with any held back before it, for TakeDue.
+        bool Admit(const XConfigureRequestEvent& e, Clock::time_point now);
+
+        // Removes and returns the held back requests of clients that have a
+        // token again.
+        std::vector<XConfigureRequestEvent> TakeDue(Clock::time_point now);
+
+        // Forgets a client, along with any request held back.
+        void Remove(Window w);
+
+        // Time until TakeDue has something, std::nullopt if nothing is held
+        // back.
+        std::optional<Clock::duration> GetTimeout(Clock::time_point now) const;
+
+        // Clients that have had requests collapsed, most first.
+        std::vector<ThrottleStats> GetOffenders() const;
+
+        std::size_t GetGrantedCount() const { return m_grantedCount; }
+        std::size_t GetCollapsedCount() const { return m_collapsedCount; }
+
+    private: // Private types
+        struct Bucket
+        {
+            double m_tokens;
+            Clock::time_point m_refilled;
+            std::optional<XConfigureRequestEvent> m_held{};
+
+            std::size_t m_requestCount{0};
+            std::size_t m_collapsedCount{0};
+        };
+
+    private: // Private methods
+        // Adds the tokens earned since the last refill.
+        void Refill(Bucket& bucket, Clock::time_point now) const;
+
+        // Copies the fields set in from over those in to.
+        static void Merge(XConfigureRequestEvent& to, const XConfigureRequestEvent& from);
+
+    private: // Private variables
+        // Tokens per second, and most tokens saved up.
+        double m_rate;
+        double m_burst;
+
+        std::unordered_map<Window, Bucket> m_buckets{};
+        // Buckets with a request held back.
+        std::size_t m_heldCount{0};
+
+        std::size_t m_grantedCount{0};
+        std::size_t m_collapsedCount{0};
+    };
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef EDGE_INDEX_H
+#define EDGE_INDEX_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "placement.h"
+#include "util.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace WM
+{
+    // Snaps dragged frames to the edges of the outputs and of other frames.
+    //
+    // The edges are kept in two arrays sorted by position, one for vertical
+    // edges (x) and one for horizontal edges (y), so a query is a binary
+    // search plus a walk over the edges within the snap distance, however
+    // many windows there are. The arrays are rebuilt from the placement
+    // only when its geometry has changed.
+    class EdgeIndex
+    {
+    public: // Public methods
+        // Rebuilds the edges if the placement changed since the last call.
+        void Update(const Placement& placement);
+
+        // Returns where to move a frame with outer geometry rect, so that
+        // its edges within distance of another edge line up with it. The
+        // edges of ignore, the frame being dragged, are skipped.
+        Position<int> SnapPosition(const Rect<int>& rect, Window ignore, int distance) const;
+
+        // Same for a resize, which only moves the right and bottom edges.
+        Size<int> SnapSize(const Rect<int>& rect, Window ignore, int distance) const;
+
+    private: // Private types
+        struct Edge
+        {
+            int m_position;
+            // Extent along the edge, [m_start, m_end).
+            int m_start;
+            int m_end;
+            // None for output edges.
+            Window m_window;
+        };
+
+    private: // Private methods
+        // Returns the offset to the closest edge within distance of
+        // position that overlaps [start, end), if there is one.
+        static std::optional<int> FindNearest(const std::vector<Edge>& edges, int position,
+                                              int start, int end, Window ignore, int distance);
+
+        // Returns the smaller of two optional offsets.
+        static std::optional<int> Closest(std::optional<int> a, std::optional<int> b);
+
+    private: // Private variables
+        // Left and right edges, sorted by x.
+        std::vector<Edge> m_vertical{};
+        // Top and bottom edges, sorted by y.
+        std::vector<Edge> m_horizontal{};
+
+        std::optional<std::uint64_t> m_generation{};
+    };
+}
+
+#endif
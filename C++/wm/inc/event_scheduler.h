@@ -0,0 +1,100 @@
+#ifndef EVENT_SCHEDULER_H
+#define EVENT_SCHEDULER_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "x_backend.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace WM
+{
+    // Priority classes, in dispatch order.
+    enum class EventClass
+    {
+        // What the user is waiting on: keys, buttons, motion and focus.
+        Input,
+        // Windows appearing, going and asking to be moved.
+        Structure,
+        // Redraws, property and geometry updates.
+        Cosmetic,
+    };
+
+    // Orders queued events by priority rather than by arrival.
+    //
+    // The window manager pulls everything the server has queued into the
+    // scheduler and dispatches from it, so a flood of ConfigureRequest or
+    // PropertyNotify from one client doesn't hold up a key press behind it.
+    // Events keep their arrival order within a class. A class passed over
+    // starvation_limit times in a row while waiting gets the next dispatch
+    // once nothing that arrived before its next event waits in a higher
+    // class, so lower classes still make progress during an input storm
+    // without overtaking older input, which could be for a window the
+    // lower event goes on to unframe.
+    class EventScheduler
+    {
+    public: // Public types
+        struct Entry
+        {
+            XEvent m_event{};
+            // Decoded when pulled, XInput2 data doesn't outlive the next
+            // read from the connection.
+            std::optional<PointerEvent> m_pointer{};
+            // Arrival order across all classes.
+            std::uint64_t m_sequence{0};
+        };
+
+    public: // Public methods
+        explicit EventScheduler(std::size_t starvation_limit = 8);
+
+        static EventClass Classify(const XEvent& e);
+
+        // Queues an event. Motion right behind motion for the same window
+        // replaces it, only the latest position matters.
+        void Push(const XEvent& e, const std::optional<PointerEvent>& pointer = std::nullopt);
+
+        // Takes the next event to dispatch. Returns false if there is none.
+        bool Pop(Entry& entry);
+
+        bool IsEmpty() const;
+
+        std::size_t GetDispatchedCount(EventClass event_class) const
+        {
+            return m_dispatchedCounts[static_cast<std::size_t>(event_class)];
+        }
+        // Motion events replaced by newer ones.
+        std::size_t GetCoalescedCount() const { return m_coalescedCount; }
+        // Dispatches given to a class because it had waited too long.
+        std::size_t GetStarvedCount() const { return m_starvedCount; }
+        // Most events queued at once.
+        std::size_t GetMaxQueued() const { return m_maxQueued; }
+
+    private: // Private methods
+        // Whether the next event of event_class arrived before those of
+        // every higher class.
+        bool IsOldest(std::size_t event_class) const;
+
+    private: // Private variables
+        static constexpr std::size_t NUM_CLASSES = 3;
+
+        std::size_t m_starvationLimit;
+        std::array<std::deque<Entry>, NUM_CLASSES> m_queues{};
+        // Times each waiting class has been passed over.
+        std::array<std::size_t, NUM_CLASSES> m_skipped{};
+        std::size_t m_size{0};
+        std::uint64_t m_nextSequence{0};
+
+        std::array<std::size_t, NUM_CLASSES> m_dispatchedCounts{};
+        std::size_t m_coalescedCount{0};
+        std::size_t m_starvedCount{0};
+        std::size_t m_maxQueued{0};
+    };
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef FAKE_BACKEND_H
+#define FAKE_BACKEND_H
+
+#include "x_backend.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace WM
+{
+    // An in-memory X server for benchmarks and replays.
+    //
+    // It models the window tree, geometry, map state, event masks and
+    // properties, and generates the structure events a real server would for
+    // the requests the window manager makes. Clients are simulated by the
+    // Client* methods, which behave like requests from another connection:
+    // map and configure requests are redirected to the window manager when it
+    // holds SubstructureRedirectMask on the parent.
+    //
+    // Nothing blocks, NextEvent throws if the queue is empty.
+    class FakeBackend : public XBackend
+    {
+    public: // Public types
+        struct WindowState
+        {
+            Window m_parent{None};
+            int m_x{0};
+            int m_y{0};
+            unsigned int m_width{1};
+            unsigned int m_height{1};
+            unsigned int m_borderWidth{0};
+            bool m_mapped{false};
+            bool m_overrideRedirect{false};
+            long m_eventMask{NoEventMask};
+            // Stacking order, bottom to top.
+            std::vector<Window> m_children{};
+            std::unordered_map<Atom, PropertyReply> m_properties{};
+        };
+
+    public: // Public methods
+        // Size of the root window.
+        explicit FakeBackend(unsigned int width = 1920, unsigned int height = 1080);
+
+        //------------------------------------------------------------------//
+        //                         SIMULATED CLIENTS                        //
+        //------------------------------------------------------------------//
+
+        // Creates an unmapped top-level window, like XCreateSimpleWindow from
+        // a client.
+        Window ClientCreateWindow(int x, int y, unsigned int width, unsigned int height,
+                                  bool override_redirect = false);
+
+        // Maps a client window, or sends a MapRequest to the window manager.
+        void ClientMapWindow(Window w);
+
+        // Unmaps a client window. Unmapping is never redirected.
+        void ClientUnmapWindow(Window w);
+
+        // Configures a client window, or sends a ConfigureRequest.
+        void ClientConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes);
+
+        void ClientDestroyWindow(Window w);
+
+        // Sets a property with 32 bit items.
+        void ClientSetProperty(Window w, Atom property, Atom type, const std::vector<std::uint32_t>& items);
+        // Sets a string property.
+        void ClientSetProperty(Window w, Atom property, Atom type, const std::string& value);
+
+        // Queues an arbitrary event, e.g. synthetic input.
+        void QueueEvent(const XEvent& e);
+
+        // Queues an XInput2 pointer event, as a GenericEvent GetPointerEvent
+        // decodes.
+        void QueuePointerEvent(const PointerEvent& pointer);
+
+        // Creates a top-level window with this id if it doesn't exist yet,
+        // so events recorded against a real server can be replayed.
+        void EnsureWindow(Window w);
+
+        // Makes the next CreateSimpleWindow return this id, so windows the
+        // window manager creates during a replay get their recorded ids.
+        void ReserveWindowId(Window w);
+
+        // Drops every queued event.
+        void DiscardEvents() { m_events.clear(); }
+
+        //------------------------------------------------------------------//
+        //                            INSPECTION                            //
+        //------------------------------------------------------------------//
+
+        // Returns nullptr for unknown windows.
+        const WindowState* FindWindow(Window w) const;
+
+        std::size_t GetWindowCount() const { return m_windows.size(); }
+        std::size_t GetQueuedEventCount() const { return m_events.size(); }
+        // Requests made through the XBackend interface.
+        std::size_t GetRequestCount() const { return m_requestCount; }
+        Window GetFocus() const { return m_focus; }
+        // The window holding the XInput2 pointer grab, None if there is none.
+        Window GetPointerGrab() const { return m_pointerGrab; }
+        // GetRequestCount() when the pointer grab was last taken, to tell
+        // how far into a run of events it happened.
+        std::size_t GetPointerGrabRequest() const { return m_pointerGrabRequest; }
+        // The window holding the keyboard grab, None if there is none.
+        Window GetKeyboardGrab() const { return m_keyboardGrab; }
+
+        //------------------------------------------------------------------//
+        //                             XBACKEND                             //
+        //------------------------------------------------------------------//
+
+        std::optional<std::string> GetDisplayName() const override { return std::nullopt; }
+        Window GetRootWindow() const override { return m_rootWindow; }
+        Atom InternAtom(const std::string& name) override;
+        void RedirectRoot(long event_mask) override;
+
+        int GetConnectionFd() const override { return -1; }
+        bool Pending() override;
+        void NextEvent(XEvent& e) override;
+        bool CheckTypedWindowEvent(Window w, int type, XEvent& e) override;
+        void Flush() override;
+        void Sync() override;
+
+        bool GrabPointerMotion(Window w, Time time) override;
+        void UngrabPointerMotion(Time time) override;
+        bool GetPointerEvent(XEvent& e, PointerEvent& pointer) override;
+
+        void GrabServer() override;
+        void UngrabServer() override;
+        std::vector<Window> QueryTree(Window w) override;
+        bool GetWindowAttributes(Window w, XWindowAttributes& attributes) override;
+        bool GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height) override;
+
+        Window CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                  unsigned int border_width, unsigned long border, unsigned long background) override;
+        void DestroyWindow(Window w) override;
+        void SelectInput(Window w, long event_mask) override;
+        void ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes) override;
+        void MapWindow(Window w) override;
+        void UnmapWindow(Window w) override;
+        void ReparentWindow(Window w, Window parent, int x, int y) override;
+        void AddToSaveSet(Window w) override;
+        void RemoveFromSaveSet(Window w) override;
+
+        void ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes) override;
+        void MoveWindow(Window w, int x, int y) override;
+        void ResizeWindow(Window w, unsigned int width, unsigned int height) override;
+        void RaiseWindow(Window w) override;
+
+        void SetWindowBorderWidth(Window w, unsigned int width) override;
+        void SetWindowBorder(Window w, unsigned long pixel) override;
+        void SetWindowBackground(Window w, unsigned long pixel) override;
+        void ClearWindow(Window w) override;
+        void CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                      unsigned int width, unsigned int height, int dst_x, int dst_y) override;
+
+        void GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask) override;
+        void GrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        void UngrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        bool GrabKeyboard(Window w, Time time) override;
+        void UngrabKeyboard(Time time) override;
+        KeyCode KeysymToKeycode(KeySym keysym) override;
+
+        void SetInputFocus(Window w) override;
+        void KillClient(Window w) override;
+        bool SendEvent(Window w, long event_mask, XEvent& e) override;
+
+        std::vector<PropertyReply> GetProperties(const std::vector<PropertyRequest>& requests) override;
+        void ChangeProperty(Window w, Atom property, Atom type, int format,
+                            const unsigned char* data, int num_items) override;
+
+    private: // Private methods
+        void NewWindow(Window w, Window parent, int x, int y, unsigned int width, unsigned int height);
+
+        // Queues a structure event for the listeners of w and its parent:
+        // StructureNotifyMask on w, SubstructureNotifyMask on the parent.
+        // xany.window is the event window of all structure events, it's set
+        // per listener.
+        void NotifyStructure(Window w, XEvent e);
+
+        // Queues PropertyNotify if PropertyChangeMask is selected on w.
+        void NotifyProperty(Window w, Atom property);
+
+        // Whether a client request on w is redirected to the window manager.
+        bool IsRedirected(Window w) const;
+
+        void Unmap(Window w);
+        void Map(Window w);
+
+    private: // Private variables
+        Window m_rootWindow;
+        Window m_nextWindow;
+        Window m_focus{None};
+
+        std::unordered_map<Window, WindowState> m_windows{};
+        std::deque<Window> m_reservedIds{};
+        std::deque<XEvent> m_events{};
+
+        // XInput2 event data, by cookie.
+        std::unordered_map<unsigned int, PointerEvent> m_pointerEvents{};
+        unsigned int m_nextCookie{0};
+        Window m_pointerGrab{None};
+        std::size_t m_pointerGrabRequest{0};
+        Window m_keyboardGrab{None};
+
+        std::unordered_map<std::string, Atom> m_atoms{};
+        Atom m_nextAtom;
+
+        unsigned long m_serial{0};
+        std::size_t m_requestCount{0};
+    };
+}
+
+#endif
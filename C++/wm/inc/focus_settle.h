@@ -0,0 +1,52 @@
+#ifndef FOCUS_SETTLE_H
+#define FOCUS_SETTLE_H
+
+#include "util.h"
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace WM
+{
+    // Waits for the pointer to settle before focus follows it.
+    //
+    // Every crossing into a frame restarts the wait, so sweeping the
+    // pointer across several windows gives one focus change, for where it
+    // came to rest, instead of one per window crossed.
+    class FocusSettle
+    {
+    public: // Public types
+        using Clock = std::chrono::steady_clock;
+
+    public: // Public methods
+        explicit FocusSettle(Clock::duration delay = std::chrono::milliseconds(40));
+
+        // Notes the pointer entering a frame at pos.
+        void Push(const Position<int>& pos, Clock::time_point now);
+
+        // Returns where the pointer came to rest, once it has, and forgets
+        // it.
+        std::optional<Position<int>> TakeDue(Clock::time_point now);
+
+        // Drops a pending position, e.g. when focus was given otherwise.
+        void Cancel();
+
+        // Time until TakeDue has something, std::nullopt if nothing waits.
+        std::optional<Clock::duration> GetTimeout(Clock::time_point now) const;
+
+        // Crossings seen, and the positions they settled to.
+        std::size_t GetPushedCount() const { return m_pushedCount; }
+        std::size_t GetSettledCount() const { return m_settledCount; }
+
+    private: // Private variables
+        Clock::duration m_delay;
+
+        std::optional<Position<int>> m_pending{};
+        Clock::time_point m_deadline{};
+
+        std::size_t m_pushedCount{0};
+        std::size_t m_settledCount{0};
+    };
+}
+
+#endif
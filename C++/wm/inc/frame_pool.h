@@ -0,0 +1,79 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace WM
+{
+    // Unmapped frame windows kept for reuse, so windows that come and go
+    // quickly, like splash screens, don't create and destroy a frame each
+    // time.
+    //
+    // Only the book keeping is here, the window manager makes the requests:
+    // it hands in frames on unframe instead of destroying them, and takes
+    // them back on frame instead of creating one. Frames idle for too long
+    // are handed out for destruction.
+    class FramePool
+    {
+    public: // Public types
+        using Clock = std::chrono::steady_clock;
+
+    public: // Public methods
+        explicit FramePool(std::size_t capacity = 8, Clock::duration idle_timeout = std::chrono::seconds(30));
+
+        // Returns the most recently returned frame, None if there is none.
+        Window Take();
+
+        // Keeps an unmapped frame. Returns false if the pool is full, the
+        // frame should be destroyed then.
+        bool Give(Window frame, Clock::time_point now);
+
+        // Removes and returns the frames idle longer than the timeout.
+        std::vector<Window> TakeIdle(Clock::time_point now);
+
+        // Removes and returns every frame.
+        std::vector<Window> TakeAll();
+
+        // Time until TakeIdle has something, std::nullopt if the pool is
+        // empty.
+        std::optional<Clock::duration> GetTimeout(Clock::time_point now) const;
+
+        std::size_t GetSize() const { return m_frames.size(); }
+
+        // Takes that found a frame, and those that didn't.
+        std::size_t GetHitCount() const { return m_hitCount; }
+        std::size_t GetMissCount() const { return m_missCount; }
+        // Frames turned away because the pool was full, and trimmed idle.
+        std::size_t GetOverflowCount() const { return m_overflowCount; }
+        std::size_t GetTrimmedCount() const { return m_trimmedCount; }
+
+    private: // Private types
+        struct Entry
+        {
+            Window m_frame;
+            Clock::time_point m_returned;
+        };
+
+    private: // Private variables
+        std::size_t m_capacity;
+        Clock::duration m_idleTimeout;
+
+        // Oldest first.
+        std::vector<Entry> m_frames{};
+
+        std::size_t m_hitCount{0};
+        std::size_t m_missCount{0};
+        std::size_t m_overflowCount{0};
+        std::size_t m_trimmedCount{0};
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef HIT_INDEX_H
+#define HIT_INDEX_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "placement.h"
+#include "util.h"
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace WM
+{
+    // Finds the topmost frame under a point without asking the server.
+    //
+    // The frames of the placement are bucketed in a uniform grid of square
+    // cells, each listing the frames overlapping it in stacking order, so a
+    // query tests the frames in the cell of the point from the top until
+    // one contains it. Stacking is the order frames were raised or lowered
+    // in, a raise moves the frame to the front of its cells and a lower to
+    // the back. The grid is rebuilt from
+    // the placement only when its geometry has changed.
+    class HitIndex
+    {
+    public: // Public methods
+        explicit HitIndex(int cell_size = 256);
+
+        // Rebuilds the grid if the placement changed since the last call.
+        void Update(const Placement& placement);
+
+        // Puts a frame above or below every other one.
+        void Raise(Window frame);
+        void Lower(Window frame);
+
+        // Puts a frame right above or below sibling, the grid is rebuilt at
+        // the next Update.
+        void Restack(Window frame, Window sibling, bool above);
+        void Remove(Window frame);
+
+        // Returns the topmost frame containing pos, None if there is none.
+        Window FindTopmost(const Position<int>& pos) const;
+
+    private: // Private methods
+        // Range of cells covering [start, end) along one axis.
+        std::pair<int, int> GetCells(int start, int end, int origin) const;
+
+        // Calls f with the cell list of every cell rect overlaps.
+        template <typename F>
+        void ForEachCell(const Rect<int>& rect, F&& f);
+
+    private: // Private variables
+        int m_cellSize;
+
+        // Copy of the placement at the last Update.
+        std::vector<Window> m_windows{};
+        std::vector<Rect<int>> m_rects{};
+        std::unordered_map<Window, std::size_t> m_indices{};
+
+        // Cells of the bounding box of the frames, row by row, each listing
+        // indices into m_windows from the top down.
+        Rect<int> m_bounds{};
+        int m_columns{0};
+        std::vector<std::vector<std::uint32_t>> m_cells{};
+
+        // Stacking order, higher is above. Frames never raised or lowered
+        // are at zero, between the raised and the lowered ones.
+        std::unordered_map<Window, std::int64_t> m_stacking{};
+        std::int64_t m_nextStacking{1};
+        std::int64_t m_nextLowering{-1};
+
+        std::optional<std::uint64_t> m_generation{};
+    };
+}
+
+#endif
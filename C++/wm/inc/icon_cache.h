@@ -0,0 +1,96 @@
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace WM
+{
+    // A decoded window icon, uploaded to the server as a size x size pixmap.
+    // The pixmap is freed when the last reference goes away.
+    class Icon
+    {
+    public: // Public
+        Icon(Display* connection, Pixmap pixmap, unsigned int size)
+          : m_connection{connection}, m_pixmap{pixmap}, m_size{size}
+        {
+
+        }
+
+        ~Icon();
+
+        Icon(const Icon&) = delete;
+        Icon& operator=(const Icon&) = delete;
+
+        Pixmap GetPixmap() const { return m_pixmap; }
+        unsigned int GetSize() const { return m_size; }
+
+    private: // Private
+        // Connection that owns the pixmap.
+        Display* m_connection;
+        Pixmap m_pixmap;
+        unsigned int m_size;
+    };
+
+    // Identifies icon content independently of the window it came from, so
+    // every terminal of the same program shares one pixmap.
+    struct IconKey
+    {
+        // WM_CLASS class name.
+        std::string m_class;
+        // Hash of the chosen _NET_WM_ICON image, including its dimensions.
+        std::uint64_t m_hash;
+        // Background the icon was flattened onto.
+        std::uint32_t m_background;
+
+        bool operator == (const IconKey& other) const = default;
+    };
+
+    struct IconKeyHash
+    {
+        std::size_t operator () (const IconKey& key) const;
+    };
+
+    // Least recently used cache of decoded icons. Not thread safe, it is only
+    // touched by the icon loader thread.
+    class IconCache
+    {
+    public: // Public
+        explicit IconCache(std::size_t capacity)
+          : m_capacity{capacity}
+        {
+
+        }
+
+        // Returns the cached icon and marks it as most recently used, or
+        // nullptr on a miss.
+        std::shared_ptr<const Icon> Find(const IconKey& key);
+
+        // Inserts an icon, evicting the least recently used one if the cache
+        // is full. Evicted icons stay alive while clients still use them.
+        void Insert(const IconKey& key, std::shared_ptr<const Icon> icon);
+
+        void Clear();
+
+        std::size_t GetSize() const { return m_entries.size(); }
+
+    private: // Private
+        using Entry = std::pair<IconKey, std::shared_ptr<const Icon>>;
+
+        std::size_t m_capacity;
+        // Most recently used entries first.
+        std::list<Entry> m_entries{};
+        std::unordered_map<IconKey, std::list<Entry>::iterator, IconKeyHash> m_index{};
+    };
+}
+
+#endif
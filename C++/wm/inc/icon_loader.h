@@ -0,0 +1,101 @@
+#ifndef ICON_LOADER_H
+#define ICON_LOADER_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "icon_cache.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace WM
+{
+    // Fetches and decodes _NET_WM_ICON off the event loop.
+    //
+    // The loader owns a second connection to the X server and a worker thread.
+    // The worker reads the icon property, picks the image closest to the icon
+    // size, premultiplies and downscales it and uploads the result to a pixmap.
+    // Finished icons are queued and the notify fd becomes readable, so the
+    // event loop only ever picks up ready pixmaps.
+    //
+    // Icons are freed from whichever thread drops the last reference, so
+    // XInitThreads() must have been called.
+    class IconLoader
+    {
+    public: // Public types
+        struct Result
+        {
+            Window m_client;
+            // nullptr if the client has no usable icon.
+            std::shared_ptr<const Icon> m_icon;
+        };
+
+    public: // Public methods
+        // Icons are size x size pixels, flattened onto background (0xRRGGBB).
+        IconLoader(const std::string& displayName, unsigned int size, std::uint32_t background);
+
+        // Stops the worker and closes its connection.
+        ~IconLoader();
+
+        IconLoader(const IconLoader&) = delete;
+        IconLoader& operator=(const IconLoader&) = delete;
+
+        // Queues a client window for loading.
+        void Request(Window client);
+
+        // Changes the background icons are flattened onto, for icons loaded
+        // from now on.
+        void SetBackground(std::uint32_t background) { m_background = background; }
+
+        // Becomes readable when results are waiting in TakeResults().
+        int GetNotifyFd() const { return m_notifyFd; }
+
+        // Returns and clears the finished results.
+        std::vector<Result> TakeResults();
+
+    private: // Private methods
+        void WorkerMain();
+
+        // Runs on the worker thread.
+        std::shared_ptr<const Icon> Load(Window client);
+
+        // Uploads flattened size x size pixels to a new pixmap.
+        Pixmap Upload(std::vector<std::uint32_t>& pixels);
+
+    private: // Private variables
+        // The worker's own connection, never used by the event loop.
+        Display* m_connection;
+        Window m_rootWindow;
+        GC m_gc;
+        Atom NET_WM_ICON;
+
+        unsigned int m_size;
+        std::atomic<std::uint32_t> m_background;
+
+        // Only used by the worker thread.
+        IconCache m_cache;
+
+        // eventfd signalled when results are available.
+        int m_notifyFd;
+
+        std::mutex m_mutex{};
+        std::condition_variable m_wakeup{};
+        std::deque<Window> m_jobs{};
+        std::vector<Result> m_results{};
+        bool m_stop{false};
+
+        // Started last, once everything above is initialised.
+        std::thread m_worker{};
+    };
+}
+
+#endif
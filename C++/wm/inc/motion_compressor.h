@@ -0,0 +1,71 @@
+#ifndef MOTION_COMPRESSOR_H
+#define MOTION_COMPRESSOR_H
+
+#include "x_backend.h"
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace WM
+{
+    // Thins out pointer motion to at most one sample per device per frame
+    // interval, so a 1000 Hz mouse moves a frame as often as the screen can
+    // show it rather than on every sample.
+    //
+    // A sample a full interval after the last one delivered, by server time,
+    // is delivered at once. Samples arriving sooner replace the device's
+    // pending one, which is delivered when its interval is over unless a
+    // newer sample comes first. Nothing is dropped for good: the newest
+    // sample always ends up delivered.
+    class MotionCompressor
+    {
+    public: // Public types
+        using Clock = std::chrono::steady_clock;
+
+    public: // Public methods
+        // interval is in server time units, milliseconds.
+        explicit MotionCompressor(Time interval = 8);
+
+        // Returns whether sample is due now. If it isn't, it's kept as its
+        // device's pending sample.
+        bool Push(const PointerEvent& sample, Clock::time_point now);
+
+        // Appends the pending samples whose interval is over to due.
+        void TakeDue(Clock::time_point now, std::vector<PointerEvent>& due);
+
+        // Removes and returns the pending sample of a device, e.g. when its
+        // button is released.
+        std::optional<PointerEvent> TakePending(int device);
+
+        // Time until TakeDue has something, std::nullopt if nothing is
+        // pending.
+        std::optional<Clock::duration> GetTimeout(Clock::time_point now) const;
+
+        // Samples pushed and delivered so far.
+        std::size_t GetPushedCount() const { return m_pushedCount; }
+        std::size_t GetDeliveredCount() const { return m_deliveredCount; }
+
+    private: // Private types
+        struct Device
+        {
+            int m_id{0};
+            // Server time of the last sample delivered.
+            std::optional<Time> m_lastDelivered{};
+            std::optional<PointerEvent> m_pending{};
+            Clock::time_point m_deadline{};
+        };
+
+    private: // Private methods
+        Device& FindDevice(int id);
+
+    private: // Private variables
+        Time m_interval;
+        // One entry per pointer seen, there are rarely more than two.
+        std::vector<Device> m_devices{};
+
+        std::size_t m_pushedCount{0};
+        std::size_t m_deliveredCount{0};
+    };
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PIXEL_OPS_H
+#define PIXEL_OPS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel kernels for 32 bit ARGB images (0xAARRGGBB in host order, the layout
+// used by _NET_WM_ICON). Every kernel has a scalar implementation and, on x86,
+// SSE2 and AVX2 versions which are picked once at runtime.
+namespace WM::Pixel
+{
+    // Multiplies the colour channels of every pixel by its alpha channel.
+    void PremultiplyArgb(std::uint32_t* pixels, std::size_t count);
+
+    // Halves an image in both dimensions with a 2x2 box filter. The source
+    // must be premultiplied, dst must hold (width / 2) * (height / 2) pixels.
+    // An odd last row or column is dropped.
+    void HalveArgb(const std::uint32_t* src, unsigned int width, unsigned int height, std::uint32_t* dst);
+
+    // Resamples a premultiplied image to an arbitrary size with bilinear
+    // filtering. Meant for the last, small step after HalveArgb.
+    void ResampleArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                      std::uint32_t* dst, unsigned int dst_width, unsigned int dst_height);
+
+    // Composites premultiplied pixels over an opaque 0xRRGGBB background, the
+    // result has no alpha and can be uploaded to a 24 bit pixmap.
+    void FlattenArgb(std::uint32_t* pixels, std::size_t count, std::uint32_t background);
+
+    // Premultiplies, downscales and flattens an ARGB image into a size x size
+    // square, preserving the aspect ratio and centering the image.
+    void ScaleIconArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                       std::uint32_t* dst, unsigned int size, std::uint32_t background);
+
+    // Downscales the contents of a window, opaque whatever their alpha byte
+    // says, into a box_width x box_height box, preserving the aspect ratio,
+    // centered on the background.
+    void ScaleThumbnailArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                            std::uint32_t* dst, unsigned int box_width, unsigned int box_height,
+                            std::uint32_t background);
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "util.h"
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace WM
+{
+    // Finds positions for new windows that overlap the existing ones the
+    // least.
+    //
+    // The free space of every output is kept as its set of maximal empty
+    // rectangles: empty rectangles that can't grow in any direction without
+    // covering a window. A new window goes to the top-left-most one it fits
+    // in, and if there is none, to the candidate position with the smallest
+    // overlap area.
+    //
+    // The rectangles are updated incrementally. Adding a window splits the
+    // free rectangles it covers. Removing one only recomputes the free
+    // rectangles touching it, inside the bounding box of those it replaces,
+    // which is enough: any maximal rectangle that doesn't touch the removed
+    // window was maximal before as well.
+    class Placement
+    {
+    public: // Public methods
+        // Sets the outputs windows are placed on, and recomputes the free
+        // space for the windows already added.
+        void SetOutputs(const std::vector<Rect<int>>& outputs);
+
+        // Adds, moves or removes a window, with its outer geometry.
+        void Add(Window w, const Rect<int>& rect);
+        void Move(Window w, const Rect<int>& rect);
+        void Remove(Window w);
+
+        // Returns the geometry a window was added with, if it was.
+        std::optional<Rect<int>> GetRect(Window w) const;
+
+        // Returns where to put a new window of this outer size. The output
+        // containing near is tried first.
+        Position<int> Place(const Size<int>& size, const Position<int>& near) const;
+
+        // Number of maximal empty rectangles, over all outputs.
+        std::size_t GetFreeRectCount() const;
+
+        // The windows added, and their geometry at the same indices.
+        const std::vector<Window>& GetWindows() const { return m_windows; }
+        const RectArray& GetRects() const { return m_rects; }
+        const std::vector<Rect<int>>& GetOutputs() const { return m_outputs; }
+
+        // Changes whenever a window or output geometry does, so users can
+        // tell when what they derived from it is out of date.
+        std::uint64_t GetGeneration() const { return m_generation; }
+
+    private: // Private methods
+        void Occupy(const Rect<int>& rect);
+        void Release(const Rect<int>& rect);
+
+        // Returns the position with the least overlap, when nothing fits.
+        Position<int> PlaceOverlapping(const Size<int>& size, std::size_t first_output) const;
+
+    private: // Private variables
+        std::vector<Rect<int>> m_outputs{};
+        // Maximal empty rectangles, per output.
+        std::vector<RectArray> m_free{};
+
+        // Window geometry, in the layout the batch kernels want.
+        RectArray m_rects{};
+        std::vector<Window> m_windows{};
+        std::unordered_map<Window, std::size_t> m_indices{};
+
+        std::uint64_t m_generation{0};
+    };
+}
+
+#endif
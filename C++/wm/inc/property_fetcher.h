@@ -0,0 +1,47 @@
+#ifndef PROPERTY_FETCHER_H
+#define PROPERTY_FETCHER_H
+
+#include "x_backend.h"
+#include <string>
+#include <vector>
+
+struct xcb_connection_t;
+
+namespace WM
+{
+    // Reads window properties in pipelined batches.
+    //
+    // Xlib waits for the reply of every XGetWindowProperty before sending the
+    // next request. This class sends all requests of a batch over XCB and
+    // only then collects the replies, so a batch costs a single round trip
+    // however many properties it reads.
+    //
+    // The XCB connection is preferably the one under the Xlib display, then
+    // a batch is ordered after every Xlib request made before it. Otherwise
+    // it is a connection of its own, and the caller must sync the display
+    // first for that. Atoms are server wide, so atoms interned through Xlib
+    // can be used either way.
+    class PropertyFetcher
+    {
+    public: // Public methods
+        // Borrows the connection, it stays owned by its display.
+        explicit PropertyFetcher(xcb_connection_t* connection);
+        // Opens a connection of its own.
+        explicit PropertyFetcher(const std::string& displayName);
+
+        ~PropertyFetcher();
+
+        PropertyFetcher(const PropertyFetcher&) = delete;
+        PropertyFetcher& operator=(const PropertyFetcher&) = delete;
+
+        // Reads all requested properties with one round trip. Replies are in
+        // request order.
+        std::vector<PropertyReply> Fetch(const std::vector<PropertyRequest>& requests);
+
+    private: // Private variables
+        xcb_connection_t* m_connection;
+        bool m_owned;
+    };
+}
+
+#endif
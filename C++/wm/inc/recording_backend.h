@@ -0,0 +1,92 @@
+#ifndef RECORDING_BACKEND_H
+#define RECORDING_BACKEND_H
+
+#include "trace.h"
+#include "x_backend.h"
+#include <memory>
+#include <string>
+
+namespace WM
+{
+    // Records a session to a trace while forwarding to another backend.
+    //
+    // Every event handed to the window manager and every request it makes is
+    // written to a TraceWriter, which wm_replay reads back. The trace is
+    // written out whenever the window manager is about to go idle.
+    class RecordingBackend : public XBackend
+    {
+    public: // Public methods
+        // Records to path. Throws std::runtime_error if it can't be created.
+        RecordingBackend(std::unique_ptr<XBackend> backend, const std::string& path);
+
+        RecordingBackend(const RecordingBackend&) = delete;
+        RecordingBackend& operator=(const RecordingBackend&) = delete;
+
+        std::optional<std::string> GetDisplayName() const override;
+        Window GetRootWindow() const override;
+        Atom InternAtom(const std::string& name) override;
+        void RedirectRoot(long event_mask) override;
+        void SetPhase(const char* name) override;
+
+        int GetConnectionFd() const override;
+        bool Pending() override;
+        void NextEvent(XEvent& e) override;
+        bool CheckTypedWindowEvent(Window w, int type, XEvent& e) override;
+        void Flush() override;
+        void Sync() override;
+
+        bool GrabPointerMotion(Window w, Time time) override;
+        void UngrabPointerMotion(Time time) override;
+        bool GetPointerEvent(XEvent& e, PointerEvent& pointer) override;
+
+        void GrabServer() override;
+        void UngrabServer() override;
+        std::vector<Window> QueryTree(Window w) override;
+        bool GetWindowAttributes(Window w, XWindowAttributes& attributes) override;
+        bool GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height) override;
+
+        Window CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                  unsigned int border_width, unsigned long border, unsigned long background) override;
+        void DestroyWindow(Window w) override;
+        void SelectInput(Window w, long event_mask) override;
+        void ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes) override;
+        void MapWindow(Window w) override;
+        void UnmapWindow(Window w) override;
+        void ReparentWindow(Window w, Window parent, int x, int y) override;
+        void AddToSaveSet(Window w) override;
+        void RemoveFromSaveSet(Window w) override;
+
+        void ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes) override;
+        void MoveWindow(Window w, int x, int y) override;
+        void ResizeWindow(Window w, unsigned int width, unsigned int height) override;
+        void RaiseWindow(Window w) override;
+
+        void SetWindowBorderWidth(Window w, unsigned int width) override;
+        void SetWindowBorder(Window w, unsigned long pixel) override;
+        void SetWindowBackground(Window w, unsigned long pixel) override;
+        void ClearWindow(Window w) override;
+        void CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                      unsigned int width, unsigned int height, int dst_x, int dst_y) override;
+
+        void GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask) override;
+        void GrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        void UngrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        bool GrabKeyboard(Window w, Time time) override;
+        void UngrabKeyboard(Time time) override;
+        KeyCode KeysymToKeycode(KeySym keysym) override;
+
+        void SetInputFocus(Window w) override;
+        void KillClient(Window w) override;
+        bool SendEvent(Window w, long event_mask, XEvent& e) override;
+
+        std::vector<PropertyReply> GetProperties(const std::vector<PropertyRequest>& requests) override;
+        void ChangeProperty(Window w, Atom property, Atom type, int format,
+                            const unsigned char* data, int num_items) override;
+
+    private: // Private variables
+        std::unique_ptr<XBackend> m_backend;
+        TraceWriter m_writer;
+    };
+}
+
+#endif
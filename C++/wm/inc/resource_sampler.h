@@ -0,0 +1,111 @@
+#ifndef RESOURCE_SAMPLER_H
+#define RESOURCE_SAMPLER_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct xcb_connection_t;
+
+namespace WM
+{
+    // Server resources held by one client at one point in time.
+    struct ResourceSample
+    {
+        std::chrono::steady_clock::time_point m_time{};
+        // Pixmap memory, as the server estimates it.
+        std::uint64_t m_pixmapBytes{0};
+        std::uint32_t m_pixmapCount{0};
+        // Resources of all types.
+        std::uint32_t m_resourceCount{0};
+    };
+
+    // The last few samples of a client, oldest overwritten first.
+    class ResourceHistory
+    {
+    public: // Public methods
+        void Push(const ResourceSample& sample);
+
+        bool IsEmpty() const { return m_size == 0; }
+        const ResourceSample& GetLatest() const;
+        const ResourceSample& GetOldest() const;
+
+        // Change in pixmap bytes from the oldest sample to the latest.
+        std::int64_t GetPixmapGrowth() const;
+
+    private: // Private variables
+        std::array<ResourceSample, 32> m_samples{};
+        std::size_t m_size{0};
+        std::size_t m_next{0};
+    };
+
+    // Samples the resources of clients with the X-Resource extension.
+    //
+    // Queries go out on a connection of their own, every client's queries in
+    // one batch, and replies are picked up as they arrive: nothing waits for
+    // the server after construction. A new batch is only sent once the last
+    // one is complete and the sampling interval is over.
+    class ResourceSampler
+    {
+    public: // Public types
+        using Clock = std::chrono::steady_clock;
+
+    public: // Public methods
+        // Connects to displayName. Throws std::runtime_error if the display
+        // can't be opened.
+        explicit ResourceSampler(const std::string& displayName, Clock::duration interval = std::chrono::seconds(10));
+
+        ~ResourceSampler();
+
+        ResourceSampler(const ResourceSampler&) = delete;
+        ResourceSampler& operator=(const ResourceSampler&) = delete;
+
+        // Whether the server has X-Resource, nothing is sampled without.
+        bool IsAvailable() const { return m_available; }
+
+        // Readable when replies arrive, -1 if unavailable.
+        int GetFd() const;
+
+        // Sends queries for the clients owning these windows, if it is time.
+        void Request(const std::vector<Window>& windows, Clock::time_point now);
+
+        // Returns the samples completed since the last call. Never blocks.
+        std::vector<std::pair<Window, ResourceSample>> Collect();
+
+        // Time until Request sends again, std::nullopt while a batch is out.
+        std::optional<Clock::duration> GetTimeout(Clock::time_point now) const;
+
+    private: // Private types
+        // The queries for one window.
+        struct Pending
+        {
+            Window m_window;
+            unsigned int m_resourcesRequest;
+            unsigned int m_pixmapBytesRequest;
+            std::optional<ResourceSample> m_sample{};
+            bool m_resourcesDone{false};
+            bool m_pixmapBytesDone{false};
+        };
+
+    private: // Private variables
+        xcb_connection_t* m_connection;
+        bool m_available{false};
+        // Resource type of pixmaps, an atom.
+        std::uint32_t m_pixmapType{0};
+
+        Clock::duration m_interval;
+        Clock::time_point m_lastRequest{};
+        std::vector<Pending> m_pending{};
+    };
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace WM
+{
+    // What a matching rule does to a window when it is framed.
+    struct RuleActions
+    {
+        // Workspace to put the window on.
+        std::optional<int> m_workspace{};
+        // Keep the window out of any layout.
+        bool m_floating{false};
+        // Keep the window above the others.
+        bool m_above{false};
+
+        // Overrides the actions set by other.
+        void Merge(const RuleActions& other);
+    };
+
+    // A single parsed rule. Every condition that is set must match.
+    struct Rule
+    {
+        // Exact WM_CLASS class name.
+        std::optional<std::string> m_class{};
+        // Exact WM_CLASS instance name.
+        std::optional<std::string> m_instance{};
+        // Glob pattern on the title, '*' matches any run and '?' any byte.
+        std::optional<std::string> m_title{};
+
+        RuleActions m_actions{};
+    };
+
+    // The properties rules are matched against.
+    struct WindowIdentity
+    {
+        std::string m_class{};
+        std::string m_instance{};
+        std::string m_title{};
+    };
+
+    // Returns whether text matches a glob pattern.
+    bool GlobMatch(std::string_view pattern, std::string_view text);
+
+    // A compiled set of window rules.
+    //
+    // Rules are indexed by class or instance name in hash tables. Title
+    // patterns can't be hashed, instead the longest literal run of every
+    // pattern goes into one Aho-Corasick automaton, so a single pass over the
+    // title finds every title rule that can possibly match. Only those
+    // candidates are checked in full, which keeps the cost of Match close to
+    // constant however many rules there are.
+    class RuleSet
+    {
+    public: // Public methods
+        RuleSet() = default;
+
+        explicit RuleSet(std::vector<Rule> rules);
+
+        // Parses rules, one per line:
+        //
+        //     class=Firefox -> workspace=2 floating
+        //     title=*Picture-in-Picture* -> above
+        //
+        // Conditions are class=, instance= and title=, actions are
+        // workspace=N, floating and above. '#' starts a comment. Throws
+        // std::runtime_error on syntax errors.
+        static RuleSet Parse(std::string_view text);
+
+        // Returns the merged actions of all matching rules, later rules
+        // taking precedence.
+        RuleActions Match(const WindowIdentity& window) const;
+
+        std::size_t GetSize() const { return m_rules.size(); }
+
+    private: // Private types
+        // Aho-Corasick automaton over a reduced byte alphabet. The transition
+        // table is complete (a DFA), so matching is one lookup per byte.
+        class Automaton
+        {
+        public: // Public
+            // Adds a pattern, reported as id when found.
+            void Add(std::string_view pattern, std::uint32_t id);
+
+            // Builds failure links and the transition table.
+            void Compile();
+
+            // Appends the ids of all patterns occurring in text.
+            void FindAll(std::string_view text, std::vector<std::uint32_t>& out) const;
+
+            bool IsEmpty() const { return m_patterns.empty(); }
+
+        private: // Private
+            std::vector<std::pair<std::string, std::uint32_t>> m_patterns{};
+
+            // Maps bytes to alphabet classes, class 0 is "not in any pattern".
+            std::array<std::uint8_t, 256> m_classOf{};
+            std::size_t m_numClasses{0};
+            // m_next[state * m_numClasses + class]
+            std::vector<std::uint32_t> m_next{};
+            // Pattern ids ending in each state, flattened.
+            std::vector<std::uint32_t> m_outputStart{};
+            std::vector<std::uint32_t> m_outputs{};
+        };
+
+    private: // Private variables
+        std::vector<Rule> m_rules{};
+
+        // Rules keyed by their class, or by instance if they have no class.
+        std::unordered_map<std::string, std::vector<std::uint32_t>> m_byClass{};
+        std::unordered_map<std::string, std::vector<std::uint32_t>> m_byInstance{};
+        // Rules with only a title condition, found through the automaton.
+        Automaton m_titles{};
+        // Rules that have to be checked for every window: no condition at
+        // all, or a title pattern without any literal run.
+        std::vector<std::uint32_t> m_always{};
+    };
+}
+
+#endif
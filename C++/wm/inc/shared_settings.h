@@ -0,0 +1,66 @@
+#ifndef SHARED_SETTINGS_H
+#define SHARED_SETTINGS_H
+
+#include "config.h"
+#include "config_watcher.h"
+#include "rules.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace WM
+{
+    // What the configuration directory holds.
+    struct Settings
+    {
+        Config m_config{};
+        RuleSet m_rules{};
+    };
+
+    // Settings loaded once and shared by every display the process manages.
+    //
+    // Each snapshot is immutable. A window manager keeps the one it last
+    // took, and reads it without locking; the generation tells it when to
+    // take a newer one. Only reloads and taking a snapshot lock.
+    class SharedSettings
+    {
+    public: // Public methods
+        // Loads the settings from directory and watches it.
+        explicit SharedSettings(const std::string& directory);
+
+        SharedSettings(const SharedSettings&) = delete;
+        SharedSettings& operator=(const SharedSettings&) = delete;
+
+        // Readable when files changed, shared by every window manager.
+        int GetFd() const { return m_watcher.GetFd(); }
+
+        // Reloads the files that changed. The first caller does the work,
+        // the others find nothing left to read. Never blocks on the disk
+        // watcher.
+        void Refresh();
+
+        // Bumped each time a new snapshot is published.
+        std::uint64_t GetGeneration() const { return m_generation.load(std::memory_order_acquire); }
+
+        // The current snapshot.
+        std::shared_ptr<const Settings> Get() const;
+
+    private: // Private methods
+        // Reads and parses a file, keeping current if it is missing or
+        // broken. Returns whether it was replaced.
+        bool LoadConfig(Config& config) const;
+        bool LoadRules(RuleSet& rules) const;
+
+    private: // Private variables
+        std::string m_directory;
+        ConfigWatcher m_watcher;
+
+        mutable std::mutex m_mutex{};
+        std::shared_ptr<const Settings> m_settings{};
+        std::atomic<std::uint64_t> m_generation{0};
+    };
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SIGNAL_WATCHER_H
+#define SIGNAL_WATCHER_H
+
+namespace WM
+{
+    // Turns a signal into a readable file descriptor with signalfd, so the
+    // event loop can wait for it like for anything else.
+    //
+    // The signal is blocked in the calling thread. Create the watcher before
+    // starting other threads, they inherit the mask and won't take the signal
+    // either.
+    class SignalWatcher
+    {
+    public: // Public methods
+        explicit SignalWatcher(int signal);
+
+        ~SignalWatcher();
+
+        SignalWatcher(const SignalWatcher&) = delete;
+        SignalWatcher& operator=(const SignalWatcher&) = delete;
+
+        // Readable when the signal arrived, -1 if it can't be watched.
+        int GetFd() const { return m_fd; }
+
+        // Returns whether the signal arrived since the last call. Never
+        // blocks.
+        bool ReadSignals();
+
+    private: // Private variables
+        int m_fd;
+    };
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SWITCHER_H
+#define SWITCHER_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include "util.h"
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace WM
+{
+    // Layout and selection of the window switcher.
+    //
+    // Only the book keeping is here, the window manager draws the overlay:
+    // thumbnails in a grid centered on the output, scrolled by rows so the
+    // selection stays visible when there are more clients than fit.
+    class Switcher
+    {
+    public: // Public methods
+        // Cells are cell_width x cell_height, padding apart.
+        Switcher(unsigned int cell_width, unsigned int cell_height, unsigned int padding);
+
+        // Opens on clients in switching order, the first being the current
+        // one. Selects the next.
+        void Open(std::vector<Window> clients, const Rect<int>& output);
+        void Close();
+        bool IsOpen() const { return m_open; }
+
+        // Selects the next client, wrapping around. Returns whether the
+        // visible rows changed.
+        bool Next();
+
+        // Forgets a client that went away. Returns whether it was shown.
+        bool Remove(Window client);
+
+        // None if there are no clients.
+        Window GetSelected() const;
+        std::size_t GetSelectedIndex() const { return m_selected; }
+        const std::vector<Window>& GetClients() const { return m_clients; }
+        std::optional<std::size_t> Find(Window client) const;
+
+        // The overlay, in root coordinates.
+        const Rect<int>& GetBounds() const { return m_bounds; }
+
+        // Where cell i is in the overlay, std::nullopt if scrolled out.
+        std::optional<Position<int>> GetCellPosition(std::size_t i) const;
+
+    private: // Private methods
+        // Sizes the overlay for the clients and the output.
+        void Layout();
+
+        // Scrolls so the selection is visible. Returns whether it scrolled.
+        bool Scroll();
+
+    private: // Private variables
+        unsigned int m_cellWidth;
+        unsigned int m_cellHeight;
+        unsigned int m_padding;
+
+        bool m_open{false};
+        std::vector<Window> m_clients{};
+        std::size_t m_selected{0};
+        Rect<int> m_output{};
+
+        Rect<int> m_bounds{};
+        std::size_t m_columns{1};
+        std::size_t m_visibleRows{1};
+        std::size_t m_firstRow{0};
+    };
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef THUMBNAILER_H
+#define THUMBNAILER_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct xcb_connection_t;
+
+namespace WM
+{
+    // Live window thumbnails for the switcher, rendered off the event loop.
+    //
+    // The thumbnailer owns a connection and a worker thread. It redirects
+    // the top-level windows with Composite, so their contents are kept even
+    // when covered, and tracks each with a DAMAGE object, so only windows
+    // drawn to since their last thumbnail are captured again. Captures are
+    // downscaled in software, so it works on a server without GPU.
+    //
+    // Thumbnails are only rendered while shown, a frame at a time: each
+    // frame captures dirty windows in the order given to Show until its time
+    // budget is spent, the rest waits for the next frame. Updated thumbnails
+    // are queued and the notify fd becomes readable.
+    class Thumbnailer
+    {
+    public: // Public types
+        using Clock = std::chrono::steady_clock;
+
+        struct Update
+        {
+            Window m_client;
+            // width x height, at the depth of the root window. Owned by the
+            // thumbnailer until Remove.
+            Pixmap m_pixmap;
+        };
+
+    public: // Public methods
+        // Thumbnails are width x height, on background (0xRRGGBB). Throws
+        // std::runtime_error if the display can't be opened.
+        Thumbnailer(const std::string& displayName, unsigned int width, unsigned int height, std::uint32_t background,
+                    Clock::duration frame_interval = std::chrono::milliseconds(16),
+                    Clock::duration frame_budget = std::chrono::milliseconds(4));
+
+        // Stops the worker and closes its connection, which frees every
+        // thumbnail.
+        ~Thumbnailer();
+
+        Thumbnailer(const Thumbnailer&) = delete;
+        Thumbnailer& operator=(const Thumbnailer&) = delete;
+
+        // Whether the server has Composite and DAMAGE, there are no
+        // thumbnails without.
+        bool IsAvailable() const { return m_available; }
+
+        // Starts tracking a client, whose contents are in the top-level
+        // window, its frame or itself.
+        void Add(Window client, Window top_level);
+
+        // Stops tracking a client and frees its thumbnail.
+        void Remove(Window client);
+
+        // Renders thumbnails of clients, in this order, until Hide.
+        void Show(std::vector<Window> clients);
+        void Hide();
+
+        // Becomes readable when updates are waiting in TakeUpdates().
+        int GetNotifyFd() const { return m_notifyFd; }
+
+        // Returns and clears the updated thumbnails.
+        std::vector<Update> TakeUpdates();
+
+    private: // Private types
+        // A tracked client, only touched by the worker.
+        struct Entry
+        {
+            Window m_topLevel;
+            std::uint32_t m_damage;
+            Pixmap m_pixmap{None};
+            // Drawn to since the last thumbnail.
+            bool m_dirty{true};
+        };
+
+        struct Command
+        {
+            Window m_client;
+            // None to remove the client.
+            Window m_topLevel;
+        };
+
+    private: // Private methods
+        void WorkerMain();
+
+        // Runs on the worker thread. Applies queued commands, returns false
+        // once stopped.
+        bool TakeCommands();
+
+        // Marks windows reported by DAMAGE as dirty.
+        void ReadDamage();
+
+        // Captures dirty clients until deadline, at least one.
+        void RenderFrame(Clock::time_point deadline);
+
+        // Captures a client's top-level window and uploads its thumbnail.
+        // Returns false if the window can't be read, e.g. it's unmapped.
+        bool Capture(Entry& entry);
+
+        bool HasDirty() const;
+
+    private: // Private variables
+        xcb_connection_t* m_connection;
+        std::uint32_t m_rootWindow{0};
+        std::uint8_t m_rootDepth{0};
+        std::uint32_t m_gc{0};
+        std::uint8_t m_damageEvent{0};
+        bool m_available{false};
+
+        unsigned int m_width;
+        unsigned int m_height;
+        std::uint32_t m_background;
+        Clock::duration m_frameInterval;
+        Clock::duration m_frameBudget;
+
+        // eventfds waking the worker, and signalled when updates are
+        // available.
+        int m_wakeFd;
+        int m_notifyFd;
+
+        std::mutex m_mutex{};
+        std::vector<Command> m_commands{};
+        std::vector<Window> m_shown{};
+        bool m_visible{false};
+        std::vector<Update> m_updates{};
+        bool m_stop{false};
+
+        // Only used by the worker thread.
+        std::unordered_map<Window, Entry> m_entries{};
+        std::unordered_map<std::uint32_t, Window> m_damages{};
+        std::vector<Window> m_order{};
+        bool m_active{false};
+        std::vector<std::uint32_t> m_pixels{};
+
+        // Started last, once everything above is initialised.
+        std::thread m_worker{};
+    };
+}
+
+#endif
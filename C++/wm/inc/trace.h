@@ -0,0 +1,139 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+}
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace WM
+{
+    // Binary traces of a window manager session.
+    //
+    // A trace starts with a TraceHeader, followed by records. Every record is
+    // a TraceRecordHeader and m_size bytes of payload:
+    //  - Event and CheckedEvent: the leading bytes of the XEvent, as many as
+    //    the struct of its type uses.
+    //  - Request: a TraceRequest, followed by the 32 bit ids the request
+    //    returned (the new window of CreateWindow, the children of QueryTree).
+    // Everything is in host byte order, a trace is only read on the machine
+    // type that wrote it.
+
+    enum class TraceRecordKind : std::uint8_t
+    {
+        // Returned by XBackend::NextEvent.
+        Event = 1,
+        // Returned by XBackend::CheckTypedWindowEvent, i.e. compressed into
+        // the Event before it.
+        CheckedEvent = 2,
+        // A request the window manager made.
+        Request = 3,
+    };
+
+    struct TraceHeader
+    {
+        char m_magic[8];
+        std::uint32_t m_version;
+        // sizeof(long), which decides the layout of XEvent.
+        std::uint32_t m_longSize;
+    };
+
+    struct TraceRecordHeader
+    {
+        // Nanoseconds since the start of the trace.
+        std::uint64_t m_time;
+        std::uint32_t m_size;
+        TraceRecordKind m_kind;
+        std::uint8_t m_reserved[3];
+    };
+
+    struct TraceRequest
+    {
+        // X protocol request code, see <X11/Xproto.h>.
+        std::uint8_t m_opcode;
+        std::uint8_t m_reserved[3];
+        // Window the request is about, None if there is none.
+        std::uint32_t m_window;
+    };
+
+    // Appends records to a trace file through a buffer, so recording costs a
+    // write(2) every few hundred events.
+    class TraceWriter
+    {
+    public: // Public methods
+        // Creates or truncates path. Throws std::runtime_error on failure.
+        explicit TraceWriter(const std::string& path);
+
+        // Flushes and closes the file.
+        ~TraceWriter();
+
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        void WriteEvent(TraceRecordKind kind, const XEvent& e);
+        void WriteRequest(std::uint8_t opcode, Window w, const std::vector<Window>& results = {});
+
+        // Writes out the buffer. Errors stop the recording rather than the
+        // window manager.
+        void Flush();
+
+    private: // Private methods
+        void Append(TraceRecordKind kind, const void* payload, std::size_t size,
+                    const void* extra = nullptr, std::size_t extra_size = 0);
+
+    private: // Private variables
+        int m_fd;
+        std::chrono::steady_clock::time_point m_start;
+        std::vector<unsigned char> m_buffer{};
+    };
+
+    // Reads a trace file through a read-only mapping.
+    class TraceReader
+    {
+    public: // Public types
+        struct Record
+        {
+            TraceRecordKind m_kind;
+            std::chrono::nanoseconds m_time;
+            const unsigned char* m_payload;
+            std::size_t m_size;
+
+            // Valid for Event and CheckedEvent records.
+            XEvent GetEvent() const;
+            // Valid for Request records.
+            TraceRequest GetRequest() const;
+            std::vector<Window> GetResults() const;
+        };
+
+    public: // Public methods
+        // Throws std::runtime_error if path can't be read or isn't a trace
+        // written on this machine type.
+        explicit TraceReader(const std::string& path);
+
+        ~TraceReader();
+
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        // Reads the record at offset and advances offset past it. Returns
+        // false at the end of the trace. Offsets start at GetBegin().
+        bool Read(std::size_t& offset, Record& record) const;
+
+        std::size_t GetBegin() const { return sizeof(TraceHeader); }
+
+    private: // Private variables
+        const unsigned char* m_data;
+        std::size_t m_size;
+    };
+
+    // Number of leading bytes of an XEvent its type uses.
+    std::size_t GetEventSize(int type);
+}
+
+#endif
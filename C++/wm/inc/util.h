@@ -5,8 +5,12 @@ extern "C"
 {
     #include <X11/Xlib.h>
 }
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <vector>
 
 // Represents a 2D size.
 template <typename T>
@@ -18,7 +22,7 @@ public: // Public
 
     Size() = default;
 
-    Size(T w, T h)
+    constexpr Size(T w, T h)
       : m_width{w}, m_height{h}
     {
 
@@ -43,7 +47,7 @@ public: // Public
 
     Position() = default;
 
-    Position(T x, T y)
+    constexpr Position(T x, T y)
     : m_x{x}, m_y{y}
     {
 
@@ -63,7 +67,7 @@ public: // Public
 
     Vector2D() = default;
 
-    Vector2D(T x, T y)
+    constexpr Vector2D(T x, T y)
     : m_x{x}, m_y{y}
     {
 
@@ -96,6 +100,131 @@ Size<T> operator + (const Vector2D<T> &v, const Size<T>& a);
 template <typename T>
 Size<T> operator - (const Size<T>& a, const Vector2D<T> &v);
 
+// Represents an axis aligned rectangle. Rectangles are half open: one at x
+// with width w covers the columns x to x + w - 1, so rectangles that only
+// share an edge don't intersect.
+template <typename T>
+class Rect
+{
+public: // Public
+    T m_x{};
+    T m_y{};
+    T m_width{};
+    T m_height{};
+
+    constexpr Rect() = default;
+
+    constexpr Rect(T x, T y, T w, T h)
+    : m_x{x}, m_y{y}, m_width{w}, m_height{h}
+    {
+
+    }
+
+    constexpr Rect(const Position<T>& pos, const Size<T>& size)
+    : m_x{pos.m_x}, m_y{pos.m_y}, m_width{size.m_width}, m_height{size.m_height}
+    {
+
+    }
+
+    constexpr Position<T> GetPosition() const { return Position<T>(m_x, m_y); }
+    constexpr Size<T> GetSize() const { return Size<T>(m_width, m_height); }
+
+    constexpr T GetLeft() const { return m_x; }
+    constexpr T GetTop() const { return m_y; }
+    // One past the last column and row.
+    constexpr T GetRight() const { return m_x + m_width; }
+    constexpr T GetBottom() const { return m_y + m_height; }
+
+    constexpr T GetArea() const { return IsEmpty() ? T{} : m_width * m_height; }
+    constexpr bool IsEmpty() const { return m_width <= T{} || m_height <= T{}; }
+
+    constexpr bool Contains(const Position<T>& pos) const;
+    constexpr bool Contains(const Rect& r) const;
+    constexpr bool Intersects(const Rect& r) const;
+
+    // Returns the rectangle moved, and shrunk if it is larger, to lie inside
+    // bounds.
+    constexpr Rect ClampedTo(const Rect& bounds) const;
+
+    constexpr bool operator == (const Rect& r) const = default;
+
+    std::string ToString() const;
+};
+
+// Outputs a Rect<T> as a string to a std::ostream.
+template <typename T>
+std::ostream& operator << (std::ostream& out, const Rect<T>& rect);
+
+// Rect operators. & is the intersection, an empty Rect if there is none. |
+// is the bounding rectangle, ignoring empty operands.
+template <typename T>
+constexpr Rect<T> operator & (const Rect<T>& a, const Rect<T>& b);
+template <typename T>
+constexpr Rect<T> operator | (const Rect<T>& a, const Rect<T>& b);
+template <typename T>
+constexpr Rect<T>& operator &= (Rect<T>& a, const Rect<T>& b);
+template <typename T>
+constexpr Rect<T>& operator |= (Rect<T>& a, const Rect<T>& b);
+template <typename T>
+constexpr Rect<T> operator + (const Rect<T>& a, const Vector2D<T>& v);
+template <typename T>
+constexpr Rect<T> operator - (const Rect<T>& a, const Vector2D<T>& v);
+template <typename T>
+constexpr Rect<T>& operator += (Rect<T>& a, const Vector2D<T>& v);
+template <typename T>
+constexpr Rect<T>& operator -= (Rect<T>& a, const Vector2D<T>& v);
+
+// Rectangles as a structure of arrays, the layout the batch kernels below
+// work on.
+class RectArray
+{
+public: // Public
+    std::size_t GetSize() const { return m_x.size(); }
+
+    void Reserve(std::size_t size);
+    void Clear();
+    void Resize(std::size_t size);
+
+    void Push(const Rect<int>& r);
+    void Set(std::size_t i, const Rect<int>& r);
+    Rect<int> Get(std::size_t i) const;
+
+    // Removes rectangle i by moving the last one into its place.
+    void SwapRemove(std::size_t i);
+
+    const int* GetX() const { return m_x.data(); }
+    const int* GetY() const { return m_y.data(); }
+    const int* GetWidth() const { return m_width.data(); }
+    const int* GetHeight() const { return m_height.data(); }
+    int* GetX() { return m_x.data(); }
+    int* GetY() { return m_y.data(); }
+    int* GetWidth() { return m_width.data(); }
+    int* GetHeight() { return m_height.data(); }
+
+private: // Private
+    std::vector<int> m_x{};
+    std::vector<int> m_y{};
+    std::vector<int> m_width{};
+    std::vector<int> m_height{};
+};
+
+// Batch kernels testing one rectangle against many. Each has a scalar
+// implementation and, on x86, SSE4.1 and AVX2 versions picked once at
+// runtime. Widths and heights are at most 65535, as in the X protocol.
+
+// Sets out[i] to r & rects[i]. out is resized to match rects.
+void IntersectRects(const Rect<int>& r, const RectArray& rects, RectArray& out);
+
+// Moves, and shrinks if needed, every rectangle to lie inside bounds.
+void ClampRects(const Rect<int>& bounds, RectArray& rects);
+
+// Writes the indices of the rectangles intersecting r to indices, which
+// must have room for rects.GetSize() entries. Returns the number written.
+std::size_t FindIntersecting(const Rect<int>& r, const RectArray& rects, std::uint32_t* indices);
+
+// Returns the sum of the areas of r & rects[i].
+std::int64_t SumIntersectionAreas(const Rect<int>& r, const RectArray& rects);
+
 // Joins a container of elements into a single string, with elements separated
 // by a delimiter. Any element can be used as long as an operator << on ostream
 // is defined.
@@ -125,6 +254,13 @@ std::string XConfigureWindowValueMaskToString(unsigned long value_mask);
 // Returns the name of an X request code.
 std::string XRequestCodeToString(unsigned char request_code);
 
+// Returns the path of a file in the window manager's configuration directory,
+// $XDG_CONFIG_HOME/wm or ~/.config/wm.
+std::string ConfigPath(const std::string& name);
+
+// Reads a whole file, returns std::nullopt if it can't be opened.
+std::optional<std::string> ReadFile(const std::string& path);
+
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *                               IMPLEMENTATION                              *
@@ -202,7 +338,7 @@ Position<T> operator - (const Position<T>& a, const Vector2D<T> &v)
 template <typename T>
 Vector2D<T> operator - (const Size<T>& a, const Size<T>& b)
 {
-    return Vector2D<T>(a.width - b.m_width, a.m_height - b.m_height);
+    return Vector2D<T>(a.m_width - b.m_width, a.m_height - b.m_height);
 }
 
 template <typename T>
@@ -223,6 +359,114 @@ Size<T> operator - (const Size<T>& a, const Vector2D<T> &v)
     return Size<T>(a.m_width - v.m_x, a.m_height - v.m_y);
 }
 
+template <typename T>
+constexpr bool Rect<T>::Contains(const Position<T>& pos) const
+{
+    return pos.m_x >= m_x && pos.m_x < GetRight() && pos.m_y >= m_y && pos.m_y < GetBottom();
+}
+
+template <typename T>
+constexpr bool Rect<T>::Contains(const Rect& r) const
+{
+    return r.m_x >= m_x && r.GetRight() <= GetRight() && r.m_y >= m_y && r.GetBottom() <= GetBottom();
+}
+
+template <typename T>
+constexpr bool Rect<T>::Intersects(const Rect& r) const
+{
+    return !IsEmpty() && !r.IsEmpty()
+        && r.m_x < GetRight() && m_x < r.GetRight()
+        && r.m_y < GetBottom() && m_y < r.GetBottom();
+}
+
+template <typename T>
+constexpr Rect<T> Rect<T>::ClampedTo(const Rect& bounds) const
+{
+    const T width = std::min(m_width, bounds.m_width);
+    const T height = std::min(m_height, bounds.m_height);
+    return Rect<T>(std::clamp(m_x, bounds.m_x, bounds.GetRight() - width),
+                   std::clamp(m_y, bounds.m_y, bounds.GetBottom() - height),
+                   width, height);
+}
+
+template <typename T>
+std::string Rect<T>::ToString() const
+{
+    std::ostringstream out;
+    out << "(" << m_x << ", " << m_y << ") " << m_width << 'x' << m_height;
+    return out.str();
+}
+
+template <typename T>
+std::ostream& operator << (std::ostream& out, const Rect<T>& rect)
+{
+    return out << rect.ToString();
+}
+
+template <typename T>
+constexpr Rect<T> operator & (const Rect<T>& a, const Rect<T>& b)
+{
+    if (!a.Intersects(b))
+    {
+        return Rect<T>();
+    }
+    const T x = std::max(a.m_x, b.m_x);
+    const T y = std::max(a.m_y, b.m_y);
+    return Rect<T>(x, y, std::min(a.GetRight(), b.GetRight()) - x, std::min(a.GetBottom(), b.GetBottom()) - y);
+}
+
+template <typename T>
+constexpr Rect<T> operator | (const Rect<T>& a, const Rect<T>& b)
+{
+    if (a.IsEmpty())
+    {
+        return b;
+    }
+    if (b.IsEmpty())
+    {
+        return a;
+    }
+    const T x = std::min(a.m_x, b.m_x);
+    const T y = std::min(a.m_y, b.m_y);
+    return Rect<T>(x, y, std::max(a.GetRight(), b.GetRight()) - x, std::max(a.GetBottom(), b.GetBottom()) - y);
+}
+
+template <typename T>
+constexpr Rect<T>& operator &= (Rect<T>& a, const Rect<T>& b)
+{
+    return a = a & b;
+}
+
+template <typename T>
+constexpr Rect<T>& operator |= (Rect<T>& a, const Rect<T>& b)
+{
+    return a = a | b;
+}
+
+template <typename T>
+constexpr Rect<T> operator + (const Rect<T>& a, const Vector2D<T>& v)
+{
+    return Rect<T>(a.m_x + v.m_x, a.m_y + v.m_y, a.m_width, a.m_height);
+}
+
+template <typename T>
+constexpr Rect<T> operator - (const Rect<T>& a, const Vector2D<T>& v)
+{
+    return Rect<T>(a.m_x - v.m_x, a.m_y - v.m_y, a.m_width, a.m_height);
+}
+
+template <typename T>
+constexpr Rect<T>& operator += (Rect<T>& a, const Vector2D<T>& v)
+{
+    return a = a + v;
+}
+
+template <typename T>
+constexpr Rect<T>& operator -= (Rect<T>& a, const Vector2D<T>& v)
+{
+    return a = a - v;
+}
+
 template <typename Container>
 std::string Join(const Container& container, const ::std::string& delimiter)
 {
@@ -8,9 +8,30 @@ extern "C"
 }
 
 
+#include "client.h"
+#include "client_properties.h"
+#include "config.h"
+#include "configure_throttle.h"
+#include "edge_index.h"
+#include "event_scheduler.h"
+#include "focus_settle.h"
+#include "frame_pool.h"
+#include "hit_index.h"
+#include "icon_loader.h"
+#include "motion_compressor.h"
+#include "placement.h"
+#include "resource_sampler.h"
+#include "rules.h"
+#include "shared_settings.h"
+#include "signal_watcher.h"
+#include "switcher.h"
+#include "thumbnailer.h"
 #include "util.h"
+#include "x_backend.h"
 #include <memory>
+#include <ostream>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace WM
 {
@@ -18,23 +39,56 @@ namespace WM
     {
     private: // Private variables
 
-        // Handle to the underlying Xlib connection struct.
-        // TODO: rename it to connection
-        Display* m_connection;
+        // The X server, real or fake. Every request goes through it.
+        std::unique_ptr<XBackend> m_backend;
         // Handle to root window.
         Window m_rootWindow;
 
-        // Whether an existing window manager has been detected. Set by OnWMDetected,
-        // and hence must be static.
-        static bool m_wmDetected;
+        // Decodes window icons on its own thread and connection. Declared
+        // before m_clients, so clients release their icons first.
+        std::unique_ptr<IconLoader> m_iconLoader{};
+
+        // Maps top-level windows to their client records.
+        std::unordered_map<Window, Client> m_clients{};
+        // Maps frame windows back to the top-level window they contain.
+        std::unordered_map<Window, Window> m_frames{};
+        // Clients a rule keeps above the others.
+        std::unordered_set<Window> m_aboveClients{};
+
+        // Frame geometry, for placing new windows where they overlap the
+        // others the least.
+        Placement m_placement{};
+        // Edges of the outputs and frames, for snapping while dragging.
+        EdgeIndex m_edges{};
+
+        // Settings and window rules, shared with the window managers of
+        // other displays in this process.
+        std::shared_ptr<SharedSettings> m_sharedSettings;
+        // The snapshot in use, read without locking, and its generation.
+        std::shared_ptr<const Settings> m_settings{};
+        std::uint64_t m_settingsGeneration{0};
+        // The settings in effect, kept to diff newer snapshots against.
+        Config m_config{};
+
+        // Frames of unmapped clients, kept for the next ones.
+        FramePool m_framePool{};
+
+        // Asks for the stats.
+        std::unique_ptr<SignalWatcher> m_statsSignal{};
+
+        // Samples the server resources of every client on its own
+        // connection, for the stats.
+        std::unique_ptr<ResourceSampler> m_resourceSampler{};
+
+        // Renders live thumbnails for the switcher on its own thread and
+        // connection, if the server has Composite and DAMAGE.
+        std::unique_ptr<Thumbnailer> m_thumbnailer{};
+        // Layout and selection of the switcher, and its overlay with the
+        // marker around the selection, created on first use.
+        Switcher m_switcher;
+        Window m_switcherWindow{None};
+        Window m_switcherMarker{None};
 
-        // NEW
-        // A mutex for protecting m_wmDetected. It's not strictly speaking needed as
-        // this program is single threaded, but better safe than sorry.
-        static std::mutex m_wmDetectedMutex;
-
-        // Maps top-level windows to their frame windows.
-        std::unordered_map<Window, Window> m_clients;
 
         // The cursor position at the start of a window move/resize.
         Position<int> drag_start_pos_;
@@ -43,10 +97,40 @@ namespace WM
         Position<int> drag_start_frame_pos_;
         // The size of the affected window at the start of a window move/resize.
         Size<int> drag_start_frame_size_;
+        // Where the window move/resize has taken the frame so far.
+        Rect<int> m_dragFrameRect{};
+        // Whether the move/resize gets XInput2 motion rather than core.
+        bool m_pointerGrabbed{false};
+        // Holds back XInput2 motion to one sample per frame.
+        MotionCompressor m_motion{};
+
+        // Queued events, dispatched input first.
+        EventScheduler m_scheduler{};
+        // Holds back configure requests of clients asking too often.
+        ConfigureThrottle m_configureThrottle{};
+
+        // Focus follows the pointer once it settles, to the topmost frame
+        // under it.
+        HitIndex m_hitIndex{};
+        FocusSettle m_focusSettle{};
+        // The client last given the focus, and how many times it changed.
+        Window m_focusedClient{None};
+        std::size_t m_focusChangeCount{0};
+
+        // Cached client properties that changed, re-read together after
+        // the events that said so.
+        PropertyAtoms m_propertyAtoms{};
+        std::vector<std::pair<Window, Atom>> m_staleProperties{};
+        std::size_t m_propertyRefreshCount{0};
 
         // Atom constants.
         Atom WM_PROTOCOLS;
         Atom WM_DELETE_WINDOW;
+        Atom NET_WM_NAME;
+        Atom NET_WM_DESKTOP;
+        Atom UTF8_STRING;
+        Atom NET_WM_ICON;
+        Atom NET_WM_WINDOW_TYPE;
 
 
 
@@ -56,9 +140,6 @@ namespace WM
 
     private: // Private methods
 
-        // Create connection to X server
-        Display* createConnection(const std::string& displayName);
-
         // Remove copy semantics
         WindowManager(const WindowManager&) = delete;
         WindowManager& operator=(const WindowManager&) = delete;
@@ -68,22 +149,92 @@ namespace WM
         // Move assignment operator
         WindowManager& operator=(WindowManager&& wm);
 
-        // Xlib error handler. It must be static as its address is passed to Xlib.
-        static int OnXError(Display* display, XErrorEvent* e);
-
-        // Xlib error handler used to determine whether another window manager is
-        // running. It is set as the error handler right before selecting substructure
-        // redirection mask on the root window, so it is invoked if and only if
-        // another window manager is running. It must be static as its address is
-        // passed to Xlib.
-        static int OnWMDetected(Display* display, XErrorEvent* e);
-
         // Frame top level window
         void Frame(Window w, bool was_created_before_window_manager);
 
         // Unframe top level window
         void Unframe(Window w);
 
+        // Takes the newest settings snapshot and applies what changed to
+        // every client. New rules apply to windows framed from then on.
+        void OnSettingsChanged();
+        // m_config is already the new one, previous the one diff was made
+        // against.
+        void ApplyConfigDiff(const ConfigDiff& diff, const Config& previous);
+
+        // Grabs or releases key bindings on a client window.
+        void GrabKeys(Window w, const std::vector<KeyBinding>& bindings);
+        void UngrabKeys(Window w, const std::vector<KeyBinding>& bindings);
+
+        // Asks a client to close, or kills it if it doesn't support
+        // WM_DELETE_WINDOW.
+        void CloseClient(Window w);
+
+        // Raises and focuses the client after w.
+        void SwitchToNext(Window w);
+
+        // Shows the switcher with thumbnails of every client, w first and
+        // the next one selected, until the key binding's modifiers are
+        // released. Returns false if the keyboard can't be grabbed.
+        bool OpenSwitcher(Window w, Time time);
+        void CloseSwitcher(Time time);
+        void SelectNextInSwitcher();
+        // Draws every visible thumbnail, or one.
+        void DrawSwitcher();
+        void DrawThumbnail(std::size_t i);
+
+        // Picks up thumbnails rendered by the thumbnailer.
+        void OnThumbnailsReady();
+
+        // Returns where to put the frame of a new window, or nullopt if the
+        // client asked for its own position.
+        std::optional<Position<int>> PlaceFrame(const ClientProperties& properties, const XWindowAttributes& attrs);
+
+        // Re-reads the cached properties PropertyNotify said changed.
+        void RefreshProperties();
+
+        // Matches the window rules against a newly framed client and applies
+        // their actions.
+        void ApplyRules(Window w, Client& client);
+
+        // Raises a client's frame, keeping clients marked above on top.
+        void RaiseClient(Window w);
+
+        // Gives a client the input focus.
+        void FocusClient(Window w);
+
+        // Moves or resizes a client's frame to follow the pointer, depending
+        // on the button held in state.
+        void DragTo(Window w, double root_x, double root_y, unsigned int state);
+
+        // Ends a move/resize.
+        void EndDrag(Window w);
+
+        // Hands XInput2 motion held back by m_motion to DragTo once due.
+        void DeliverMotion();
+
+        // Grants configure requests held back by m_configureThrottle once
+        // due.
+        void DeliverConfigures();
+
+        // Focuses the client the pointer settled on, in the mouse focus
+        // mode.
+        void DeliverFocus();
+
+        // Moves and resizes a window, or its frame, as a client asked.
+        void ApplyConfigureRequest(const XConfigureRequestEvent& e);
+
+        // Draws the title bar decorations of a client's frame.
+        void DrawTitleBar(const Client& client);
+
+        // Picks up icons finished by the icon loader.
+        void OnIconsReady();
+
+        // Sends resource queries for every client when it's time, and
+        // stores the samples that came back.
+        void SampleResources();
+        void OnResourcesReady();
+
 
     //------------------------------------------------------------------//
     //                              Events                              //
@@ -116,20 +267,53 @@ namespace WM
     void OnButtonPress(const XButtonEvent& e);
     void OnButtonRelease(const XButtonEvent& e);
     void OnMotionNotify(const XMotionEvent& e);
+    // XInput2 motion and button release during a move/resize.
+    void OnPointerEvent(const PointerEvent& e);
     void OnKeyPress(const XKeyEvent& e);
     void OnKeyRelease(const XKeyEvent& e);
 
+    // Redraw frame decorations
+    void OnExpose(const XExposeEvent& e);
+
+    // The pointer entered a frame
+    void OnEnterNotify(const XCrossingEvent& e);
+
+    // A client changed one of its properties
+    void OnPropertyNotify(const XPropertyEvent& e);
+
 
 
     public: // Public methods
 
+        // Manages the display displayName, or $DISPLAY if it is empty.
         WindowManager(const std::string& displayName = std::string{});
 
+        // Manages the server behind backend, e.g. a FakeBackend. Window
+        // managers of several displays in one process share settings, by
+        // default they're loaded for this one alone.
+        explicit WindowManager(std::unique_ptr<XBackend> backend,
+                               std::shared_ptr<SharedSettings> settings = nullptr);
+
         // Disconnects from the X server.
         ~WindowManager();
         // The entry point to this class. Enters the main event loop.
         void Run();
 
+        // Takes over the root window and frames existing windows. Run() does
+        // this first, it is public so the handlers can be driven directly.
+        void Start();
+
+        // Dispatches a single event to its handler.
+        void HandleEvent(XEvent& e);
+
+        // Dispatches every queued event without blocking, input ahead of
+        // structure and cosmetic events.
+        void ProcessPendingEvents();
+
+        // Writes counters for the frame pool and pointer motion. Run() does
+        // this on SIGUSR1.
+        void PrintStats(std::ostream& out) const;
+
     };
 }
 #endif
@@ -0,0 +1,182 @@
+#ifndef X_BACKEND_H
+#define X_BACKEND_H
+
+extern "C"
+{
+    #include <X11/Xlib.h>
+    #include <X11/extensions/XI2.h>
+}
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace WM
+{
+    // A property read in a batch through XBackend::GetProperties.
+    struct PropertyRequest
+    {
+        Window m_window;
+        Atom m_property;
+        // AnyPropertyType to accept any type.
+        Atom m_type;
+        // Maximum length to read, in 32 bit units.
+        unsigned int m_maxLength;
+    };
+
+    struct PropertyReply
+    {
+        // None if the property doesn't exist or the request failed.
+        Atom m_type{None};
+        // 8, 16 or 32.
+        int m_format{0};
+        // Number of items of m_format bits.
+        unsigned int m_numItems{0};
+        // Raw value, items are packed at their own size (not as long).
+        std::vector<unsigned char> m_data{};
+
+        // Returns an 8 bit property as a string.
+        std::string AsString() const;
+    };
+
+    // An XInput2 pointer event, with the sub-pixel position core events
+    // round away.
+    struct PointerEvent
+    {
+        // XI_Motion or XI_ButtonRelease.
+        int m_type{0};
+        int m_device{0};
+        // The grab window.
+        Window m_window{None};
+        double m_rootX{0.0};
+        double m_rootY{0.0};
+        // Buttons and modifiers, as in XMotionEvent::state.
+        unsigned int m_state{0};
+        unsigned int m_button{0};
+        // Server time, in milliseconds.
+        Time m_time{CurrentTime};
+    };
+
+    // The X server as seen by the window manager.
+    //
+    // Every request the window manager makes goes through this interface, so
+    // the handlers can run against a real server (XlibBackend) or against an
+    // in-memory model of one (FakeBackend). Methods mirror the Xlib calls
+    // they replace, minus the Display argument.
+    class XBackend
+    {
+    public: // Public methods
+        virtual ~XBackend() = default;
+
+        // The display to open extra connections to, std::nullopt if there is
+        // no real server behind this backend.
+        virtual std::optional<std::string> GetDisplayName() const = 0;
+
+        virtual Window GetRootWindow() const = 0;
+
+        virtual Atom InternAtom(const std::string& name) = 0;
+
+        // Selects substructure redirection on the root window. Throws
+        // std::runtime_error if another window manager already has it.
+        virtual void RedirectRoot(long event_mask) = 0;
+
+        // Names what the window manager does from here on, the handler
+        // running or a step of Start, for backends that account requests to
+        // it. name must be a string literal. Does nothing by default.
+        virtual void SetPhase(const char* /* name */) {}
+
+        //------------------------------------------------------------------//
+        //                              EVENTS                              //
+        //------------------------------------------------------------------//
+
+        // File descriptor that becomes readable when events arrive, -1 if
+        // there is none.
+        virtual int GetConnectionFd() const = 0;
+
+        // Flushes requests and returns whether an event is queued.
+        virtual bool Pending() = 0;
+
+        // Blocks until an event is available.
+        virtual void NextEvent(XEvent& e) = 0;
+
+        // Removes the next queued event of a type for a window, if any.
+        virtual bool CheckTypedWindowEvent(Window w, int type, XEvent& e) = 0;
+
+        virtual void Flush() = 0;
+        virtual void Sync() = 0;
+
+        // Takes over the pointer grab a button press on w started, so that
+        // motion and the release arrive as XInput2 events. Returns false if
+        // the server or this build has no XInput2, core events keep coming
+        // then.
+        virtual bool GrabPointerMotion(Window w, Time time) = 0;
+        virtual void UngrabPointerMotion(Time time) = 0;
+
+        // Decodes an XInput2 pointer event returned by NextEvent. Returns
+        // false for any other event.
+        virtual bool GetPointerEvent(XEvent& e, PointerEvent& pointer) = 0;
+
+        //------------------------------------------------------------------//
+        //                             REQUESTS                             //
+        //------------------------------------------------------------------//
+
+        virtual void GrabServer() = 0;
+        virtual void UngrabServer() = 0;
+
+        // Returns the children of a window, bottom to top. Throws
+        // std::runtime_error on failure.
+        virtual std::vector<Window> QueryTree(Window w) = 0;
+
+        virtual bool GetWindowAttributes(Window w, XWindowAttributes& attributes) = 0;
+        virtual bool GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height) = 0;
+
+        virtual Window CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                          unsigned int border_width, unsigned long border, unsigned long background) = 0;
+        virtual void DestroyWindow(Window w) = 0;
+        virtual void SelectInput(Window w, long event_mask) = 0;
+        // Sets several attributes, e.g. the event mask and border colour, in
+        // one request.
+        virtual void ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes) = 0;
+
+        virtual void MapWindow(Window w) = 0;
+        virtual void UnmapWindow(Window w) = 0;
+        virtual void ReparentWindow(Window w, Window parent, int x, int y) = 0;
+        virtual void AddToSaveSet(Window w) = 0;
+        virtual void RemoveFromSaveSet(Window w) = 0;
+
+        virtual void ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes) = 0;
+        virtual void MoveWindow(Window w, int x, int y) = 0;
+        virtual void ResizeWindow(Window w, unsigned int width, unsigned int height) = 0;
+        virtual void RaiseWindow(Window w) = 0;
+
+        virtual void SetWindowBorderWidth(Window w, unsigned int width) = 0;
+        virtual void SetWindowBorder(Window w, unsigned long pixel) = 0;
+        virtual void SetWindowBackground(Window w, unsigned long pixel) = 0;
+        // Clears the whole window and generates exposures.
+        virtual void ClearWindow(Window w) = 0;
+        virtual void CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                              unsigned int width, unsigned int height, int dst_x, int dst_y) = 0;
+
+        virtual void GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask) = 0;
+        virtual void GrabKey(KeyCode keycode, unsigned int modifiers, Window w) = 0;
+        virtual void UngrabKey(KeyCode keycode, unsigned int modifiers, Window w) = 0;
+        // Sends every key event to w, e.g. to see the modifiers of a key
+        // binding released. Returns false if another client has the keyboard.
+        virtual bool GrabKeyboard(Window w, Time time) = 0;
+        virtual void UngrabKeyboard(Time time) = 0;
+        virtual KeyCode KeysymToKeycode(KeySym keysym) = 0;
+
+        virtual void SetInputFocus(Window w) = 0;
+        virtual void KillClient(Window w) = 0;
+        virtual bool SendEvent(Window w, long event_mask, XEvent& e) = 0;
+
+        // Reads all requested properties with a single round trip, after
+        // every request made before. Replies are in request order.
+        virtual std::vector<PropertyReply> GetProperties(const std::vector<PropertyRequest>& requests) = 0;
+
+        virtual void ChangeProperty(Window w, Atom property, Atom type, int format,
+                                    const unsigned char* data, int num_items) = 0;
+    };
+}
+
+#endif
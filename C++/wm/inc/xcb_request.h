@@ -0,0 +1,30 @@
+#ifndef XCB_REQUEST_H
+#define XCB_REQUEST_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct xcb_connection_t;
+struct xcb_extension_t;
+
+// Raw extension requests, for the extensions there are no xcb libraries for
+// here (X-Resource, Composite, DAMAGE).
+namespace WM::Xcb
+{
+    // Sends an extension request. request points to the whole request,
+    // length bytes and a multiple of 4, starting with the 4 byte header xcb
+    // fills in. Errors of requests with a reply come with the reply, those
+    // of the others as events. Returns the sequence number.
+    unsigned int SendRequest(xcb_connection_t* connection, xcb_extension_t* extension, std::uint8_t minor_opcode,
+                             void* request, std::size_t length, bool has_reply);
+
+    // Picks up the reply to request if it's there, without blocking.
+    // Returns whether the request is done, with reply nullptr if it failed.
+    // The reply is freed with std::free.
+    bool PollReply(xcb_connection_t* connection, unsigned int request, unsigned char*& reply);
+
+    // Reads a CARD32 at offset, replies aren't aligned for the types.
+    std::uint32_t ReadCard32(const unsigned char* data, std::size_t offset);
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef XLIB_BACKEND_H
+#define XLIB_BACKEND_H
+
+#include "property_fetcher.h"
+#include "x_backend.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace WM
+{
+    // XBackend talking to a real X server through Xlib.
+    class XlibBackend : public XBackend
+    {
+    public: // Public methods
+        // Connects to displayName, or to $DISPLAY if it is empty. Throws
+        // std::runtime_error if the display can't be opened.
+        explicit XlibBackend(const std::string& displayName);
+
+        // Disconnects from the X server.
+        ~XlibBackend() override;
+
+        XlibBackend(const XlibBackend&) = delete;
+        XlibBackend& operator=(const XlibBackend&) = delete;
+
+        std::optional<std::string> GetDisplayName() const override;
+        Window GetRootWindow() const override { return m_rootWindow; }
+        Atom InternAtom(const std::string& name) override;
+        void RedirectRoot(long event_mask) override;
+
+        int GetConnectionFd() const override;
+        bool Pending() override;
+        void NextEvent(XEvent& e) override;
+        bool CheckTypedWindowEvent(Window w, int type, XEvent& e) override;
+        void Flush() override;
+        void Sync() override;
+
+        bool GrabPointerMotion(Window w, Time time) override;
+        void UngrabPointerMotion(Time time) override;
+        bool GetPointerEvent(XEvent& e, PointerEvent& pointer) override;
+
+        void GrabServer() override;
+        void UngrabServer() override;
+        std::vector<Window> QueryTree(Window w) override;
+        bool GetWindowAttributes(Window w, XWindowAttributes& attributes) override;
+        bool GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height) override;
+
+        Window CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                  unsigned int border_width, unsigned long border, unsigned long background) override;
+        void DestroyWindow(Window w) override;
+        void SelectInput(Window w, long event_mask) override;
+        void ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes) override;
+        void MapWindow(Window w) override;
+        void UnmapWindow(Window w) override;
+        void ReparentWindow(Window w, Window parent, int x, int y) override;
+        void AddToSaveSet(Window w) override;
+        void RemoveFromSaveSet(Window w) override;
+
+        void ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes) override;
+        void MoveWindow(Window w, int x, int y) override;
+        void ResizeWindow(Window w, unsigned int width, unsigned int height) override;
+        void RaiseWindow(Window w) override;
+
+        void SetWindowBorderWidth(Window w, unsigned int width) override;
+        void SetWindowBorder(Window w, unsigned long pixel) override;
+        void SetWindowBackground(Window w, unsigned long pixel) override;
+        void ClearWindow(Window w) override;
+        void CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                      unsigned int width, unsigned int height, int dst_x, int dst_y) override;
+
+        void GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask) override;
+        void GrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        void UngrabKey(KeyCode keycode, unsigned int modifiers, Window w) override;
+        bool GrabKeyboard(Window w, Time time) override;
+        void UngrabKeyboard(Time time) override;
+        KeyCode KeysymToKeycode(KeySym keysym) override;
+
+        void SetInputFocus(Window w) override;
+        void KillClient(Window w) override;
+        bool SendEvent(Window w, long event_mask, XEvent& e) override;
+
+        std::vector<PropertyReply> GetProperties(const std::vector<PropertyRequest>& requests) override;
+        void ChangeProperty(Window w, Atom property, Atom type, int format,
+                            const unsigned char* data, int num_items) override;
+
+    private: // Private methods
+        // Xlib error handler. It must be static as its address is passed to
+        // Xlib, and there is one for the whole process, so it hands the error
+        // to the backend of the display it came from.
+        static int OnXError(Display* display, XErrorEvent* e);
+
+        // Handles an error on this backend's connection. While the root is
+        // being redirected, BadAccess means another window manager is
+        // running.
+        void OnError(XErrorEvent* e);
+
+    private: // Private variables
+        // Handle to the underlying Xlib connection struct.
+        Display* m_connection;
+        // Handle to root window.
+        Window m_rootWindow;
+
+        // Graphics context used to draw decorations.
+        GC m_gc;
+
+        // Reads properties in batches, on the XCB connection of the display
+        // when Xlib is built on XCB, else on a second connection.
+        std::unique_ptr<PropertyFetcher> m_propertyFetcher;
+
+        // Major opcode of XInputExtension, -1 without XInput 2.
+        int m_xiOpcode{-1};
+
+        // Whether RedirectRoot is waiting for its reply, and whether an
+        // existing window manager has been detected. Only touched from the
+        // thread using this connection, errors are handled there.
+        bool m_redirectingRoot{false};
+        bool m_wmDetected{false};
+
+        // Backends by connection, for OnXError. Several displays may be
+        // managed from one process, each on its own thread.
+        static std::mutex m_backendsMutex;
+        static std::unordered_map<Display*, XlibBackend*> m_backends;
+    };
+}
+
+#endif
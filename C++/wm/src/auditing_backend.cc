@@ -0,0 +1,353 @@
+#include "auditing_backend.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    AuditingBackend::AuditingBackend(std::unique_ptr<XBackend> backend)
+        : m_backend{std::move(backend)},
+          // Until the window manager names one, it is being constructed.
+          m_phase{&m_phases["Init"]}
+    {
+        m_phase->m_entries = 1;
+    }
+
+    void AuditingBackend::SetBudget(std::string_view phase, std::size_t budget)
+    {
+        m_budgets[std::string{phase}] = budget;
+    }
+
+    std::vector<AuditingBackend::Violation> AuditingBackend::GetViolations() const
+    {
+        std::vector<Violation> violations;
+        for (const auto& [name, phase] : m_phases)
+        {
+            // The entry still open counts too.
+            const std::size_t max_round_trips = &phase == m_phase ? std::max(phase.m_maxRoundTrips, m_entryRoundTrips)
+                                                                  : phase.m_maxRoundTrips;
+            // A phase nobody gave a budget may not block at all, so a new
+            // handler has to declare what it needs.
+            const auto budget = m_budgets.find(name);
+            const std::size_t allowed = budget != m_budgets.end() ? budget->second : 0;
+            if (max_round_trips > allowed)
+            {
+                violations.push_back({std::string{name}, allowed, max_round_trips});
+            }
+        }
+        return violations;
+    }
+
+    void AuditingBackend::PrintReport(std::ostream& out) const
+    {
+        out << "Round trips:\n";
+        for (const auto& [name, phase] : m_phases)
+        {
+            const std::size_t max_round_trips = &phase == m_phase ? std::max(phase.m_maxRoundTrips, m_entryRoundTrips)
+                                                                  : phase.m_maxRoundTrips;
+            out << "  " << name << ": " << phase.m_entries << " entries, " << phase.m_roundTrips
+                << " round trips, at most " << max_round_trips << " per entry";
+
+            const auto budget = m_budgets.find(name);
+            if (budget != m_budgets.end())
+            {
+                out << " (budget " << budget->second << ")";
+            }
+            else
+            {
+                out << " (no budget, 0 allowed)";
+            }
+            for (const auto& [request, count] : phase.m_requests)
+            {
+                out << ", " << request << ' ' << count;
+            }
+            out << '\n';
+        }
+        out.flush();
+    }
+
+    std::optional<std::string> AuditingBackend::GetDisplayName() const
+    {
+        return m_backend->GetDisplayName();
+    }
+
+    Window AuditingBackend::GetRootWindow() const
+    {
+        return m_backend->GetRootWindow();
+    }
+
+    Atom AuditingBackend::InternAtom(const std::string& name)
+    {
+        CountRoundTrip("InternAtom");
+        return m_backend->InternAtom(name);
+    }
+
+    void AuditingBackend::RedirectRoot(long event_mask)
+    {
+        // Syncs to find out whether another window manager has the root.
+        CountRoundTrip("RedirectRoot");
+        m_backend->RedirectRoot(event_mask);
+    }
+
+    void AuditingBackend::SetPhase(const char* name)
+    {
+        EndEntry();
+        m_phase = &m_phases[name];
+        ++m_phase->m_entries;
+        m_backend->SetPhase(name);
+    }
+
+    //------------------------------------------------------------------//
+    //                              EVENTS                              //
+    //------------------------------------------------------------------//
+
+    int AuditingBackend::GetConnectionFd() const
+    {
+        return m_backend->GetConnectionFd();
+    }
+
+    bool AuditingBackend::Pending()
+    {
+        return m_backend->Pending();
+    }
+
+    void AuditingBackend::NextEvent(XEvent& e)
+    {
+        m_backend->NextEvent(e);
+    }
+
+    bool AuditingBackend::CheckTypedWindowEvent(Window w, int type, XEvent& e)
+    {
+        return m_backend->CheckTypedWindowEvent(w, type, e);
+    }
+
+    void AuditingBackend::Flush()
+    {
+        m_backend->Flush();
+    }
+
+    void AuditingBackend::Sync()
+    {
+        CountRoundTrip("Sync");
+        m_backend->Sync();
+    }
+
+    bool AuditingBackend::GrabPointerMotion(Window w, Time time)
+    {
+        CountRoundTrip("GrabPointerMotion");
+        return m_backend->GrabPointerMotion(w, time);
+    }
+
+    void AuditingBackend::UngrabPointerMotion(Time time)
+    {
+        m_backend->UngrabPointerMotion(time);
+    }
+
+    bool AuditingBackend::GetPointerEvent(XEvent& e, PointerEvent& pointer)
+    {
+        return m_backend->GetPointerEvent(e, pointer);
+    }
+
+    //------------------------------------------------------------------//
+    //                             REQUESTS                             //
+    //------------------------------------------------------------------//
+
+    void AuditingBackend::GrabServer()
+    {
+        m_backend->GrabServer();
+    }
+
+    void AuditingBackend::UngrabServer()
+    {
+        m_backend->UngrabServer();
+    }
+
+    std::vector<Window> AuditingBackend::QueryTree(Window w)
+    {
+        CountRoundTrip("QueryTree");
+        return m_backend->QueryTree(w);
+    }
+
+    bool AuditingBackend::GetWindowAttributes(Window w, XWindowAttributes& attributes)
+    {
+        CountRoundTrip("GetWindowAttributes");
+        return m_backend->GetWindowAttributes(w, attributes);
+    }
+
+    bool AuditingBackend::GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height)
+    {
+        CountRoundTrip("GetGeometry");
+        return m_backend->GetGeometry(w, x, y, width, height);
+    }
+
+    Window AuditingBackend::CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                               unsigned int border_width, unsigned long border, unsigned long background)
+    {
+        return m_backend->CreateSimpleWindow(parent, x, y, width, height, border_width, border, background);
+    }
+
+    void AuditingBackend::DestroyWindow(Window w)
+    {
+        m_backend->DestroyWindow(w);
+    }
+
+    void AuditingBackend::SelectInput(Window w, long event_mask)
+    {
+        m_backend->SelectInput(w, event_mask);
+    }
+
+    void AuditingBackend::ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes)
+    {
+        m_backend->ChangeWindowAttributes(w, value_mask, attributes);
+    }
+
+    void AuditingBackend::MapWindow(Window w)
+    {
+        m_backend->MapWindow(w);
+    }
+
+    void AuditingBackend::UnmapWindow(Window w)
+    {
+        m_backend->UnmapWindow(w);
+    }
+
+    void AuditingBackend::ReparentWindow(Window w, Window parent, int x, int y)
+    {
+        m_backend->ReparentWindow(w, parent, x, y);
+    }
+
+    void AuditingBackend::AddToSaveSet(Window w)
+    {
+        m_backend->AddToSaveSet(w);
+    }
+
+    void AuditingBackend::RemoveFromSaveSet(Window w)
+    {
+        m_backend->RemoveFromSaveSet(w);
+    }
+
+    void AuditingBackend::ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes)
+    {
+        m_backend->ConfigureWindow(w, value_mask, changes);
+    }
+
+    void AuditingBackend::MoveWindow(Window w, int x, int y)
+    {
+        m_backend->MoveWindow(w, x, y);
+    }
+
+    void AuditingBackend::ResizeWindow(Window w, unsigned int width, unsigned int height)
+    {
+        m_backend->ResizeWindow(w, width, height);
+    }
+
+    void AuditingBackend::RaiseWindow(Window w)
+    {
+        m_backend->RaiseWindow(w);
+    }
+
+    void AuditingBackend::SetWindowBorderWidth(Window w, unsigned int width)
+    {
+        m_backend->SetWindowBorderWidth(w, width);
+    }
+
+    void AuditingBackend::SetWindowBorder(Window w, unsigned long pixel)
+    {
+        m_backend->SetWindowBorder(w, pixel);
+    }
+
+    void AuditingBackend::SetWindowBackground(Window w, unsigned long pixel)
+    {
+        m_backend->SetWindowBackground(w, pixel);
+    }
+
+    void AuditingBackend::ClearWindow(Window w)
+    {
+        m_backend->ClearWindow(w);
+    }
+
+    void AuditingBackend::CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                                   unsigned int width, unsigned int height, int dst_x, int dst_y)
+    {
+        m_backend->CopyArea(src, dst, src_x, src_y, width, height, dst_x, dst_y);
+    }
+
+    void AuditingBackend::GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask)
+    {
+        m_backend->GrabButton(button, modifiers, w, event_mask);
+    }
+
+    void AuditingBackend::GrabKey(KeyCode keycode, unsigned int modifiers, Window w)
+    {
+        m_backend->GrabKey(keycode, modifiers, w);
+    }
+
+    void AuditingBackend::UngrabKey(KeyCode keycode, unsigned int modifiers, Window w)
+    {
+        m_backend->UngrabKey(keycode, modifiers, w);
+    }
+
+    bool AuditingBackend::GrabKeyboard(Window w, Time time)
+    {
+        CountRoundTrip("GrabKeyboard");
+        return m_backend->GrabKeyboard(w, time);
+    }
+
+    void AuditingBackend::UngrabKeyboard(Time time)
+    {
+        m_backend->UngrabKeyboard(time);
+    }
+
+    KeyCode AuditingBackend::KeysymToKeycode(KeySym keysym)
+    {
+        // Answered from the keyboard mapping Xlib keeps.
+        return m_backend->KeysymToKeycode(keysym);
+    }
+
+    void AuditingBackend::SetInputFocus(Window w)
+    {
+        m_backend->SetInputFocus(w);
+    }
+
+    void AuditingBackend::KillClient(Window w)
+    {
+        m_backend->KillClient(w);
+    }
+
+    bool AuditingBackend::SendEvent(Window w, long event_mask, XEvent& e)
+    {
+        return m_backend->SendEvent(w, event_mask, e);
+    }
+
+    std::vector<PropertyReply> AuditingBackend::GetProperties(const std::vector<PropertyRequest>& requests)
+    {
+        // One round trip however many properties are read.
+        if (!requests.empty())
+        {
+            CountRoundTrip("GetProperties");
+        }
+        return m_backend->GetProperties(requests);
+    }
+
+    void AuditingBackend::ChangeProperty(Window w, Atom property, Atom type, int format,
+                                         const unsigned char* data, int num_items)
+    {
+        m_backend->ChangeProperty(w, property, type, format, data, num_items);
+    }
+
+    //------------------------------------------------------------------//
+    //                              PRIVATE                             //
+    //------------------------------------------------------------------//
+
+    void AuditingBackend::CountRoundTrip(std::string_view request)
+    {
+        ++m_phase->m_roundTrips;
+        ++m_phase->m_requests[request];
+        ++m_entryRoundTrips;
+    }
+
+    void AuditingBackend::EndEntry()
+    {
+        m_phase->m_maxRoundTrips = std::max(m_phase->m_maxRoundTrips, m_entryRoundTrips);
+        m_entryRoundTrips = 0;
+    }
+}
@@ -0,0 +1,128 @@
+#include "client_properties.h"
+#include <cstdint>
+#include <cstring>
+
+extern "C"
+{
+    #include <X11/Xatom.h>
+    #include <X11/Xutil.h>
+}
+
+
+namespace WM
+{
+    namespace
+    {
+        // Titles longer than 4 KiB don't need to be kept in full.
+        constexpr unsigned int MAX_LENGTH = 1024;
+        // Items of WM_HINTS and the part of WM_NORMAL_HINTS read.
+        constexpr unsigned int WM_HINTS_ITEMS = 9;
+        constexpr unsigned int NORMAL_HINTS_ITEMS = 1;
+
+        // Returns item i of a 32 bit property, 0 past its end.
+        std::uint32_t GetCard32(const PropertyReply& reply, unsigned int i)
+        {
+            if (reply.m_format != 32 || i >= reply.m_numItems)
+            {
+                return 0;
+            }
+            std::uint32_t value;
+            std::memcpy(&value, reply.m_data.data() + i * sizeof(value), sizeof(value));
+            return value;
+        }
+
+        std::vector<Atom> GetAtoms(const PropertyReply& reply)
+        {
+            std::vector<Atom> atoms;
+            for (unsigned int i = 0; reply.m_format == 32 && i < reply.m_numItems; ++i)
+            {
+                atoms.push_back(GetCard32(reply, i));
+            }
+            return atoms;
+        }
+    }
+
+    bool ClientProperties::IsCached(const PropertyAtoms& atoms, Atom property)
+    {
+        return property == XA_WM_CLASS || property == XA_WM_NAME || property == XA_WM_HINTS ||
+               property == XA_WM_NORMAL_HINTS || property == atoms.m_netWmName ||
+               property == atoms.m_wmProtocols || property == atoms.m_netWmWindowType;
+    }
+
+    std::vector<PropertyRequest> ClientProperties::GetRequests(const PropertyAtoms& atoms, Window w,
+                                                               const std::vector<Atom>& properties)
+    {
+        const std::vector<PropertyRequest> all{
+            {w, XA_WM_CLASS, XA_STRING, MAX_LENGTH},
+            {w, atoms.m_netWmName, atoms.m_utf8String, MAX_LENGTH},
+            {w, XA_WM_NAME, AnyPropertyType, MAX_LENGTH},
+            {w, atoms.m_wmProtocols, XA_ATOM, MAX_LENGTH},
+            {w, atoms.m_netWmWindowType, XA_ATOM, MAX_LENGTH},
+            {w, XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, NORMAL_HINTS_ITEMS},
+            {w, XA_WM_HINTS, XA_WM_HINTS, WM_HINTS_ITEMS},
+        };
+        if (properties.empty())
+        {
+            return all;
+        }
+
+        std::vector<PropertyRequest> requests;
+        for (const PropertyRequest& request : all)
+        {
+            for (const Atom property : properties)
+            {
+                if (request.m_property == property)
+                {
+                    requests.push_back(request);
+                }
+            }
+        }
+        return requests;
+    }
+
+    void ClientProperties::Store(const PropertyAtoms& atoms, Atom property, const PropertyReply& reply)
+    {
+        if (property == XA_WM_CLASS)
+        {
+            // The instance and the class, each NUL terminated.
+            const std::string wm_class = reply.AsString();
+            const std::size_t separator = wm_class.find('\0');
+            m_instance = wm_class.substr(0, separator);
+            m_class = separator != std::string::npos ? wm_class.substr(separator + 1) : std::string{};
+        }
+        else if (property == atoms.m_netWmName)
+        {
+            m_netName = reply.AsString();
+            m_hasNetName = reply.m_type != None;
+        }
+        else if (property == XA_WM_NAME)
+        {
+            m_name = reply.AsString();
+        }
+        else if (property == atoms.m_wmProtocols)
+        {
+            m_protocols = GetAtoms(reply);
+        }
+        else if (property == atoms.m_netWmWindowType)
+        {
+            m_windowTypes = GetAtoms(reply);
+        }
+        else if (property == XA_WM_NORMAL_HINTS)
+        {
+            m_normalHintsFlags = static_cast<long>(GetCard32(reply, 0));
+        }
+        else if (property == XA_WM_HINTS)
+        {
+            // flags, then input as the second item.
+            const std::uint32_t flags = GetCard32(reply, 0);
+            m_input = !(flags & InputHint) || GetCard32(reply, 1) != 0;
+            m_urgent = (flags & XUrgencyHint) != 0;
+        }
+    }
+
+    WindowIdentity ClientProperties::GetIdentity() const
+    {
+        // Prefer the UTF-8 title.
+        return WindowIdentity{m_class, m_instance, m_hasNetName ? m_netName : m_name};
+    }
+}
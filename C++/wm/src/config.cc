@@ -0,0 +1,260 @@
+#include "config.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+
+namespace WM
+{
+    namespace
+    {
+        std::string_view Trim(std::string_view text)
+        {
+            const std::size_t begin = text.find_first_not_of(" \t\r");
+            if (begin == std::string_view::npos)
+            {
+                return std::string_view{};
+            }
+            const std::size_t end = text.find_last_not_of(" \t\r");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        unsigned long ParseUnsigned(std::string_view value, int base)
+        {
+            unsigned long result = 0;
+            const auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), result, base);
+            if (value.empty() || error != std::errc{} || ptr != value.data() + value.size())
+            {
+                throw std::runtime_error("invalid number '" + std::string{value} + "'");
+            }
+            return result;
+        }
+
+        // Accepts #rrggbb and 0xrrggbb.
+        unsigned long ParseColor(std::string_view value)
+        {
+            if (value.starts_with('#'))
+            {
+                value.remove_prefix(1);
+            }
+            else if (value.starts_with("0x"))
+            {
+                value.remove_prefix(2);
+            }
+            else
+            {
+                throw std::runtime_error("invalid colour '" + std::string{value} + "'");
+            }
+
+            if (value.size() != 6)
+            {
+                throw std::runtime_error("colours need 6 hex digits");
+            }
+            return ParseUnsigned(value, 16);
+        }
+
+        unsigned int ParseModifier(std::string_view name)
+        {
+            static constexpr std::pair<std::string_view, unsigned int> MODIFIERS[]
+            {
+                {"Shift", ShiftMask},
+                {"Control", ControlMask},
+                {"Ctrl", ControlMask},
+                {"Mod1", Mod1Mask},
+                {"Alt", Mod1Mask},
+                {"Mod2", Mod2Mask},
+                {"Mod3", Mod3Mask},
+                {"Mod4", Mod4Mask},
+                {"Super", Mod4Mask},
+                {"Mod5", Mod5Mask},
+            };
+
+            for (const auto& [modifier_name, mask] : MODIFIERS)
+            {
+                if (modifier_name == name)
+                {
+                    return mask;
+                }
+            }
+            throw std::runtime_error("unknown modifier '" + std::string{name} + "'");
+        }
+
+        // Parses "Mod1+Shift+F4 close".
+        KeyBinding ParseBinding(std::string_view value)
+        {
+            const std::size_t space = value.find_first_of(" \t");
+            if (space == std::string_view::npos)
+            {
+                throw std::runtime_error("bind needs a key and an action");
+            }
+            std::string_view keys = value.substr(0, space);
+            const std::string_view action = Trim(value.substr(space));
+
+            KeyBinding binding{0, NoSymbol, KeyAction::Close};
+
+            // Everything before the last '+' is a modifier.
+            for (std::size_t plus = keys.find('+'); plus != std::string_view::npos; plus = keys.find('+'))
+            {
+                binding.m_modifiers |= ParseModifier(keys.substr(0, plus));
+                keys.remove_prefix(plus + 1);
+            }
+
+            // XStringToKeysym is resolved locally, it doesn't talk to the server.
+            binding.m_keysym = XStringToKeysym(std::string{keys}.c_str());
+            if (binding.m_keysym == NoSymbol)
+            {
+                throw std::runtime_error("unknown key '" + std::string{keys} + "'");
+            }
+
+            if (action == "close")
+            {
+                binding.m_action = KeyAction::Close;
+            }
+            else if (action == "switch_next")
+            {
+                binding.m_action = KeyAction::SwitchNext;
+            }
+            else
+            {
+                throw std::runtime_error("unknown action '" + std::string{action} + "'");
+            }
+            return binding;
+        }
+
+        FrameMode ParseFrameMode(std::string_view value)
+        {
+            if (value == "reparent")
+            {
+                return FrameMode::Reparent;
+            }
+            if (value == "borderless")
+            {
+                return FrameMode::Borderless;
+            }
+            throw std::runtime_error("unknown frame mode '" + std::string{value} + "'");
+        }
+
+        FocusMode ParseFocusMode(std::string_view value)
+        {
+            if (value == "click")
+            {
+                return FocusMode::Click;
+            }
+            if (value == "mouse")
+            {
+                return FocusMode::Mouse;
+            }
+            throw std::runtime_error("unknown focus mode '" + std::string{value} + "'");
+        }
+
+        bool Contains(const std::vector<KeyBinding>& bindings, const KeyBinding& binding)
+        {
+            return std::find(bindings.begin(), bindings.end(), binding) != bindings.end();
+        }
+    }
+
+    Config Config::Parse(std::string_view text)
+    {
+        Config config;
+        std::vector<KeyBinding> bindings;
+        std::size_t line_number = 0;
+
+        while (!text.empty())
+        {
+            const std::size_t end = text.find('\n');
+            const std::string_view line = Trim(text.substr(0, end));
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            ++line_number;
+
+            if (line.empty() || line.front() == '#')
+            {
+                continue;
+            }
+
+            try
+            {
+                const std::size_t equals = line.find('=');
+                if (equals == std::string_view::npos)
+                {
+                    throw std::runtime_error("expected 'key = value'");
+                }
+                const std::string_view key = Trim(line.substr(0, equals));
+                const std::string_view value = Trim(line.substr(equals + 1));
+
+                if (key == "border_width")
+                {
+                    config.m_borderWidth = static_cast<unsigned int>(ParseUnsigned(value, 10));
+                }
+                else if (key == "border_color")
+                {
+                    config.m_borderColor = ParseColor(value);
+                }
+                else if (key == "background_color")
+                {
+                    config.m_backgroundColor = ParseColor(value);
+                }
+                else if (key == "snap_distance")
+                {
+                    config.m_snapDistance = static_cast<unsigned int>(ParseUnsigned(value, 10));
+                }
+                else if (key == "frame_mode")
+                {
+                    config.m_frameMode = ParseFrameMode(value);
+                }
+                else if (key == "focus_mode")
+                {
+                    config.m_focusMode = ParseFocusMode(value);
+                }
+                else if (key == "bind")
+                {
+                    bindings.push_back(ParseBinding(value));
+                }
+                else
+                {
+                    throw std::runtime_error("unknown key '" + std::string{key} + "'");
+                }
+            }
+            catch (const std::runtime_error& e)
+            {
+                throw std::runtime_error("config:" + std::to_string(line_number) + ": " + e.what());
+            }
+        }
+
+        if (!bindings.empty())
+        {
+            config.m_keyBindings = std::move(bindings);
+        }
+        return config;
+    }
+
+    bool ConfigDiff::IsEmpty() const
+    {
+        return !m_borderWidth && !m_borderColor && !m_backgroundColor
+            && m_removedKeys.empty() && m_addedKeys.empty();
+    }
+
+    ConfigDiff Diff(const Config& before, const Config& after)
+    {
+        ConfigDiff diff;
+        diff.m_borderWidth = before.m_borderWidth != after.m_borderWidth;
+        diff.m_borderColor = before.m_borderColor != after.m_borderColor;
+        diff.m_backgroundColor = before.m_backgroundColor != after.m_backgroundColor;
+
+        for (const KeyBinding& binding : before.m_keyBindings)
+        {
+            if (!Contains(after.m_keyBindings, binding))
+            {
+                diff.m_removedKeys.push_back(binding);
+            }
+        }
+        for (const KeyBinding& binding : after.m_keyBindings)
+        {
+            if (!Contains(before.m_keyBindings, binding))
+            {
+                diff.m_addedKeys.push_back(binding);
+            }
+        }
+        return diff;
+    }
+}
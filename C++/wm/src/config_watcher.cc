@@ -0,0 +1,71 @@
+#include "config_watcher.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+
+namespace WM
+{
+    ConfigWatcher::ConfigWatcher(const std::string& directory)
+        : m_fd{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+    {
+        if (m_fd < 0)
+        {
+            std::cerr << "Can't watch the configuration: " << std::strerror(errno) << '\n';
+            return;
+        }
+
+        // A missing directory only means there is nothing to reload.
+        if (inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            std::cerr << "Can't watch " << directory << ": " << std::strerror(errno) << '\n';
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    ConfigWatcher::~ConfigWatcher()
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    std::vector<std::string> ConfigWatcher::ReadChanges()
+    {
+        std::vector<std::string> names;
+        if (m_fd < 0)
+        {
+            return names;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        while (true)
+        {
+            const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+            if (length <= 0)
+            {
+                // EAGAIN, everything has been read.
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len > 0)
+                {
+                    const std::string name{event->name};
+                    if (std::find(names.begin(), names.end(), name) == names.end())
+                    {
+                        names.push_back(name);
+                    }
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+        return names;
+    }
+}
@@ -0,0 +1,162 @@
+#include "configure_throttle.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    ConfigureThrottle::ConfigureThrottle(double rate, double burst)
+        : m_rate{rate},
+          m_burst{burst}
+    {
+
+    }
+
+    bool ConfigureThrottle::Admit(const XConfigureRequestEvent& e, Clock::time_point now)
+    {
+        const auto [i, inserted] = m_buckets.try_emplace(e.window, Bucket{m_burst, now});
+        Bucket& bucket = i->second;
+        ++bucket.m_requestCount;
+
+        // 1. Grant it if there is a token and nothing is waiting ahead of it.
+        Refill(bucket, now);
+        if (!bucket.m_held && bucket.m_tokens >= 1.0)
+        {
+            bucket.m_tokens -= 1.0;
+            ++m_grantedCount;
+            return true;
+        }
+
+        // 2. Otherwise fold it into the request held back.
+        if (bucket.m_held)
+        {
+            Merge(*bucket.m_held, e);
+            ++bucket.m_collapsedCount;
+            ++m_collapsedCount;
+        }
+        else
+        {
+            bucket.m_held = e;
+            ++m_heldCount;
+        }
+        return false;
+    }
+
+    std::vector<XConfigureRequestEvent> ConfigureThrottle::TakeDue(Clock::time_point now)
+    {
+        std::vector<XConfigureRequestEvent> due;
+        if (m_heldCount == 0)
+        {
+            return due;
+        }
+
+        for (auto& [w, bucket] : m_buckets)
+        {
+            if (!bucket.m_held)
+            {
+                continue;
+            }
+            Refill(bucket, now);
+            if (bucket.m_tokens >= 1.0)
+            {
+                bucket.m_tokens -= 1.0;
+                due.push_back(*bucket.m_held);
+                bucket.m_held.reset();
+                --m_heldCount;
+                ++m_grantedCount;
+            }
+        }
+        return due;
+    }
+
+    void ConfigureThrottle::Remove(Window w)
+    {
+        const auto i = m_buckets.find(w);
+        if (i == m_buckets.end())
+        {
+            return;
+        }
+        if (i->second.m_held)
+        {
+            --m_heldCount;
+        }
+        m_buckets.erase(i);
+    }
+
+    std::optional<ConfigureThrottle::Clock::duration> ConfigureThrottle::GetTimeout(Clock::time_point now) const
+    {
+        if (m_heldCount == 0)
+        {
+            return std::nullopt;
+        }
+
+        double missing = 1.0;
+        for (const auto& [w, bucket] : m_buckets)
+        {
+            if (bucket.m_held)
+            {
+                Bucket refilled = bucket;
+                Refill(refilled, now);
+                missing = std::min(missing, std::max(0.0, 1.0 - refilled.m_tokens));
+            }
+        }
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(missing / m_rate));
+    }
+
+    std::vector<ThrottleStats> ConfigureThrottle::GetOffenders() const
+    {
+        std::vector<ThrottleStats> offenders;
+        for (const auto& [w, bucket] : m_buckets)
+        {
+            if (bucket.m_collapsedCount > 0)
+            {
+                offenders.push_back({w, bucket.m_requestCount, bucket.m_collapsedCount});
+            }
+        }
+        std::sort(offenders.begin(), offenders.end(), [](const ThrottleStats& a, const ThrottleStats& b)
+        {
+            return a.m_collapsedCount > b.m_collapsedCount;
+        });
+        return offenders;
+    }
+
+    void ConfigureThrottle::Refill(Bucket& bucket, Clock::time_point now) const
+    {
+        const double elapsed = std::chrono::duration<double>(now - bucket.m_refilled).count();
+        bucket.m_tokens = std::min(m_burst, bucket.m_tokens + elapsed * m_rate);
+        bucket.m_refilled = now;
+    }
+
+    void ConfigureThrottle::Merge(XConfigureRequestEvent& to, const XConfigureRequestEvent& from)
+    {
+        if (from.value_mask & CWX)
+        {
+            to.x = from.x;
+        }
+        if (from.value_mask & CWY)
+        {
+            to.y = from.y;
+        }
+        if (from.value_mask & CWWidth)
+        {
+            to.width = from.width;
+        }
+        if (from.value_mask & CWHeight)
+        {
+            to.height = from.height;
+        }
+        if (from.value_mask & CWBorderWidth)
+        {
+            to.border_width = from.border_width;
+        }
+        if (from.value_mask & CWSibling)
+        {
+            to.above = from.above;
+        }
+        if (from.value_mask & CWStackMode)
+        {
+            to.detail = from.detail;
+        }
+        to.value_mask |= from.value_mask;
+        to.serial = from.serial;
+    }
+}
@@ -0,0 +1,116 @@
+#include "edge_index.h"
+#include <algorithm>
+#include <cstdlib>
+
+
+namespace WM
+{
+    void EdgeIndex::Update(const Placement& placement)
+    {
+        if (m_generation == placement.GetGeneration())
+        {
+            return;
+        }
+        m_generation = placement.GetGeneration();
+
+        m_vertical.clear();
+        m_horizontal.clear();
+
+        // 1. Output edges, which frames snap to from the inside.
+        for (const Rect<int>& output : placement.GetOutputs())
+        {
+            m_vertical.push_back({output.GetLeft(), output.GetTop(), output.GetBottom(), None});
+            m_vertical.push_back({output.GetRight(), output.GetTop(), output.GetBottom(), None});
+            m_horizontal.push_back({output.GetTop(), output.GetLeft(), output.GetRight(), None});
+            m_horizontal.push_back({output.GetBottom(), output.GetLeft(), output.GetRight(), None});
+        }
+
+        // 2. Frame edges, which frames snap to from either side.
+        const RectArray& rects = placement.GetRects();
+        const std::vector<Window>& windows = placement.GetWindows();
+        for (std::size_t i = 0; i < windows.size(); ++i)
+        {
+            const Rect<int> r = rects.Get(i);
+            if (r.IsEmpty())
+            {
+                continue;
+            }
+            m_vertical.push_back({r.GetLeft(), r.GetTop(), r.GetBottom(), windows[i]});
+            m_vertical.push_back({r.GetRight(), r.GetTop(), r.GetBottom(), windows[i]});
+            m_horizontal.push_back({r.GetTop(), r.GetLeft(), r.GetRight(), windows[i]});
+            m_horizontal.push_back({r.GetBottom(), r.GetLeft(), r.GetRight(), windows[i]});
+        }
+
+        const auto by_position = [](const Edge& a, const Edge& b) { return a.m_position < b.m_position; };
+        std::sort(m_vertical.begin(), m_vertical.end(), by_position);
+        std::sort(m_horizontal.begin(), m_horizontal.end(), by_position);
+    }
+
+    Position<int> EdgeIndex::SnapPosition(const Rect<int>& rect, Window ignore, int distance) const
+    {
+        if (distance <= 0)
+        {
+            return rect.GetPosition();
+        }
+
+        // Either edge may snap, the one needing the smaller move wins.
+        const std::optional<int> dx = Closest(
+            FindNearest(m_vertical, rect.GetLeft(), rect.GetTop(), rect.GetBottom(), ignore, distance),
+            FindNearest(m_vertical, rect.GetRight(), rect.GetTop(), rect.GetBottom(), ignore, distance));
+        const std::optional<int> dy = Closest(
+            FindNearest(m_horizontal, rect.GetTop(), rect.GetLeft(), rect.GetRight(), ignore, distance),
+            FindNearest(m_horizontal, rect.GetBottom(), rect.GetLeft(), rect.GetRight(), ignore, distance));
+
+        return Position<int>(rect.m_x + dx.value_or(0), rect.m_y + dy.value_or(0));
+    }
+
+    Size<int> EdgeIndex::SnapSize(const Rect<int>& rect, Window ignore, int distance) const
+    {
+        if (distance <= 0)
+        {
+            return rect.GetSize();
+        }
+
+        const std::optional<int> dx =
+            FindNearest(m_vertical, rect.GetRight(), rect.GetTop(), rect.GetBottom(), ignore, distance);
+        const std::optional<int> dy =
+            FindNearest(m_horizontal, rect.GetBottom(), rect.GetLeft(), rect.GetRight(), ignore, distance);
+
+        // Never snap down to nothing.
+        return Size<int>(std::max(1, rect.m_width + dx.value_or(0)), std::max(1, rect.m_height + dy.value_or(0)));
+    }
+
+    std::optional<int> EdgeIndex::FindNearest(const std::vector<Edge>& edges, int position,
+                                              int start, int end, Window ignore, int distance)
+    {
+        std::optional<int> nearest;
+
+        auto edge = std::lower_bound(edges.begin(), edges.end(), position - distance,
+                                     [](const Edge& e, int p) { return e.m_position < p; });
+        for (; edge != edges.end() && edge->m_position <= position + distance; ++edge)
+        {
+            // Only edges beside the frame count, not those in line with it
+            // far away.
+            if (edge->m_window == ignore || edge->m_start >= end || edge->m_end <= start)
+            {
+                continue;
+            }
+
+            const int offset = edge->m_position - position;
+            if (!nearest || std::abs(offset) < std::abs(*nearest))
+            {
+                nearest = offset;
+            }
+        }
+        return nearest;
+    }
+
+    std::optional<int> EdgeIndex::Closest(std::optional<int> a, std::optional<int> b)
+    {
+        if (!a || (b && std::abs(*b) < std::abs(*a)))
+        {
+            return b;
+        }
+        return a;
+    }
+}
@@ -0,0 +1,127 @@
+#include "event_scheduler.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    EventScheduler::EventScheduler(std::size_t starvation_limit)
+        : m_starvationLimit{starvation_limit}
+    {
+
+    }
+
+    EventClass EventScheduler::Classify(const XEvent& e)
+    {
+        switch (e.type)
+        {
+            case KeyPress:
+            case KeyRelease:
+            case ButtonPress:
+            case ButtonRelease:
+            case MotionNotify:
+            case GenericEvent:
+            case FocusIn:
+            case FocusOut:
+            case EnterNotify:
+            case LeaveNotify:
+                return EventClass::Input;
+
+            case MapRequest:
+            case ConfigureRequest:
+            case CirculateRequest:
+            case CreateNotify:
+            case DestroyNotify:
+            case MapNotify:
+            case UnmapNotify:
+            case ReparentNotify:
+                return EventClass::Structure;
+
+            default:
+                return EventClass::Cosmetic;
+        }
+    }
+
+    void EventScheduler::Push(const XEvent& e, const std::optional<PointerEvent>& pointer)
+    {
+        std::deque<Entry>& queue = m_queues[static_cast<std::size_t>(Classify(e))];
+
+        if (e.type == MotionNotify && !queue.empty())
+        {
+            XEvent& last = queue.back().m_event;
+            if (last.type == MotionNotify && last.xmotion.window == e.xmotion.window)
+            {
+                last = e;
+                ++m_coalescedCount;
+                return;
+            }
+        }
+
+        queue.push_back(Entry{e, pointer, m_nextSequence++});
+        ++m_size;
+        m_maxQueued = std::max(m_maxQueued, m_size);
+    }
+
+    bool EventScheduler::Pop(Entry& entry)
+    {
+        if (m_size == 0)
+        {
+            return false;
+        }
+
+        // 1. The highest class with events, unless a lower one has waited
+        // long enough, the lowest of those first. A lower class never goes
+        // ahead of events that arrived before it.
+        std::size_t chosen = NUM_CLASSES;
+        for (std::size_t i = NUM_CLASSES; i-- > 0;)
+        {
+            if (!m_queues[i].empty() && m_skipped[i] >= m_starvationLimit && IsOldest(i))
+            {
+                chosen = i;
+                ++m_starvedCount;
+                break;
+            }
+        }
+        if (chosen == NUM_CLASSES)
+        {
+            chosen = 0;
+            while (m_queues[chosen].empty())
+            {
+                ++chosen;
+            }
+        }
+
+        // 2. Classes still waiting below it are passed over once more.
+        m_skipped[chosen] = 0;
+        for (std::size_t i = chosen + 1; i < NUM_CLASSES; ++i)
+        {
+            if (!m_queues[i].empty())
+            {
+                ++m_skipped[i];
+            }
+        }
+
+        entry = m_queues[chosen].front();
+        m_queues[chosen].pop_front();
+        --m_size;
+        ++m_dispatchedCounts[chosen];
+        return true;
+    }
+
+    bool EventScheduler::IsOldest(std::size_t event_class) const
+    {
+        const std::uint64_t sequence = m_queues[event_class].front().m_sequence;
+        for (std::size_t i = 0; i < event_class; ++i)
+        {
+            if (!m_queues[i].empty() && m_queues[i].front().m_sequence < sequence)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool EventScheduler::IsEmpty() const
+    {
+        return m_size == 0;
+    }
+}
@@ -0,0 +1,819 @@
+#include "fake_backend.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <X11/Xatom.h>
+
+
+namespace WM
+{
+    namespace
+    {
+        // Ids of the windows the fake server hands out, well away from the
+        // ids of a recorded session.
+        constexpr Window FIRST_WINDOW = 0x10000000;
+
+        // Major opcode of the fake XInputExtension.
+        constexpr int FAKE_XI_OPCODE = 131;
+
+        XEvent MakeEvent(int type)
+        {
+            XEvent e;
+            std::memset(&e, 0, sizeof(e));
+            e.type = type;
+            return e;
+        }
+
+        void RemoveChild(std::vector<Window>& children, Window w)
+        {
+            children.erase(std::remove(children.begin(), children.end(), w), children.end());
+        }
+    }
+
+    FakeBackend::FakeBackend(unsigned int width, unsigned int height)
+        : m_rootWindow{FIRST_WINDOW},
+          m_nextWindow{FIRST_WINDOW + 1},
+          m_nextAtom{XA_LAST_PREDEFINED + 1}
+    {
+        WindowState& root = m_windows[m_rootWindow];
+        root.m_width = width;
+        root.m_height = height;
+        root.m_mapped = true;
+    }
+
+    //------------------------------------------------------------------//
+    //                         SIMULATED CLIENTS                        //
+    //------------------------------------------------------------------//
+
+    Window FakeBackend::ClientCreateWindow(int x, int y, unsigned int width, unsigned int height,
+                                           bool override_redirect)
+    {
+        const Window w = m_nextWindow++;
+        NewWindow(w, m_rootWindow, x, y, width, height);
+        m_windows[w].m_overrideRedirect = override_redirect;
+
+        XEvent e = MakeEvent(CreateNotify);
+        e.xcreatewindow.window = w;
+        e.xcreatewindow.x = x;
+        e.xcreatewindow.y = y;
+        e.xcreatewindow.width = static_cast<int>(width);
+        e.xcreatewindow.height = static_cast<int>(height);
+        e.xcreatewindow.override_redirect = override_redirect;
+        NotifyStructure(w, e);
+        return w;
+    }
+
+    void FakeBackend::ClientMapWindow(Window w)
+    {
+        const WindowState& window = m_windows.at(w);
+        if (window.m_mapped)
+        {
+            return;
+        }
+
+        if (IsRedirected(w))
+        {
+            XEvent e = MakeEvent(MapRequest);
+            e.xmaprequest.serial = ++m_serial;
+            e.xmaprequest.parent = window.m_parent;
+            e.xmaprequest.window = w;
+            m_events.push_back(e);
+            return;
+        }
+        Map(w);
+    }
+
+    void FakeBackend::ClientUnmapWindow(Window w)
+    {
+        Unmap(w);
+    }
+
+    void FakeBackend::ClientConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes)
+    {
+        const WindowState& window = m_windows.at(w);
+        if (!IsRedirected(w))
+        {
+            ConfigureWindow(w, value_mask, changes);
+            return;
+        }
+
+        XEvent e = MakeEvent(ConfigureRequest);
+        e.xconfigurerequest.serial = ++m_serial;
+        e.xconfigurerequest.parent = window.m_parent;
+        e.xconfigurerequest.window = w;
+        e.xconfigurerequest.x = changes.x;
+        e.xconfigurerequest.y = changes.y;
+        e.xconfigurerequest.width = changes.width;
+        e.xconfigurerequest.height = changes.height;
+        e.xconfigurerequest.border_width = changes.border_width;
+        e.xconfigurerequest.above = changes.sibling;
+        e.xconfigurerequest.detail = changes.stack_mode;
+        e.xconfigurerequest.value_mask = value_mask;
+        m_events.push_back(e);
+    }
+
+    void FakeBackend::ClientDestroyWindow(Window w)
+    {
+        // Requests and client destruction look the same to the server.
+        DestroyWindow(w);
+    }
+
+    void FakeBackend::ClientSetProperty(Window w, Atom property, Atom type, const std::vector<std::uint32_t>& items)
+    {
+        PropertyReply& value = m_windows.at(w).m_properties[property];
+        value.m_type = type;
+        value.m_format = 32;
+        value.m_numItems = static_cast<unsigned int>(items.size());
+        value.m_data.resize(items.size() * sizeof(std::uint32_t));
+        std::memcpy(value.m_data.data(), items.data(), value.m_data.size());
+        NotifyProperty(w, property);
+    }
+
+    void FakeBackend::ClientSetProperty(Window w, Atom property, Atom type, const std::string& text)
+    {
+        PropertyReply& value = m_windows.at(w).m_properties[property];
+        value.m_type = type;
+        value.m_format = 8;
+        value.m_numItems = static_cast<unsigned int>(text.size());
+        value.m_data.assign(text.begin(), text.end());
+        NotifyProperty(w, property);
+    }
+
+    void FakeBackend::QueueEvent(const XEvent& e)
+    {
+        m_events.push_back(e);
+    }
+
+    void FakeBackend::QueuePointerEvent(const PointerEvent& pointer)
+    {
+        XEvent e = MakeEvent(GenericEvent);
+        e.xcookie.serial = m_serial;
+        e.xcookie.extension = FAKE_XI_OPCODE;
+        e.xcookie.evtype = pointer.m_type;
+        e.xcookie.cookie = m_nextCookie++;
+        m_pointerEvents[e.xcookie.cookie] = pointer;
+        m_events.push_back(e);
+    }
+
+    void FakeBackend::EnsureWindow(Window w)
+    {
+        if (w == None || m_windows.count(w))
+        {
+            return;
+        }
+
+        WindowState& window = m_windows[w];
+        window.m_parent = m_rootWindow;
+        m_windows[m_rootWindow].m_children.push_back(w);
+    }
+
+    void FakeBackend::ReserveWindowId(Window w)
+    {
+        m_reservedIds.push_back(w);
+    }
+
+    const FakeBackend::WindowState* FakeBackend::FindWindow(Window w) const
+    {
+        const auto i = m_windows.find(w);
+        return i != m_windows.end() ? &i->second : nullptr;
+    }
+
+    //------------------------------------------------------------------//
+    //                             XBACKEND                             //
+    //------------------------------------------------------------------//
+
+    Atom FakeBackend::InternAtom(const std::string& name)
+    {
+        ++m_requestCount;
+        const auto [i, inserted] = m_atoms.try_emplace(name, m_nextAtom);
+        if (inserted)
+        {
+            ++m_nextAtom;
+        }
+        return i->second;
+    }
+
+    void FakeBackend::RedirectRoot(long event_mask)
+    {
+        ++m_requestCount;
+        m_windows[m_rootWindow].m_eventMask = event_mask;
+    }
+
+    bool FakeBackend::Pending()
+    {
+        return !m_events.empty();
+    }
+
+    void FakeBackend::NextEvent(XEvent& e)
+    {
+        // A real server would block forever.
+        if (m_events.empty())
+        {
+            throw std::runtime_error("FakeBackend: no event to wait for");
+        }
+        e = m_events.front();
+        m_events.pop_front();
+    }
+
+    bool FakeBackend::CheckTypedWindowEvent(Window w, int type, XEvent& e)
+    {
+        const auto i = std::find_if(m_events.begin(), m_events.end(), [w, type](const XEvent& queued)
+        {
+            return queued.type == type && queued.xany.window == w;
+        });
+
+        if (i == m_events.end())
+        {
+            return false;
+        }
+        e = *i;
+        m_events.erase(i);
+        return true;
+    }
+
+    void FakeBackend::Flush()
+    {
+
+    }
+
+    void FakeBackend::Sync()
+    {
+        ++m_requestCount;
+    }
+
+    bool FakeBackend::GrabPointerMotion(Window w, Time /*time*/)
+    {
+        ++m_requestCount;
+        m_pointerGrab = w;
+        m_pointerGrabRequest = m_requestCount;
+        return true;
+    }
+
+    void FakeBackend::UngrabPointerMotion(Time /*time*/)
+    {
+        ++m_requestCount;
+        m_pointerGrab = None;
+    }
+
+    bool FakeBackend::GetPointerEvent(XEvent& e, PointerEvent& pointer)
+    {
+        if (e.type != GenericEvent || e.xcookie.extension != FAKE_XI_OPCODE)
+        {
+            return false;
+        }
+
+        const auto i = m_pointerEvents.find(e.xcookie.cookie);
+        if (i == m_pointerEvents.end())
+        {
+            return false;
+        }
+        pointer = i->second;
+        m_pointerEvents.erase(i);
+        return true;
+    }
+
+    void FakeBackend::GrabServer()
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::UngrabServer()
+    {
+        ++m_requestCount;
+    }
+
+    std::vector<Window> FakeBackend::QueryTree(Window w)
+    {
+        ++m_requestCount;
+        const auto i = m_windows.find(w);
+        if (i == m_windows.end())
+        {
+            throw std::runtime_error("FakeBackend: QueryTree on unknown window");
+        }
+        return i->second.m_children;
+    }
+
+    bool FakeBackend::GetWindowAttributes(Window w, XWindowAttributes& attributes)
+    {
+        ++m_requestCount;
+        const auto i = m_windows.find(w);
+        if (i == m_windows.end())
+        {
+            return false;
+        }
+
+        const WindowState& window = i->second;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.x = window.m_x;
+        attributes.y = window.m_y;
+        attributes.width = static_cast<int>(window.m_width);
+        attributes.height = static_cast<int>(window.m_height);
+        attributes.border_width = static_cast<int>(window.m_borderWidth);
+        attributes.root = m_rootWindow;
+        attributes.override_redirect = window.m_overrideRedirect;
+        attributes.your_event_mask = window.m_eventMask;
+
+        // Viewable only if every ancestor is mapped too.
+        attributes.map_state = IsUnmapped;
+        if (window.m_mapped)
+        {
+            attributes.map_state = IsViewable;
+            for (Window parent = window.m_parent; parent != None; parent = m_windows[parent].m_parent)
+            {
+                if (!m_windows[parent].m_mapped)
+                {
+                    attributes.map_state = IsUnviewable;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool FakeBackend::GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height)
+    {
+        ++m_requestCount;
+        const auto i = m_windows.find(w);
+        if (i == m_windows.end())
+        {
+            return false;
+        }
+        x = i->second.m_x;
+        y = i->second.m_y;
+        width = i->second.m_width;
+        height = i->second.m_height;
+        return true;
+    }
+
+    Window FakeBackend::CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                           unsigned int border_width, unsigned long /*border*/, unsigned long /*background*/)
+    {
+        ++m_requestCount;
+        Window w = m_nextWindow++;
+        if (!m_reservedIds.empty())
+        {
+            w = m_reservedIds.front();
+            m_reservedIds.pop_front();
+        }
+
+        NewWindow(w, parent, x, y, width, height);
+        m_windows[w].m_borderWidth = border_width;
+
+        XEvent e = MakeEvent(CreateNotify);
+        e.xcreatewindow.window = w;
+        e.xcreatewindow.x = x;
+        e.xcreatewindow.y = y;
+        e.xcreatewindow.width = static_cast<int>(width);
+        e.xcreatewindow.height = static_cast<int>(height);
+        e.xcreatewindow.border_width = static_cast<int>(border_width);
+        NotifyStructure(w, e);
+        return w;
+    }
+
+    void FakeBackend::DestroyWindow(Window w)
+    {
+        ++m_requestCount;
+        const auto i = m_windows.find(w);
+        if (i == m_windows.end() || w == m_rootWindow)
+        {
+            return;
+        }
+
+        if (i->second.m_mapped)
+        {
+            Unmap(w);
+        }
+
+        // Children go first, as on a real server.
+        const Window parent = i->second.m_parent;
+        const std::vector<Window> children = i->second.m_children;
+        for (const Window child : children)
+        {
+            DestroyWindow(child);
+        }
+
+        XEvent e = MakeEvent(DestroyNotify);
+        e.xdestroywindow.window = w;
+        NotifyStructure(w, e);
+
+        RemoveChild(m_windows.at(parent).m_children, w);
+        m_windows.erase(w);
+        if (m_focus == w)
+        {
+            m_focus = None;
+        }
+    }
+
+    void FakeBackend::SelectInput(Window w, long event_mask)
+    {
+        ++m_requestCount;
+        m_windows.at(w).m_eventMask = event_mask;
+    }
+
+    void FakeBackend::ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes)
+    {
+        ++m_requestCount;
+        if (value_mask & CWEventMask)
+        {
+            m_windows.at(w).m_eventMask = attributes.event_mask;
+        }
+    }
+
+    void FakeBackend::MapWindow(Window w)
+    {
+        ++m_requestCount;
+        if (!m_windows.at(w).m_mapped)
+        {
+            Map(w);
+        }
+    }
+
+    void FakeBackend::UnmapWindow(Window w)
+    {
+        ++m_requestCount;
+        if (m_windows.at(w).m_mapped)
+        {
+            Unmap(w);
+        }
+    }
+
+    void FakeBackend::ReparentWindow(Window w, Window parent, int x, int y)
+    {
+        ++m_requestCount;
+
+        // A mapped window is unmapped first and mapped again under its new
+        // parent, which is where the UnmapNotify for pre-existing windows
+        // comes from.
+        const bool was_mapped = m_windows.at(w).m_mapped;
+        if (was_mapped)
+        {
+            Unmap(w);
+        }
+
+        WindowState& window = m_windows.at(w);
+        const Window old_parent = window.m_parent;
+        RemoveChild(m_windows[old_parent].m_children, w);
+        m_windows.at(parent).m_children.push_back(w);
+        window.m_parent = parent;
+        window.m_x = x;
+        window.m_y = y;
+
+        // Reported to the old parent, the new parent and the window itself.
+        XEvent e = MakeEvent(ReparentNotify);
+        e.xreparent.window = w;
+        e.xreparent.parent = parent;
+        e.xreparent.x = x;
+        e.xreparent.y = y;
+        e.xreparent.override_redirect = window.m_overrideRedirect;
+        NotifyStructure(w, e);
+        if (m_windows[old_parent].m_eventMask & SubstructureNotifyMask)
+        {
+            e.xreparent.serial = ++m_serial;
+            e.xreparent.event = old_parent;
+            m_events.push_back(e);
+        }
+
+        if (was_mapped)
+        {
+            Map(w);
+        }
+    }
+
+    void FakeBackend::AddToSaveSet(Window /*w*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::RemoveFromSaveSet(Window /*w*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes)
+    {
+        ++m_requestCount;
+        WindowState& window = m_windows.at(w);
+
+        if (value_mask & CWX)
+        {
+            window.m_x = changes.x;
+        }
+        if (value_mask & CWY)
+        {
+            window.m_y = changes.y;
+        }
+        // Zero sizes are a BadValue on a real server, keep the old one.
+        if ((value_mask & CWWidth) && changes.width > 0)
+        {
+            window.m_width = static_cast<unsigned int>(changes.width);
+        }
+        if ((value_mask & CWHeight) && changes.height > 0)
+        {
+            window.m_height = static_cast<unsigned int>(changes.height);
+        }
+        if (value_mask & CWBorderWidth)
+        {
+            window.m_borderWidth = static_cast<unsigned int>(changes.border_width);
+        }
+        if ((value_mask & CWStackMode) && changes.stack_mode == Above)
+        {
+            std::vector<Window>& siblings = m_windows[window.m_parent].m_children;
+            RemoveChild(siblings, w);
+            siblings.push_back(w);
+        }
+
+        XEvent e = MakeEvent(ConfigureNotify);
+        e.xconfigure.window = w;
+        e.xconfigure.x = window.m_x;
+        e.xconfigure.y = window.m_y;
+        e.xconfigure.width = static_cast<int>(window.m_width);
+        e.xconfigure.height = static_cast<int>(window.m_height);
+        e.xconfigure.border_width = static_cast<int>(window.m_borderWidth);
+        e.xconfigure.override_redirect = window.m_overrideRedirect;
+        NotifyStructure(w, e);
+    }
+
+    void FakeBackend::MoveWindow(Window w, int x, int y)
+    {
+        XWindowChanges changes;
+        changes.x = x;
+        changes.y = y;
+        ConfigureWindow(w, CWX | CWY, changes);
+    }
+
+    void FakeBackend::ResizeWindow(Window w, unsigned int width, unsigned int height)
+    {
+        XWindowChanges changes;
+        changes.width = static_cast<int>(width);
+        changes.height = static_cast<int>(height);
+        ConfigureWindow(w, CWWidth | CWHeight, changes);
+    }
+
+    void FakeBackend::RaiseWindow(Window w)
+    {
+        XWindowChanges changes;
+        changes.stack_mode = Above;
+        ConfigureWindow(w, CWStackMode, changes);
+    }
+
+    void FakeBackend::SetWindowBorderWidth(Window w, unsigned int width)
+    {
+        XWindowChanges changes;
+        changes.border_width = static_cast<int>(width);
+        ConfigureWindow(w, CWBorderWidth, changes);
+    }
+
+    void FakeBackend::SetWindowBorder(Window /*w*/, unsigned long /*pixel*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::SetWindowBackground(Window /*w*/, unsigned long /*pixel*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::ClearWindow(Window w)
+    {
+        ++m_requestCount;
+        const WindowState& window = m_windows.at(w);
+        if (!window.m_mapped || !(window.m_eventMask & ExposureMask))
+        {
+            return;
+        }
+
+        XEvent e = MakeEvent(Expose);
+        e.xexpose.serial = ++m_serial;
+        e.xexpose.window = w;
+        e.xexpose.width = static_cast<int>(window.m_width);
+        e.xexpose.height = static_cast<int>(window.m_height);
+        m_events.push_back(e);
+    }
+
+    void FakeBackend::CopyArea(Drawable /*src*/, Drawable /*dst*/, int /*src_x*/, int /*src_y*/,
+                               unsigned int /*width*/, unsigned int /*height*/, int /*dst_x*/, int /*dst_y*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::GrabButton(unsigned int /*button*/, unsigned int /*modifiers*/, Window /*w*/, unsigned int /*event_mask*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::GrabKey(KeyCode /*keycode*/, unsigned int /*modifiers*/, Window /*w*/)
+    {
+        ++m_requestCount;
+    }
+
+    void FakeBackend::UngrabKey(KeyCode /*keycode*/, unsigned int /*modifiers*/, Window /*w*/)
+    {
+        ++m_requestCount;
+    }
+
+    bool FakeBackend::GrabKeyboard(Window w, Time /*time*/)
+    {
+        ++m_requestCount;
+        m_keyboardGrab = w;
+        return true;
+    }
+
+    void FakeBackend::UngrabKeyboard(Time /*time*/)
+    {
+        ++m_requestCount;
+        m_keyboardGrab = None;
+    }
+
+    KeyCode FakeBackend::KeysymToKeycode(KeySym keysym)
+    {
+        // Any stable mapping onto the valid keycode range 8..255 will do.
+        return static_cast<KeyCode>(8 + keysym % 248);
+    }
+
+    void FakeBackend::SetInputFocus(Window w)
+    {
+        ++m_requestCount;
+        m_focus = w;
+    }
+
+    void FakeBackend::KillClient(Window w)
+    {
+        DestroyWindow(w);
+    }
+
+    bool FakeBackend::SendEvent(Window w, long /*event_mask*/, XEvent& /*e*/)
+    {
+        ++m_requestCount;
+        return m_windows.count(w) != 0;
+    }
+
+    std::vector<PropertyReply> FakeBackend::GetProperties(const std::vector<PropertyRequest>& requests)
+    {
+        ++m_requestCount;
+        std::vector<PropertyReply> replies(requests.size());
+
+        for (std::size_t i = 0; i < requests.size(); ++i)
+        {
+            const PropertyRequest& request = requests[i];
+            const auto window = m_windows.find(request.m_window);
+            if (window == m_windows.end())
+            {
+                continue;
+            }
+
+            const auto property = window->second.m_properties.find(request.m_property);
+            if (property == window->second.m_properties.end())
+            {
+                continue;
+            }
+
+            if (request.m_type == AnyPropertyType || request.m_type == property->second.m_type)
+            {
+                replies[i] = property->second;
+            }
+        }
+        return replies;
+    }
+
+    void FakeBackend::ChangeProperty(Window w, Atom property, Atom type, int format,
+                                     const unsigned char* data, int num_items)
+    {
+        ++m_requestCount;
+        const auto i = m_windows.find(w);
+        if (i == m_windows.end())
+        {
+            return;
+        }
+
+        // Like Xlib, 32 bit items are passed as longs and stored as 32 bits.
+        PropertyReply& value = i->second.m_properties[property];
+        value.m_type = type;
+        value.m_format = format;
+        value.m_numItems = static_cast<unsigned int>(num_items);
+        value.m_data.clear();
+        for (int item = 0; item < num_items; ++item)
+        {
+            switch (format)
+            {
+                case 8:
+                    value.m_data.push_back(data[item]);
+                break;
+
+                case 16:
+                    value.m_data.insert(value.m_data.end(), data + 2 * item, data + 2 * item + 2);
+                break;
+
+                default:
+                {
+                    long item_value;
+                    std::memcpy(&item_value, data + static_cast<std::size_t>(item) * sizeof(long), sizeof(long));
+                    const std::uint32_t stored = static_cast<std::uint32_t>(item_value);
+                    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&stored);
+                    value.m_data.insert(value.m_data.end(), bytes, bytes + sizeof(stored));
+                }
+                break;
+            }
+        }
+        NotifyProperty(w, property);
+    }
+
+    //------------------------------------------------------------------//
+    //                              PRIVATE                             //
+    //------------------------------------------------------------------//
+
+    void FakeBackend::NewWindow(Window w, Window parent, int x, int y, unsigned int width, unsigned int height)
+    {
+        // A reused id replaces the old window, like on a real server where
+        // the old one must have been destroyed first.
+        if (m_windows.count(w))
+        {
+            RemoveChild(m_windows.at(m_windows[w].m_parent).m_children, w);
+            m_windows.erase(w);
+        }
+
+        WindowState& window = m_windows[w];
+        window.m_parent = parent;
+        window.m_x = x;
+        window.m_y = y;
+        window.m_width = std::max(1u, width);
+        window.m_height = std::max(1u, height);
+
+        m_windows.at(parent).m_children.push_back(w);
+    }
+
+    void FakeBackend::NotifyStructure(Window w, XEvent e)
+    {
+        e.xany.serial = ++m_serial;
+
+        const WindowState& window = m_windows.at(w);
+        if ((window.m_eventMask & StructureNotifyMask) && e.type != CreateNotify)
+        {
+            e.xany.window = w;
+            m_events.push_back(e);
+        }
+
+        const auto parent = m_windows.find(window.m_parent);
+        if (parent != m_windows.end() && (parent->second.m_eventMask & SubstructureNotifyMask))
+        {
+            e.xany.window = window.m_parent;
+            m_events.push_back(e);
+        }
+    }
+
+    void FakeBackend::NotifyProperty(Window w, Atom property)
+    {
+        if (m_windows.at(w).m_eventMask & PropertyChangeMask)
+        {
+            XEvent e = MakeEvent(PropertyNotify);
+            e.xproperty.serial = ++m_serial;
+            e.xproperty.window = w;
+            e.xproperty.atom = property;
+            e.xproperty.state = PropertyNewValue;
+            m_events.push_back(e);
+        }
+    }
+
+    bool FakeBackend::IsRedirected(Window w) const
+    {
+        const WindowState& window = m_windows.at(w);
+        if (window.m_overrideRedirect)
+        {
+            return false;
+        }
+
+        const auto parent = m_windows.find(window.m_parent);
+        return parent != m_windows.end() && (parent->second.m_eventMask & SubstructureRedirectMask);
+    }
+
+    void FakeBackend::Map(Window w)
+    {
+        WindowState& window = m_windows.at(w);
+        window.m_mapped = true;
+
+        XEvent e = MakeEvent(MapNotify);
+        e.xmap.window = w;
+        e.xmap.override_redirect = window.m_overrideRedirect;
+        NotifyStructure(w, e);
+
+        // A newly visible window needs painting.
+        if (window.m_eventMask & ExposureMask)
+        {
+            XEvent expose = MakeEvent(Expose);
+            expose.xexpose.serial = ++m_serial;
+            expose.xexpose.window = w;
+            expose.xexpose.width = static_cast<int>(window.m_width);
+            expose.xexpose.height = static_cast<int>(window.m_height);
+            m_events.push_back(expose);
+        }
+    }
+
+    void FakeBackend::Unmap(Window w)
+    {
+        m_windows.at(w).m_mapped = false;
+
+        XEvent e = MakeEvent(UnmapNotify);
+        e.xunmap.window = w;
+        NotifyStructure(w, e);
+    }
+}
@@ -0,0 +1,46 @@
+#include "focus_settle.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    FocusSettle::FocusSettle(Clock::duration delay)
+        : m_delay{delay}
+    {
+
+    }
+
+    void FocusSettle::Push(const Position<int>& pos, Clock::time_point now)
+    {
+        ++m_pushedCount;
+        m_pending = pos;
+        m_deadline = now + m_delay;
+    }
+
+    std::optional<Position<int>> FocusSettle::TakeDue(Clock::time_point now)
+    {
+        if (!m_pending || m_deadline > now)
+        {
+            return std::nullopt;
+        }
+
+        ++m_settledCount;
+        std::optional<Position<int>> pos;
+        pos.swap(m_pending);
+        return pos;
+    }
+
+    void FocusSettle::Cancel()
+    {
+        m_pending.reset();
+    }
+
+    std::optional<FocusSettle::Clock::duration> FocusSettle::GetTimeout(Clock::time_point now) const
+    {
+        if (!m_pending)
+        {
+            return std::nullopt;
+        }
+        return std::max(Clock::duration::zero(), m_deadline - now);
+    }
+}
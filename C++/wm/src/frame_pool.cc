@@ -0,0 +1,77 @@
+#include "frame_pool.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    FramePool::FramePool(std::size_t capacity, Clock::duration idle_timeout)
+        : m_capacity{capacity},
+          m_idleTimeout{idle_timeout}
+    {
+
+    }
+
+    Window FramePool::Take()
+    {
+        if (m_frames.empty())
+        {
+            ++m_missCount;
+            return None;
+        }
+
+        ++m_hitCount;
+        const Window frame = m_frames.back().m_frame;
+        m_frames.pop_back();
+        return frame;
+    }
+
+    bool FramePool::Give(Window frame, Clock::time_point now)
+    {
+        if (m_frames.size() >= m_capacity)
+        {
+            ++m_overflowCount;
+            return false;
+        }
+
+        m_frames.push_back({frame, now});
+        return true;
+    }
+
+    std::vector<Window> FramePool::TakeIdle(Clock::time_point now)
+    {
+        // Frames are returned in time order, the idle ones are at the front.
+        const auto end = std::find_if(m_frames.begin(), m_frames.end(), [this, now](const Entry& entry)
+        {
+            return now - entry.m_returned < m_idleTimeout;
+        });
+
+        std::vector<Window> idle;
+        for (auto i = m_frames.begin(); i != end; ++i)
+        {
+            idle.push_back(i->m_frame);
+        }
+        m_frames.erase(m_frames.begin(), end);
+        m_trimmedCount += idle.size();
+        return idle;
+    }
+
+    std::vector<Window> FramePool::TakeAll()
+    {
+        std::vector<Window> frames;
+        for (const Entry& entry : m_frames)
+        {
+            frames.push_back(entry.m_frame);
+        }
+        m_frames.clear();
+        return frames;
+    }
+
+    std::optional<FramePool::Clock::duration> FramePool::GetTimeout(Clock::time_point now) const
+    {
+        if (m_frames.empty())
+        {
+            return std::nullopt;
+        }
+        return std::max(Clock::duration::zero(), m_frames.front().m_returned + m_idleTimeout - now);
+    }
+}
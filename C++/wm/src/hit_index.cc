@@ -0,0 +1,169 @@
+#include "hit_index.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    HitIndex::HitIndex(int cell_size)
+        : m_cellSize{cell_size}
+    {
+
+    }
+
+    void HitIndex::Update(const Placement& placement)
+    {
+        if (m_generation == placement.GetGeneration())
+        {
+            return;
+        }
+        m_generation = placement.GetGeneration();
+
+        // 1. Copy the frames and find their bounding box.
+        const RectArray& rects = placement.GetRects();
+        m_windows = placement.GetWindows();
+        m_rects.clear();
+        m_indices.clear();
+        m_bounds = Rect<int>{};
+        for (std::size_t i = 0; i < rects.GetSize(); ++i)
+        {
+            m_rects.push_back(rects.Get(i));
+            m_bounds |= m_rects.back();
+            m_indices[m_windows[i]] = i;
+        }
+
+        // 2. List every frame in each cell it overlaps, the topmost frames
+        // first.
+        std::vector<std::int64_t> stacking(m_windows.size(), 0);
+        std::vector<std::uint32_t> order(m_windows.size());
+        for (std::size_t i = 0; i < m_windows.size(); ++i)
+        {
+            const auto raised = m_stacking.find(m_windows[i]);
+            stacking[i] = raised != m_stacking.end() ? raised->second : 0;
+            order[i] = static_cast<std::uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&stacking](std::uint32_t a, std::uint32_t b)
+        {
+            return stacking[a] > stacking[b];
+        });
+
+        m_columns = (m_bounds.m_width + m_cellSize - 1) / m_cellSize;
+        const int rows = (m_bounds.m_height + m_cellSize - 1) / m_cellSize;
+        m_cells.assign(static_cast<std::size_t>(m_columns * rows), {});
+        for (const std::uint32_t i : order)
+        {
+            ForEachCell(m_rects[i], [i](std::vector<std::uint32_t>& cell)
+            {
+                cell.push_back(i);
+            });
+        }
+    }
+
+    void HitIndex::Raise(Window frame)
+    {
+        m_stacking[frame] = m_nextStacking++;
+
+        // Keep the cells in stacking order without a rebuild.
+        const auto index = m_indices.find(frame);
+        if (index == m_indices.end())
+        {
+            return;
+        }
+        const std::uint32_t i = static_cast<std::uint32_t>(index->second);
+        ForEachCell(m_rects[i], [i](std::vector<std::uint32_t>& cell)
+        {
+            const auto position = std::find(cell.begin(), cell.end(), i);
+            std::rotate(cell.begin(), position, position + 1);
+        });
+    }
+
+    void HitIndex::Lower(Window frame)
+    {
+        m_stacking[frame] = m_nextLowering--;
+
+        const auto index = m_indices.find(frame);
+        if (index == m_indices.end())
+        {
+            return;
+        }
+        const std::uint32_t i = static_cast<std::uint32_t>(index->second);
+        ForEachCell(m_rects[i], [i](std::vector<std::uint32_t>& cell)
+        {
+            const auto position = std::find(cell.begin(), cell.end(), i);
+            std::rotate(position, position + 1, cell.end());
+        });
+    }
+
+    void HitIndex::Restack(Window frame, Window sibling, bool above)
+    {
+        // Make room next to the sibling by shifting everything past it.
+        const auto found = m_stacking.find(sibling);
+        const std::int64_t position = found != m_stacking.end() ? found->second : 0;
+        m_stacking.erase(frame);
+        for (auto& [window, stacking] : m_stacking)
+        {
+            if (above && stacking > position)
+            {
+                ++stacking;
+            }
+            else if (!above && stacking < position)
+            {
+                --stacking;
+            }
+        }
+        if (above)
+        {
+            m_stacking[frame] = position + 1;
+            ++m_nextStacking;
+        }
+        else
+        {
+            m_stacking[frame] = position - 1;
+            --m_nextLowering;
+        }
+
+        m_generation.reset();
+    }
+
+    void HitIndex::Remove(Window frame)
+    {
+        m_stacking.erase(frame);
+    }
+
+    Window HitIndex::FindTopmost(const Position<int>& pos) const
+    {
+        if (!m_bounds.Contains(pos))
+        {
+            return None;
+        }
+
+        const int column = (pos.m_x - m_bounds.m_x) / m_cellSize;
+        const int row = (pos.m_y - m_bounds.m_y) / m_cellSize;
+        for (const std::uint32_t i : m_cells[static_cast<std::size_t>(row * m_columns + column)])
+        {
+            if (m_rects[i].Contains(pos))
+            {
+                return m_windows[i];
+            }
+        }
+        return None;
+    }
+
+    std::pair<int, int> HitIndex::GetCells(int start, int end, int origin) const
+    {
+        return {(start - origin) / m_cellSize, (end - origin + m_cellSize - 1) / m_cellSize};
+    }
+
+    template <typename F>
+    void HitIndex::ForEachCell(const Rect<int>& rect, F&& f)
+    {
+        const auto [first_column, last_column] = GetCells(rect.m_x, rect.GetRight(), m_bounds.m_x);
+        const auto [first_row, last_row] = GetCells(rect.m_y, rect.GetBottom(), m_bounds.m_y);
+        for (int row = first_row; row < last_row; ++row)
+        {
+            for (int column = first_column; column < last_column; ++column)
+            {
+                f(m_cells[static_cast<std::size_t>(row * m_columns + column)]);
+            }
+        }
+    }
+}
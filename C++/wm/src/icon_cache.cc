@@ -0,0 +1,63 @@
+#include "icon_cache.h"
+#include <functional>
+
+
+namespace WM
+{
+    Icon::~Icon()
+    {
+        XFreePixmap(m_connection, m_pixmap);
+        XFlush(m_connection);
+    }
+
+    std::size_t IconKeyHash::operator () (const IconKey& key) const
+    {
+        // The content hash is already well mixed, fold the class name into it.
+        return std::hash<std::string>{}(key.m_class)
+            ^ static_cast<std::size_t>((key.m_hash ^ key.m_background) * 0x9e3779b97f4a7c15ull);
+    }
+
+    std::shared_ptr<const Icon> IconCache::Find(const IconKey& key)
+    {
+        const auto i = m_index.find(key);
+        if (i == m_index.end())
+        {
+            return nullptr;
+        }
+
+        // Move to the front of the recency list.
+        m_entries.splice(m_entries.begin(), m_entries, i->second);
+        return i->second->second;
+    }
+
+    void IconCache::Insert(const IconKey& key, std::shared_ptr<const Icon> icon)
+    {
+        if (m_capacity == 0)
+        {
+            return;
+        }
+
+        const auto i = m_index.find(key);
+        if (i != m_index.end())
+        {
+            i->second->second = std::move(icon);
+            m_entries.splice(m_entries.begin(), m_entries, i->second);
+            return;
+        }
+
+        if (m_entries.size() >= m_capacity)
+        {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+
+        m_entries.emplace_front(key, std::move(icon));
+        m_index.emplace(key, m_entries.begin());
+    }
+
+    void IconCache::Clear()
+    {
+        m_index.clear();
+        m_entries.clear();
+    }
+}
@@ -0,0 +1,271 @@
+#include "icon_loader.h"
+#include "pixel_ops.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// XGetClassHint
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+
+
+namespace WM
+{
+    namespace
+    {
+        // Largest _NET_WM_ICON we read, in 32 bit items (16 MiB of ARGB).
+        constexpr long MAX_ICON_ITEMS = 4 * 1024 * 1024;
+
+        // Number of distinct icons kept uploaded.
+        constexpr std::size_t ICON_CACHE_CAPACITY = 128;
+
+        // FNV-1a over the image dimensions and pixels.
+        std::uint64_t HashIcon(unsigned int width, unsigned int height, const std::vector<std::uint32_t>& pixels)
+        {
+            std::uint64_t hash = 0xcbf29ce484222325ull;
+            const auto mix = [&hash] (std::uint32_t value)
+            {
+                hash = (hash ^ value) * 0x100000001b3ull;
+            };
+
+            mix(width);
+            mix(height);
+            for (const std::uint32_t pixel : pixels)
+            {
+                mix(pixel);
+            }
+            return hash;
+        }
+    }
+
+    IconLoader::IconLoader(const std::string& displayName, unsigned int size, std::uint32_t background)
+        : m_connection{XOpenDisplay(displayName.empty() ? nullptr : displayName.c_str())},
+          m_rootWindow{None}, m_gc{nullptr}, NET_WM_ICON{None},
+          m_size{size}, m_background{background},
+          m_cache{ICON_CACHE_CAPACITY},
+          m_notifyFd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+    {
+        if (m_connection == nullptr)
+        {
+            throw std::runtime_error("Icon loader failed to open X display " + displayName);
+        }
+
+        if (m_notifyFd < 0)
+        {
+            XCloseDisplay(m_connection);
+            throw std::runtime_error("Icon loader failed to create eventfd");
+        }
+
+        m_rootWindow = DefaultRootWindow(m_connection);
+        m_gc = XCreateGC(m_connection, m_rootWindow, 0, nullptr);
+        NET_WM_ICON = XInternAtom(m_connection, "_NET_WM_ICON", false);
+
+        m_worker = std::thread{&IconLoader::WorkerMain, this};
+    }
+
+    IconLoader::~IconLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_worker.join();
+
+        // Drop our references before the connection owning the pixmaps goes.
+        m_results.clear();
+        m_cache.Clear();
+
+        XFreeGC(m_connection, m_gc);
+        XCloseDisplay(m_connection);
+        close(m_notifyFd);
+    }
+
+    void IconLoader::Request(Window client)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(client);
+        }
+        m_wakeup.notify_one();
+    }
+
+    std::vector<IconLoader::Result> IconLoader::TakeResults()
+    {
+        // Reset the eventfd counter before taking the queue, so a result
+        // posted in between wakes the loop again.
+        std::uint64_t counter;
+        if (read(m_notifyFd, &counter, sizeof(counter)) < 0)
+        {
+            // EAGAIN, nothing was signalled.
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Result> results;
+        results.swap(m_results);
+        return results;
+    }
+
+    void IconLoader::WorkerMain()
+    {
+        while (true)
+        {
+            Window client;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeup.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if (m_stop)
+                {
+                    return;
+                }
+                client = m_jobs.front();
+                m_jobs.pop_front();
+            }
+
+            std::shared_ptr<const Icon> icon = Load(client);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_results.push_back(Result{client, std::move(icon)});
+            }
+
+            const std::uint64_t one = 1;
+            if (write(m_notifyFd, &one, sizeof(one)) < 0)
+            {
+                // The counter can only overflow after 2^64 results.
+            }
+        }
+    }
+
+    std::shared_ptr<const Icon> IconLoader::Load(Window client)
+    {
+        // 1. Read the class name, part of the cache key.
+        std::string class_name;
+        XClassHint class_hint;
+        if (XGetClassHint(m_connection, client, &class_hint))
+        {
+            class_name = class_hint.res_class != nullptr ? class_hint.res_class : "";
+            XFree(class_hint.res_name);
+            XFree(class_hint.res_class);
+        }
+
+        // 2. Read the whole icon property. It is a list of width, height and
+        // width * height ARGB values, one entry per size the client offers.
+        Atom actual_type;
+        int actual_format;
+        unsigned long num_items;
+        unsigned long bytes_after;
+        unsigned char* data = nullptr;
+
+        if (XGetWindowProperty(m_connection, client, NET_WM_ICON, 0, MAX_ICON_ITEMS, false, XA_CARDINAL,
+                               &actual_type, &actual_format, &num_items, &bytes_after, &data) != Success
+            || data == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Format 32 properties are returned as an array of long.
+        const unsigned long* items = reinterpret_cast<const unsigned long*>(data);
+
+        // 3. Pick the smallest image at least as big as the icon, or the
+        // biggest one if they are all smaller.
+        const unsigned long* best = nullptr;
+        unsigned long best_width = 0;
+        unsigned long best_height = 0;
+
+        if (actual_format == 32)
+        {
+            for (unsigned long i = 0; i + 2 <= num_items;)
+            {
+                const unsigned long width = items[i];
+                const unsigned long height = items[i + 1];
+                if (width == 0 || height == 0 || width * height > num_items - i - 2)
+                {
+                    break;
+                }
+
+                const unsigned long extent = std::max(width, height);
+                const unsigned long best_extent = std::max(best_width, best_height);
+                const bool fits = extent >= m_size;
+                const bool best_fits = best_extent >= m_size;
+                if (best == nullptr
+                    || (fits && (!best_fits || extent < best_extent))
+                    || (!fits && !best_fits && extent > best_extent))
+                {
+                    best = items + i + 2;
+                    best_width = width;
+                    best_height = height;
+                }
+                i += 2 + width * height;
+            }
+        }
+
+        if (best == nullptr)
+        {
+            XFree(data);
+            return nullptr;
+        }
+
+        std::vector<std::uint32_t> argb(best, best + best_width * best_height);
+        XFree(data);
+
+        const unsigned int width = static_cast<unsigned int>(best_width);
+        const unsigned int height = static_cast<unsigned int>(best_height);
+
+        // 4. Identical icons decode only once.
+        const std::uint32_t background = m_background;
+        const IconKey key{class_name, HashIcon(width, height, argb), background};
+        if (std::shared_ptr<const Icon> cached = m_cache.Find(key))
+        {
+            return cached;
+        }
+
+        // 5. Decode, upload and cache.
+        std::vector<std::uint32_t> pixels(static_cast<std::size_t>(m_size) * m_size);
+        Pixel::ScaleIconArgb(argb.data(), width, height, pixels.data(), m_size, background);
+
+        const Pixmap pixmap = Upload(pixels);
+        if (pixmap == None)
+        {
+            return nullptr;
+        }
+
+        auto icon = std::make_shared<const Icon>(m_connection, pixmap, m_size);
+        m_cache.Insert(key, icon);
+        return icon;
+    }
+
+    Pixmap IconLoader::Upload(std::vector<std::uint32_t>& pixels)
+    {
+        const int screen = DefaultScreen(m_connection);
+        const int depth = DefaultDepth(m_connection, screen);
+
+        // Flattened pixels are 0x00RRGGBB, which only matches 24 and 32 bit
+        // true colour visuals.
+        if (depth != 24 && depth != 32)
+        {
+            return None;
+        }
+
+        const Pixmap pixmap = XCreatePixmap(m_connection, m_rootWindow, m_size, m_size, static_cast<unsigned int>(depth));
+
+        XImage* image = XCreateImage(m_connection, DefaultVisual(m_connection, screen), static_cast<unsigned int>(depth),
+                                     ZPixmap, 0, reinterpret_cast<char*>(pixels.data()),
+                                     m_size, m_size, 32, 0);
+        // Our buffer is in host order, Xlib swaps if the server differs.
+        image->byte_order = std::endian::native == std::endian::little ? LSBFirst : MSBFirst;
+
+        XPutImage(m_connection, pixmap, m_gc, image, 0, 0, 0, 0, m_size, m_size);
+
+        // The pixel buffer isn't owned by the image.
+        image->data = nullptr;
+        XDestroyImage(image);
+
+        // Make sure the pixmap exists before the event loop's connection
+        // refers to it.
+        XSync(m_connection, false);
+        return pixmap;
+    }
+}
@@ -1,19 +1,116 @@
+#include "recording_backend.h"
+#include "shared_settings.h"
+#include "util.h"
 #include "window_manager.h"
+#include "xlib_backend.h"
 #include <iostream>
 #include <exception>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 
-int main(void)
+namespace
 {
+    // Manages one display until it fails.
+    void RunDisplay(const std::string& display_name, const std::string& trace_path,
+                    std::shared_ptr<WM::SharedSettings> settings)
+    {
+        try
+        {
+            std::unique_ptr<WM::XBackend> backend = std::make_unique<WM::XlibBackend>(display_name);
+            if (!trace_path.empty())
+            {
+                backend = std::make_unique<WM::RecordingBackend>(std::move(backend), trace_path);
+            }
+
+            WM::WindowManager windowManager{std::move(backend), std::move(settings)};
+            windowManager.Run();
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+        }
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    // The icon loader talks to the server from its own thread, and so does
+    // the window manager of each display.
+    XInitThreads();
+
+    // --display NAME, repeated, manages several displays from this process.
+    // --trace FILE records the session for wm_replay.
+    std::vector<std::string> display_names;
+    std::string trace_path;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--display") == 0 && i + 1 < argc)
+        {
+            display_names.push_back(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--display NAME]... [--trace FILE]\n";
+            return 1;
+        }
+    }
+
+    // $DISPLAY by default.
+    if (display_names.empty())
+    {
+        display_names.emplace_back();
+    }
 
+    if (!trace_path.empty() && display_names.size() > 1)
+    {
+        std::cerr << "--trace records a single display\n";
+        return 1;
+    }
+
+    // The settings are loaded once for every display.
+    std::shared_ptr<WM::SharedSettings> settings;
     try
     {
-        WM::WindowManager windowManager{};
-        windowManager.Run();
+        settings = std::make_shared<WM::SharedSettings>(ConfigPath(""));
     }
     catch(const std::exception& e)
     {
         std::cerr << e.what() << '\n';
+        return 0;
+    }
+
+    if (display_names.size() == 1)
+    {
+        RunDisplay(display_names.front(), trace_path, std::move(settings));
+        return 0;
+    }
+
+    // Block SIGUSR1 before starting threads, so it only ever reaches the
+    // stats watcher of a window manager rather than killing the process.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // A thread per display, each with its own connection and event loop.
+    std::vector<std::thread> threads;
+    for (const std::string& display_name : display_names)
+    {
+        threads.emplace_back(RunDisplay, display_name, std::string{}, settings);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
     }
 
 
@@ -0,0 +1,93 @@
+#include "motion_compressor.h"
+#include <algorithm>
+
+
+namespace WM
+{
+    MotionCompressor::MotionCompressor(Time interval)
+        : m_interval{interval}
+    {
+
+    }
+
+    bool MotionCompressor::Push(const PointerEvent& sample, Clock::time_point now)
+    {
+        ++m_pushedCount;
+        Device& device = FindDevice(sample.m_device);
+
+        // Server time is 32 bit milliseconds and wraps, compare differences.
+        const Time elapsed = device.m_lastDelivered ? (sample.m_time - *device.m_lastDelivered) & 0xffffffff : m_interval;
+        if (elapsed >= m_interval)
+        {
+            device.m_lastDelivered = sample.m_time;
+            device.m_pending.reset();
+            ++m_deliveredCount;
+            return true;
+        }
+
+        // Too soon, hold it until the interval is over.
+        if (!device.m_pending)
+        {
+            device.m_deadline = now + std::chrono::milliseconds(m_interval - elapsed);
+        }
+        device.m_pending = sample;
+        return false;
+    }
+
+    void MotionCompressor::TakeDue(Clock::time_point now, std::vector<PointerEvent>& due)
+    {
+        for (Device& device : m_devices)
+        {
+            if (device.m_pending && device.m_deadline <= now)
+            {
+                device.m_lastDelivered = device.m_pending->m_time;
+                due.push_back(*device.m_pending);
+                device.m_pending.reset();
+                ++m_deliveredCount;
+            }
+        }
+    }
+
+    std::optional<PointerEvent> MotionCompressor::TakePending(int id)
+    {
+        Device& device = FindDevice(id);
+        std::optional<PointerEvent> pending;
+        pending.swap(device.m_pending);
+        if (pending)
+        {
+            device.m_lastDelivered = pending->m_time;
+            ++m_deliveredCount;
+        }
+        return pending;
+    }
+
+    std::optional<MotionCompressor::Clock::duration> MotionCompressor::GetTimeout(Clock::time_point now) const
+    {
+        std::optional<Clock::duration> timeout;
+        for (const Device& device : m_devices)
+        {
+            if (device.m_pending)
+            {
+                const Clock::duration remaining = std::max(Clock::duration::zero(), device.m_deadline - now);
+                timeout = timeout ? std::min(*timeout, remaining) : remaining;
+            }
+        }
+        return timeout;
+    }
+
+    MotionCompressor::Device& MotionCompressor::FindDevice(int id)
+    {
+        const auto i = std::find_if(m_devices.begin(), m_devices.end(), [id](const Device& device)
+        {
+            return device.m_id == id;
+        });
+        if (i != m_devices.end())
+        {
+            return *i;
+        }
+
+        m_devices.push_back(Device{});
+        m_devices.back().m_id = id;
+        return m_devices.back();
+    }
+}
@@ -0,0 +1,394 @@
+#include "pixel_ops.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define WM_PIXEL_X86 1
+    #include <immintrin.h>
+#endif
+
+
+namespace WM::Pixel
+{
+    namespace
+    {
+        // Kernels that have SIMD versions. The halving kernel works on one
+        // output row, reading two source rows.
+        using PremultiplyFn = void (*)(std::uint32_t* pixels, std::size_t count);
+        using HalveRowFn = void (*)(const std::uint32_t* row0, const std::uint32_t* row1,
+                                    unsigned int width, std::uint32_t* dst);
+
+        struct Kernels
+        {
+            PremultiplyFn m_premultiply;
+            HalveRowFn m_halveRow;
+        };
+
+        // (v * 255 + 127) / 255 without the division, exact for v <= 255 * 255.
+        inline std::uint32_t Div255(std::uint32_t v)
+        {
+            v += 128;
+            return (v + (v >> 8)) >> 8;
+        }
+
+        inline std::uint32_t Channel(std::uint32_t pixel, unsigned int shift)
+        {
+            return (pixel >> shift) & 0xff;
+        }
+
+        // ARGB spread to 0x00AA00RR00GG00BB and back, for filtering the
+        // channels of a pixel together in one 64 bit integer.
+        constexpr std::uint64_t LANE_MASK = 0x00ff00ff00ff00ffull;
+        constexpr std::uint64_t ROUND = 0x0080008000800080ull;
+
+        inline std::uint64_t Spread(std::uint32_t pixel)
+        {
+            std::uint64_t v = pixel;
+            v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+            return (v | (v << 8)) & LANE_MASK;
+        }
+
+        inline std::uint32_t Gather(std::uint64_t v)
+        {
+            v = (v | (v >> 8)) & 0x0000ffff0000ffffull;
+            return static_cast<std::uint32_t>(v | (v >> 16));
+        }
+
+        //------------------------------------------------------------------//
+        //                              SCALAR                              //
+        //------------------------------------------------------------------//
+
+        void PremultiplyScalar(std::uint32_t* pixels, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const std::uint32_t p = pixels[i];
+                const std::uint32_t a = p >> 24;
+                pixels[i] = (a << 24)
+                    | (Div255(Channel(p, 16) * a) << 16)
+                    | (Div255(Channel(p, 8) * a) << 8)
+                    | Div255(Channel(p, 0) * a);
+            }
+        }
+
+        inline std::uint32_t Average4(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d)
+        {
+            std::uint32_t out = 0;
+            for (unsigned int shift = 0; shift < 32; shift += 8)
+            {
+                const std::uint32_t sum = Channel(a, shift) + Channel(b, shift)
+                    + Channel(c, shift) + Channel(d, shift);
+                out |= ((sum + 2) >> 2) << shift;
+            }
+            return out;
+        }
+
+        void HalveRowScalar(const std::uint32_t* row0, const std::uint32_t* row1,
+                            unsigned int width, std::uint32_t* dst)
+        {
+            for (unsigned int x = 0; x + 1 < width; x += 2)
+            {
+                dst[x / 2] = Average4(row0[x], row0[x + 1], row1[x], row1[x + 1]);
+            }
+        }
+
+#ifdef WM_PIXEL_X86
+        //------------------------------------------------------------------//
+        //                               SSE2                               //
+        //------------------------------------------------------------------//
+
+        // Premultiplies 4 pixels.
+        inline __m128i Premultiply4(__m128i px)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i bias = _mm_set1_epi16(128);
+            const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xff000000u));
+
+            __m128i lo = _mm_unpacklo_epi8(px, zero);
+            __m128i hi = _mm_unpackhi_epi8(px, zero);
+
+            // Broadcast the alpha lane (lane 3 of each pixel) over the pixel.
+            const __m128i alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+            const __m128i alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+
+            lo = _mm_add_epi16(_mm_mullo_epi16(lo, alpha_lo), bias);
+            hi = _mm_add_epi16(_mm_mullo_epi16(hi, alpha_hi), bias);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+            const __m128i out = _mm_packus_epi16(lo, hi);
+            // Alpha itself stays as it was.
+            return _mm_or_si128(_mm_andnot_si128(alpha_mask, out), _mm_and_si128(alpha_mask, px));
+        }
+
+        void PremultiplySse2(std::uint32_t* pixels, std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i* p = reinterpret_cast<__m128i*>(pixels + i);
+                _mm_storeu_si128(p, Premultiply4(_mm_loadu_si128(p)));
+            }
+            PremultiplyScalar(pixels + i, count - i);
+        }
+
+        void HalveRowSse2(const std::uint32_t* row0, const std::uint32_t* row1,
+                          unsigned int width, std::uint32_t* dst)
+        {
+            unsigned int x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x + 4));
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x));
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x + 4));
+
+                // Vertical average, then split even and odd columns and
+                // average those.
+                const __m128 v0 = _mm_castsi128_ps(_mm_avg_epu8(a, c));
+                const __m128 v1 = _mm_castsi128_ps(_mm_avg_epu8(b, d));
+                const __m128i even = _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+                const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x / 2), _mm_avg_epu8(even, odd));
+            }
+            HalveRowScalar(row0 + x, row1 + x, width - x, dst + x / 2);
+        }
+
+        //------------------------------------------------------------------//
+        //                               AVX2                               //
+        //------------------------------------------------------------------//
+
+        __attribute__((target("avx2")))
+        void PremultiplyAvx2(std::uint32_t* pixels, std::size_t count)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i bias = _mm256_set1_epi16(128);
+            const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i* p = reinterpret_cast<__m256i*>(pixels + i);
+                const __m256i px = _mm256_loadu_si256(p);
+
+                // Unpacking and packing both work per 128 bit lane, so the
+                // pixel order comes out unchanged.
+                __m256i lo = _mm256_unpacklo_epi8(px, zero);
+                __m256i hi = _mm256_unpackhi_epi8(px, zero);
+                const __m256i alpha_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xff), 0xff);
+                const __m256i alpha_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xff), 0xff);
+
+                lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, alpha_lo), bias);
+                hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, alpha_hi), bias);
+                lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+                hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+                const __m256i out = _mm256_packus_epi16(lo, hi);
+                _mm256_storeu_si256(p, _mm256_or_si256(_mm256_andnot_si256(alpha_mask, out),
+                                                       _mm256_and_si256(alpha_mask, px)));
+            }
+            PremultiplySse2(pixels + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        void HalveRowAvx2(const std::uint32_t* row0, const std::uint32_t* row1,
+                          unsigned int width, std::uint32_t* dst)
+        {
+            unsigned int x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + x));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + x + 8));
+                const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + x));
+                const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + x + 8));
+
+                const __m256 v0 = _mm256_castsi256_ps(_mm256_avg_epu8(a, c));
+                const __m256 v1 = _mm256_castsi256_ps(_mm256_avg_epu8(b, d));
+                const __m256i even = _mm256_castps_si256(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+                const __m256i odd = _mm256_castps_si256(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+                // The shuffles interleave the two lanes, put the pairs back
+                // into column order.
+                const __m256i out = _mm256_permute4x64_epi64(_mm256_avg_epu8(even, odd), _MM_SHUFFLE(3, 1, 2, 0));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x / 2), out);
+            }
+            HalveRowSse2(row0 + x, row1 + x, width - x, dst + x / 2);
+        }
+#endif
+
+        Kernels SelectKernels()
+        {
+#ifdef WM_PIXEL_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return Kernels{&PremultiplyAvx2, &HalveRowAvx2};
+            }
+            return Kernels{&PremultiplySse2, &HalveRowSse2};
+#else
+            return Kernels{&PremultiplyScalar, &HalveRowScalar};
+#endif
+        }
+
+        const Kernels& GetKernels()
+        {
+            static const Kernels kernels{SelectKernels()};
+            return kernels;
+        }
+    }
+
+    void PremultiplyArgb(std::uint32_t* pixels, std::size_t count)
+    {
+        GetKernels().m_premultiply(pixels, count);
+    }
+
+    void HalveArgb(const std::uint32_t* src, unsigned int width, unsigned int height, std::uint32_t* dst)
+    {
+        const HalveRowFn halve_row = GetKernels().m_halveRow;
+        const std::size_t dst_width = width / 2;
+
+        for (unsigned int y = 0; y + 1 < height; y += 2)
+        {
+            const std::uint32_t* row0 = src + static_cast<std::size_t>(y) * width;
+            halve_row(row0, row0 + width, width, dst + (y / 2) * dst_width);
+        }
+    }
+
+    void ResampleArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                      std::uint32_t* dst, unsigned int dst_width, unsigned int dst_height)
+    {
+        // 16.16 fixed point step through the source, sampling pixel centers.
+        const std::int64_t step_x = (static_cast<std::int64_t>(width) << 16) / dst_width;
+        const std::int64_t step_y = (static_cast<std::int64_t>(height) << 16) / dst_height;
+        const std::int64_t max_x = static_cast<std::int64_t>(width - 1) << 16;
+        const std::int64_t max_y = static_cast<std::int64_t>(height - 1) << 16;
+
+        for (unsigned int dy = 0; dy < dst_height; ++dy)
+        {
+            const std::int64_t fy = std::clamp(step_y * dy + step_y / 2 - (1 << 15), std::int64_t{0}, max_y);
+            const std::size_t y0 = static_cast<std::size_t>(fy >> 16);
+            const std::size_t y1 = std::min<std::size_t>(y0 + 1, height - 1);
+            const std::uint32_t wy = static_cast<std::uint32_t>(fy & 0xffff) >> 8;
+
+            for (unsigned int dx = 0; dx < dst_width; ++dx)
+            {
+                const std::int64_t fx = std::clamp(step_x * dx + step_x / 2 - (1 << 15), std::int64_t{0}, max_x);
+                const std::size_t x0 = static_cast<std::size_t>(fx >> 16);
+                const std::size_t x1 = std::min<std::size_t>(x0 + 1, width - 1);
+                const std::uint32_t wx = static_cast<std::uint32_t>(fx & 0xffff) >> 8;
+
+                // All four channels at once, each in its own 16 bit lane.
+                const std::uint64_t p00 = Spread(src[y0 * width + x0]);
+                const std::uint64_t p01 = Spread(src[y0 * width + x1]);
+                const std::uint64_t p10 = Spread(src[y1 * width + x0]);
+                const std::uint64_t p11 = Spread(src[y1 * width + x1]);
+
+                // 8 bit weights keep every product within its lane.
+                const std::uint64_t top = (p00 * (256 - wx) + p01 * wx) >> 8;
+                const std::uint64_t bottom = (p10 * (256 - wx) + p11 * wx) >> 8;
+                const std::uint64_t out = ((top & LANE_MASK) * (256 - wy) + (bottom & LANE_MASK) * wy + ROUND) >> 8;
+                dst[static_cast<std::size_t>(dy) * dst_width + dx] = Gather(out & LANE_MASK);
+            }
+        }
+    }
+
+    void FlattenArgb(std::uint32_t* pixels, std::size_t count, std::uint32_t background)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t p = pixels[i];
+            const std::uint32_t inverse_alpha = 255 - (p >> 24);
+            std::uint32_t out = 0;
+            for (unsigned int shift = 0; shift < 24; shift += 8)
+            {
+                const std::uint32_t c = Channel(p, shift) + Div255(Channel(background, shift) * inverse_alpha);
+                out |= std::min<std::uint32_t>(c, 255) << shift;
+            }
+            pixels[i] = out;
+        }
+    }
+
+    namespace
+    {
+        // Downscales premultiplied pixels of width x height into a box,
+        // preserving the aspect ratio, centers them and flattens the box onto
+        // the background. If opaque, the alpha channel of src is ignored,
+        // it's only fixed up once scaled down.
+        void FitArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                     std::uint32_t* dst, unsigned int box_width, unsigned int box_height,
+                     std::uint32_t background, bool opaque)
+        {
+            // 1. Fit the image into the box, keeping its aspect ratio.
+            unsigned int fit_width = box_width;
+            unsigned int fit_height = box_height;
+            if (std::uint64_t{width} * box_height > std::uint64_t{height} * box_width)
+            {
+                fit_height = std::max(1u, static_cast<unsigned int>(std::uint64_t{height} * box_width / width));
+            }
+            else if (std::uint64_t{width} * box_height < std::uint64_t{height} * box_width)
+            {
+                fit_width = std::max(1u, static_cast<unsigned int>(std::uint64_t{width} * box_height / height));
+            }
+
+            // 2. Halve while the image is at least twice the target size,
+            // then resample the rest of the way. The first step reads src,
+            // each later one the previous result.
+            const std::uint32_t* current = src;
+            std::vector<std::uint32_t> buffers[2];
+            std::size_t next = 0;
+            while (width / 2 >= fit_width && height / 2 >= fit_height)
+            {
+                buffers[next].resize(static_cast<std::size_t>(width / 2) * (height / 2));
+                HalveArgb(current, width, height, buffers[next].data());
+                current = buffers[next].data();
+                next ^= 1;
+                width /= 2;
+                height /= 2;
+            }
+
+            if (width != fit_width || height != fit_height)
+            {
+                buffers[next].resize(static_cast<std::size_t>(fit_width) * fit_height);
+                ResampleArgb(current, width, height, buffers[next].data(), fit_width, fit_height);
+                current = buffers[next].data();
+            }
+
+            // 3. Center on a transparent box and flatten onto the background.
+            const std::size_t count = static_cast<std::size_t>(box_width) * box_height;
+            std::fill(dst, dst + count, 0u);
+
+            const std::uint32_t alpha = opaque ? 0xff000000u : 0u;
+            const unsigned int offset_x = (box_width - fit_width) / 2;
+            const unsigned int offset_y = (box_height - fit_height) / 2;
+            for (unsigned int y = 0; y < fit_height; ++y)
+            {
+                std::transform(current + static_cast<std::size_t>(y) * fit_width,
+                               current + static_cast<std::size_t>(y + 1) * fit_width,
+                               dst + static_cast<std::size_t>(y + offset_y) * box_width + offset_x,
+                               [alpha](std::uint32_t pixel) { return pixel | alpha; });
+            }
+            FlattenArgb(dst, count, background);
+        }
+    }
+
+    void ScaleIconArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                       std::uint32_t* dst, unsigned int size, std::uint32_t background)
+    {
+        // Premultiply, so filtering doesn't bleed colour out of transparent
+        // pixels.
+        std::vector<std::uint32_t> premultiplied(src, src + static_cast<std::size_t>(width) * height);
+        PremultiplyArgb(premultiplied.data(), premultiplied.size());
+
+        FitArgb(premultiplied.data(), width, height, dst, size, size, background, false);
+    }
+
+    void ScaleThumbnailArgb(const std::uint32_t* src, unsigned int width, unsigned int height,
+                            std::uint32_t* dst, unsigned int box_width, unsigned int box_height,
+                            std::uint32_t background)
+    {
+        // Channels are filtered independently, so the undefined alpha byte
+        // of window contents doesn't leak into the colour. No copy needed.
+        FitArgb(src, width, height, dst, box_width, box_height, background, true);
+    }
+}
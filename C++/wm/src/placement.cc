@@ -0,0 +1,342 @@
+#include "placement.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+
+namespace WM
+{
+    namespace
+    {
+        // Free rectangles tried as positions when nothing fits, the largest
+        // ones first.
+        constexpr std::size_t MAX_OVERLAP_CANDIDATES = 64;
+
+        // Removes the entries at ascending indices.
+        void RemoveIndices(RectArray& rects, const std::uint32_t* indices, std::size_t count)
+        {
+            for (std::size_t i = count; i-- > 0;)
+            {
+                rects.SwapRemove(indices[i]);
+            }
+        }
+
+        // Takes rect out of the free rectangles: every free rectangle it
+        // intersects is replaced by its parts left, right, above and below
+        // rect, each spanning the full other dimension, minus those inside
+        // another free rectangle.
+        void Split(RectArray& free, const Rect<int>& rect)
+        {
+            std::vector<std::uint32_t> indices(free.GetSize());
+            const std::size_t count = FindIntersecting(rect, free, indices.data());
+            if (count == 0)
+            {
+                return;
+            }
+
+            std::vector<Rect<int>> pieces;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const Rect<int> f = free.Get(indices[i]);
+                if (rect.m_x > f.m_x)
+                {
+                    pieces.emplace_back(f.m_x, f.m_y, rect.m_x - f.m_x, f.m_height);
+                }
+                if (rect.GetRight() < f.GetRight())
+                {
+                    pieces.emplace_back(rect.GetRight(), f.m_y, f.GetRight() - rect.GetRight(), f.m_height);
+                }
+                if (rect.m_y > f.m_y)
+                {
+                    pieces.emplace_back(f.m_x, f.m_y, f.m_width, rect.m_y - f.m_y);
+                }
+                if (rect.GetBottom() < f.GetBottom())
+                {
+                    pieces.emplace_back(f.m_x, rect.GetBottom(), f.m_width, f.GetBottom() - rect.GetBottom());
+                }
+            }
+            RemoveIndices(free, indices.data(), count);
+
+            // The untouched free rectangles are still maximal, only the new
+            // pieces can be redundant.
+            const std::size_t num_untouched = free.GetSize();
+            for (std::size_t i = 0; i < pieces.size(); ++i)
+            {
+                const Rect<int>& piece = pieces[i];
+
+                bool redundant = false;
+                for (std::size_t j = 0; j < num_untouched && !redundant; ++j)
+                {
+                    redundant = free.Get(j).Contains(piece);
+                }
+                for (std::size_t j = 0; j < pieces.size() && !redundant; ++j)
+                {
+                    // Of two equal pieces, the first one is kept.
+                    redundant = j != i && pieces[j].Contains(piece) && (pieces[j] != piece || j < i);
+                }
+
+                if (!redundant)
+                {
+                    free.Push(piece);
+                }
+            }
+        }
+
+        Rect<int> Grow(const Rect<int>& rect, int amount)
+        {
+            return Rect<int>(rect.m_x - amount, rect.m_y - amount,
+                             rect.m_width + 2 * amount, rect.m_height + 2 * amount);
+        }
+    }
+
+    void Placement::SetOutputs(const std::vector<Rect<int>>& outputs)
+    {
+        m_outputs = outputs;
+        ++m_generation;
+        m_free.assign(outputs.size(), RectArray{});
+        for (std::size_t i = 0; i < outputs.size(); ++i)
+        {
+            m_free[i].Push(outputs[i]);
+        }
+
+        for (std::size_t i = 0; i < m_rects.GetSize(); ++i)
+        {
+            Occupy(m_rects.Get(i));
+        }
+    }
+
+    void Placement::Add(Window w, const Rect<int>& rect)
+    {
+        if (m_indices.count(w))
+        {
+            Move(w, rect);
+            return;
+        }
+
+        ++m_generation;
+        m_indices[w] = m_windows.size();
+        m_windows.push_back(w);
+        m_rects.Push(rect);
+        Occupy(rect);
+    }
+
+    void Placement::Move(Window w, const Rect<int>& rect)
+    {
+        const auto i = m_indices.find(w);
+        if (i == m_indices.end())
+        {
+            Add(w, rect);
+            return;
+        }
+
+        const Rect<int> old_rect = m_rects.Get(i->second);
+        if (old_rect == rect)
+        {
+            return;
+        }
+
+        ++m_generation;
+
+        // Free the old place with the window out of the way, then take the
+        // new one.
+        m_rects.Set(i->second, Rect<int>());
+        Release(old_rect);
+        m_rects.Set(i->second, rect);
+        Occupy(rect);
+    }
+
+    void Placement::Remove(Window w)
+    {
+        const auto i = m_indices.find(w);
+        if (i == m_indices.end())
+        {
+            return;
+        }
+
+        ++m_generation;
+        const std::size_t index = i->second;
+        const Rect<int> rect = m_rects.Get(index);
+
+        // Move the last window into the hole.
+        const std::size_t last = m_windows.size() - 1;
+        m_indices[m_windows[last]] = index;
+        m_windows[index] = m_windows[last];
+        m_windows.pop_back();
+        m_rects.SwapRemove(index);
+        m_indices.erase(w);
+
+        Release(rect);
+    }
+
+    std::optional<Rect<int>> Placement::GetRect(Window w) const
+    {
+        const auto i = m_indices.find(w);
+        if (i == m_indices.end())
+        {
+            return std::nullopt;
+        }
+        return m_rects.Get(i->second);
+    }
+
+    std::size_t Placement::GetFreeRectCount() const
+    {
+        std::size_t count = 0;
+        for (const RectArray& free : m_free)
+        {
+            count += free.GetSize();
+        }
+        return count;
+    }
+
+    Position<int> Placement::Place(const Size<int>& size, const Position<int>& near) const
+    {
+        if (m_outputs.empty())
+        {
+            return near;
+        }
+
+        std::size_t first_output = 0;
+        for (std::size_t i = 0; i < m_outputs.size(); ++i)
+        {
+            if (m_outputs[i].Contains(near))
+            {
+                first_output = i;
+                break;
+            }
+        }
+
+        // 1. The top-left-most free rectangle the window fits in, on the
+        // first output that has one.
+        for (std::size_t n = 0; n < m_outputs.size(); ++n)
+        {
+            const RectArray& free = m_free[(first_output + n) % m_outputs.size()];
+
+            std::optional<Position<int>> best;
+            for (std::size_t i = 0; i < free.GetSize(); ++i)
+            {
+                if (free.GetWidth()[i] < size.m_width || free.GetHeight()[i] < size.m_height)
+                {
+                    continue;
+                }
+
+                const int x = free.GetX()[i];
+                const int y = free.GetY()[i];
+                if (!best || y < best->m_y || (y == best->m_y && x < best->m_x))
+                {
+                    best = Position<int>(x, y);
+                }
+            }
+
+            if (best)
+            {
+                return *best;
+            }
+        }
+
+        // 2. Nothing fits, overlap as little as possible.
+        return PlaceOverlapping(size, first_output);
+    }
+
+    Position<int> Placement::PlaceOverlapping(const Size<int>& size, std::size_t first_output) const
+    {
+        Position<int> best = m_outputs[first_output].GetPosition();
+        std::int64_t best_overlap = std::numeric_limits<std::int64_t>::max();
+
+        for (std::size_t n = 0; n < m_outputs.size(); ++n)
+        {
+            const std::size_t output_index = (first_output + n) % m_outputs.size();
+            const Rect<int>& output = m_outputs[output_index];
+            const RectArray& free = m_free[output_index];
+
+            // The largest free rectangles make the best anchors.
+            std::vector<std::size_t> order(free.GetSize());
+            for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            const std::size_t num_candidates = std::min(order.size(), MAX_OVERLAP_CANDIDATES);
+            std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(num_candidates), order.end(),
+                              [&free](std::size_t a, std::size_t b) { return free.Get(a).GetArea() > free.Get(b).GetArea(); });
+
+            std::vector<Position<int>> candidates{output.GetPosition()};
+            for (std::size_t i = 0; i < num_candidates; ++i)
+            {
+                const Rect<int> f = free.Get(order[i]);
+                candidates.push_back(f.GetPosition());
+                candidates.emplace_back(f.GetRight() - size.m_width, f.m_y);
+                candidates.emplace_back(f.m_x, f.GetBottom() - size.m_height);
+            }
+
+            for (const Position<int>& candidate : candidates)
+            {
+                const Rect<int> rect = Rect<int>(candidate, size).ClampedTo(output);
+                const std::int64_t overlap = SumIntersectionAreas(Rect<int>(rect.GetPosition(), size), m_rects);
+                if (overlap < best_overlap)
+                {
+                    best_overlap = overlap;
+                    best = rect.GetPosition();
+                }
+            }
+        }
+        return best;
+    }
+
+    void Placement::Occupy(const Rect<int>& rect)
+    {
+        for (RectArray& free : m_free)
+        {
+            Split(free, rect);
+        }
+    }
+
+    void Placement::Release(const Rect<int>& rect)
+    {
+        // Free rectangles sharing an edge or a corner with rect may grow into
+        // it now.
+        const Rect<int> touching = Grow(rect, 1);
+
+        for (std::size_t o = 0; o < m_outputs.size(); ++o)
+        {
+            const Rect<int> area = rect & m_outputs[o];
+            if (area.IsEmpty())
+            {
+                continue;
+            }
+
+            // 1. Drop the free rectangles touching rect. The new ones touching
+            // it lie within their bounding box.
+            RectArray& free = m_free[o];
+            std::vector<std::uint32_t> indices(free.GetSize());
+            const std::size_t count = FindIntersecting(touching, free, indices.data());
+
+            Rect<int> bounds = area;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                bounds |= free.Get(indices[i]);
+            }
+            RemoveIndices(free, indices.data(), count);
+
+            // 2. Recompute the free rectangles of the bounding box.
+            RectArray local;
+            local.Push(bounds);
+
+            std::vector<std::uint32_t> obstacles(m_rects.GetSize());
+            const std::size_t num_obstacles = FindIntersecting(bounds, m_rects, obstacles.data());
+            for (std::size_t i = 0; i < num_obstacles; ++i)
+            {
+                Split(local, m_rects.Get(obstacles[i]));
+            }
+
+            // 3. Those touching rect are maximal on the whole output, the
+            // others are already in the free list or part of one there.
+            for (std::size_t i = 0; i < local.GetSize(); ++i)
+            {
+                const Rect<int> f = local.Get(i);
+                if (f.Intersects(touching))
+                {
+                    free.Push(f);
+                }
+            }
+        }
+    }
+}
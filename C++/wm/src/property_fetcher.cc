@@ -0,0 +1,83 @@
+#include "property_fetcher.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+extern "C"
+{
+    #include <xcb/xcb.h>
+}
+
+
+namespace WM
+{
+    PropertyFetcher::PropertyFetcher(xcb_connection_t* connection)
+        : m_connection{connection},
+          m_owned{false}
+    {
+
+    }
+
+    PropertyFetcher::PropertyFetcher(const std::string& displayName)
+        : m_connection{xcb_connect(displayName.empty() ? nullptr : displayName.c_str(), nullptr)},
+          m_owned{true}
+    {
+        if (xcb_connection_has_error(m_connection))
+        {
+            xcb_disconnect(m_connection);
+            throw std::runtime_error("Property fetcher failed to connect to X display " + displayName);
+        }
+    }
+
+    PropertyFetcher::~PropertyFetcher()
+    {
+        if (m_owned)
+        {
+            xcb_disconnect(m_connection);
+        }
+    }
+
+    std::vector<PropertyReply> PropertyFetcher::Fetch(const std::vector<PropertyRequest>& requests)
+    {
+        // 1. Send every request without waiting.
+        std::vector<xcb_get_property_cookie_t> cookies;
+        cookies.reserve(requests.size());
+        for (const PropertyRequest& request : requests)
+        {
+            cookies.push_back(xcb_get_property(m_connection, false,
+                                               static_cast<xcb_window_t>(request.m_window),
+                                               static_cast<xcb_atom_t>(request.m_property),
+                                               static_cast<xcb_atom_t>(request.m_type),
+                                               0, request.m_maxLength));
+        }
+        xcb_flush(m_connection);
+
+        // 2. Collect the replies, only the first one actually waits.
+        std::vector<PropertyReply> replies(requests.size());
+        for (std::size_t i = 0; i < cookies.size(); ++i)
+        {
+            xcb_generic_error_t* error = nullptr;
+            xcb_get_property_reply_t* reply = xcb_get_property_reply(m_connection, cookies[i], &error);
+
+            // Errors here are expected, the window may already be gone.
+            std::free(error);
+            if (reply == nullptr)
+            {
+                continue;
+            }
+
+            if (reply->type != XCB_ATOM_NONE)
+            {
+                const unsigned char* value = static_cast<const unsigned char*>(xcb_get_property_value(reply));
+                const int length = xcb_get_property_value_length(reply);
+
+                replies[i].m_type = reply->type;
+                replies[i].m_format = reply->format;
+                replies[i].m_numItems = reply->value_len;
+                replies[i].m_data.assign(value, value + length);
+            }
+            std::free(reply);
+        }
+        return replies;
+    }
+}
@@ -0,0 +1,322 @@
+#include "recording_backend.h"
+
+#include <X11/Xproto.h>
+
+
+namespace WM
+{
+    RecordingBackend::RecordingBackend(std::unique_ptr<XBackend> backend, const std::string& path)
+        : m_backend{std::move(backend)},
+          m_writer{path}
+    {
+
+    }
+
+    std::optional<std::string> RecordingBackend::GetDisplayName() const
+    {
+        return m_backend->GetDisplayName();
+    }
+
+    Window RecordingBackend::GetRootWindow() const
+    {
+        return m_backend->GetRootWindow();
+    }
+
+    Atom RecordingBackend::InternAtom(const std::string& name)
+    {
+        m_writer.WriteRequest(X_InternAtom, None);
+        return m_backend->InternAtom(name);
+    }
+
+    void RecordingBackend::RedirectRoot(long event_mask)
+    {
+        m_writer.WriteRequest(X_ChangeWindowAttributes, m_backend->GetRootWindow());
+        m_backend->RedirectRoot(event_mask);
+    }
+
+    void RecordingBackend::SetPhase(const char* name)
+    {
+        m_backend->SetPhase(name);
+    }
+
+    //------------------------------------------------------------------//
+    //                              EVENTS                              //
+    //------------------------------------------------------------------//
+
+    int RecordingBackend::GetConnectionFd() const
+    {
+        return m_backend->GetConnectionFd();
+    }
+
+    bool RecordingBackend::Pending()
+    {
+        const bool pending = m_backend->Pending();
+
+        // The window manager is about to sleep, a good time to write.
+        if (!pending)
+        {
+            m_writer.Flush();
+        }
+        return pending;
+    }
+
+    void RecordingBackend::NextEvent(XEvent& e)
+    {
+        m_backend->NextEvent(e);
+        m_writer.WriteEvent(TraceRecordKind::Event, e);
+    }
+
+    bool RecordingBackend::CheckTypedWindowEvent(Window w, int type, XEvent& e)
+    {
+        if (!m_backend->CheckTypedWindowEvent(w, type, e))
+        {
+            return false;
+        }
+        m_writer.WriteEvent(TraceRecordKind::CheckedEvent, e);
+        return true;
+    }
+
+    void RecordingBackend::Flush()
+    {
+        m_backend->Flush();
+    }
+
+    void RecordingBackend::Sync()
+    {
+        m_writer.WriteRequest(X_GetInputFocus, None);
+        m_backend->Sync();
+    }
+
+    bool RecordingBackend::GrabPointerMotion(Window /*w*/, Time /*time*/)
+    {
+        // Traces hold core events only, XInput2 event data lives outside the
+        // XEvent. Keep drags on core motion so they replay.
+        return false;
+    }
+
+    void RecordingBackend::UngrabPointerMotion(Time /*time*/)
+    {
+
+    }
+
+    bool RecordingBackend::GetPointerEvent(XEvent& /*e*/, PointerEvent& /*pointer*/)
+    {
+        return false;
+    }
+
+    //------------------------------------------------------------------//
+    //                             REQUESTS                             //
+    //------------------------------------------------------------------//
+
+    void RecordingBackend::GrabServer()
+    {
+        m_writer.WriteRequest(X_GrabServer, None);
+        m_backend->GrabServer();
+    }
+
+    void RecordingBackend::UngrabServer()
+    {
+        m_writer.WriteRequest(X_UngrabServer, None);
+        m_backend->UngrabServer();
+    }
+
+    std::vector<Window> RecordingBackend::QueryTree(Window w)
+    {
+        std::vector<Window> children = m_backend->QueryTree(w);
+        m_writer.WriteRequest(X_QueryTree, w, children);
+        return children;
+    }
+
+    bool RecordingBackend::GetWindowAttributes(Window w, XWindowAttributes& attributes)
+    {
+        m_writer.WriteRequest(X_GetWindowAttributes, w);
+        return m_backend->GetWindowAttributes(w, attributes);
+    }
+
+    bool RecordingBackend::GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height)
+    {
+        m_writer.WriteRequest(X_GetGeometry, w);
+        return m_backend->GetGeometry(w, x, y, width, height);
+    }
+
+    Window RecordingBackend::CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                                unsigned int border_width, unsigned long border, unsigned long background)
+    {
+        const Window w = m_backend->CreateSimpleWindow(parent, x, y, width, height, border_width, border, background);
+        m_writer.WriteRequest(X_CreateWindow, parent, {w});
+        return w;
+    }
+
+    void RecordingBackend::DestroyWindow(Window w)
+    {
+        m_writer.WriteRequest(X_DestroyWindow, w);
+        m_backend->DestroyWindow(w);
+    }
+
+    void RecordingBackend::SelectInput(Window w, long event_mask)
+    {
+        m_writer.WriteRequest(X_ChangeWindowAttributes, w);
+        m_backend->SelectInput(w, event_mask);
+    }
+
+    void RecordingBackend::ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes)
+    {
+        m_writer.WriteRequest(X_ChangeWindowAttributes, w);
+        m_backend->ChangeWindowAttributes(w, value_mask, attributes);
+    }
+
+    void RecordingBackend::MapWindow(Window w)
+    {
+        m_writer.WriteRequest(X_MapWindow, w);
+        m_backend->MapWindow(w);
+    }
+
+    void RecordingBackend::UnmapWindow(Window w)
+    {
+        m_writer.WriteRequest(X_UnmapWindow, w);
+        m_backend->UnmapWindow(w);
+    }
+
+    void RecordingBackend::ReparentWindow(Window w, Window parent, int x, int y)
+    {
+        m_writer.WriteRequest(X_ReparentWindow, w);
+        m_backend->ReparentWindow(w, parent, x, y);
+    }
+
+    void RecordingBackend::AddToSaveSet(Window w)
+    {
+        m_writer.WriteRequest(X_ChangeSaveSet, w);
+        m_backend->AddToSaveSet(w);
+    }
+
+    void RecordingBackend::RemoveFromSaveSet(Window w)
+    {
+        m_writer.WriteRequest(X_ChangeSaveSet, w);
+        m_backend->RemoveFromSaveSet(w);
+    }
+
+    void RecordingBackend::ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes)
+    {
+        m_writer.WriteRequest(X_ConfigureWindow, w);
+        m_backend->ConfigureWindow(w, value_mask, changes);
+    }
+
+    void RecordingBackend::MoveWindow(Window w, int x, int y)
+    {
+        m_writer.WriteRequest(X_ConfigureWindow, w);
+        m_backend->MoveWindow(w, x, y);
+    }
+
+    void RecordingBackend::ResizeWindow(Window w, unsigned int width, unsigned int height)
+    {
+        m_writer.WriteRequest(X_ConfigureWindow, w);
+        m_backend->ResizeWindow(w, width, height);
+    }
+
+    void RecordingBackend::RaiseWindow(Window w)
+    {
+        m_writer.WriteRequest(X_ConfigureWindow, w);
+        m_backend->RaiseWindow(w);
+    }
+
+    void RecordingBackend::SetWindowBorderWidth(Window w, unsigned int width)
+    {
+        m_writer.WriteRequest(X_ConfigureWindow, w);
+        m_backend->SetWindowBorderWidth(w, width);
+    }
+
+    void RecordingBackend::SetWindowBorder(Window w, unsigned long pixel)
+    {
+        m_writer.WriteRequest(X_ChangeWindowAttributes, w);
+        m_backend->SetWindowBorder(w, pixel);
+    }
+
+    void RecordingBackend::SetWindowBackground(Window w, unsigned long pixel)
+    {
+        m_writer.WriteRequest(X_ChangeWindowAttributes, w);
+        m_backend->SetWindowBackground(w, pixel);
+    }
+
+    void RecordingBackend::ClearWindow(Window w)
+    {
+        m_writer.WriteRequest(X_ClearArea, w);
+        m_backend->ClearWindow(w);
+    }
+
+    void RecordingBackend::CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                                    unsigned int width, unsigned int height, int dst_x, int dst_y)
+    {
+        m_writer.WriteRequest(X_CopyArea, dst);
+        m_backend->CopyArea(src, dst, src_x, src_y, width, height, dst_x, dst_y);
+    }
+
+    void RecordingBackend::GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask)
+    {
+        m_writer.WriteRequest(X_GrabButton, w);
+        m_backend->GrabButton(button, modifiers, w, event_mask);
+    }
+
+    void RecordingBackend::GrabKey(KeyCode keycode, unsigned int modifiers, Window w)
+    {
+        m_writer.WriteRequest(X_GrabKey, w);
+        m_backend->GrabKey(keycode, modifiers, w);
+    }
+
+    void RecordingBackend::UngrabKey(KeyCode keycode, unsigned int modifiers, Window w)
+    {
+        m_writer.WriteRequest(X_UngrabKey, w);
+        m_backend->UngrabKey(keycode, modifiers, w);
+    }
+
+    bool RecordingBackend::GrabKeyboard(Window w, Time time)
+    {
+        m_writer.WriteRequest(X_GrabKeyboard, w);
+        return m_backend->GrabKeyboard(w, time);
+    }
+
+    void RecordingBackend::UngrabKeyboard(Time time)
+    {
+        m_writer.WriteRequest(X_UngrabKeyboard, None);
+        m_backend->UngrabKeyboard(time);
+    }
+
+    KeyCode RecordingBackend::KeysymToKeycode(KeySym keysym)
+    {
+        // Answered from Xlib's copy of the keyboard mapping, not a request.
+        return m_backend->KeysymToKeycode(keysym);
+    }
+
+    void RecordingBackend::SetInputFocus(Window w)
+    {
+        m_writer.WriteRequest(X_SetInputFocus, w);
+        m_backend->SetInputFocus(w);
+    }
+
+    void RecordingBackend::KillClient(Window w)
+    {
+        m_writer.WriteRequest(X_KillClient, w);
+        m_backend->KillClient(w);
+    }
+
+    bool RecordingBackend::SendEvent(Window w, long event_mask, XEvent& e)
+    {
+        m_writer.WriteRequest(X_SendEvent, w);
+        return m_backend->SendEvent(w, event_mask, e);
+    }
+
+    std::vector<PropertyReply> RecordingBackend::GetProperties(const std::vector<PropertyRequest>& requests)
+    {
+        for (const PropertyRequest& request : requests)
+        {
+            m_writer.WriteRequest(X_GetProperty, request.m_window);
+        }
+        return m_backend->GetProperties(requests);
+    }
+
+    void RecordingBackend::ChangeProperty(Window w, Atom property, Atom type, int format,
+                                          const unsigned char* data, int num_items)
+    {
+        m_writer.WriteRequest(X_ChangeProperty, w);
+        m_backend->ChangeProperty(w, property, type, format, data, num_items);
+    }
+}
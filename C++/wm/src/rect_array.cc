@@ -0,0 +1,438 @@
+#include "util.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define WM_RECT_X86 1
+    #include <immintrin.h>
+#endif
+
+
+void RectArray::Reserve(std::size_t size)
+{
+    m_x.reserve(size);
+    m_y.reserve(size);
+    m_width.reserve(size);
+    m_height.reserve(size);
+}
+
+void RectArray::Clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_width.clear();
+    m_height.clear();
+}
+
+void RectArray::Resize(std::size_t size)
+{
+    m_x.resize(size);
+    m_y.resize(size);
+    m_width.resize(size);
+    m_height.resize(size);
+}
+
+void RectArray::Push(const Rect<int>& r)
+{
+    m_x.push_back(r.m_x);
+    m_y.push_back(r.m_y);
+    m_width.push_back(r.m_width);
+    m_height.push_back(r.m_height);
+}
+
+void RectArray::Set(std::size_t i, const Rect<int>& r)
+{
+    m_x[i] = r.m_x;
+    m_y[i] = r.m_y;
+    m_width[i] = r.m_width;
+    m_height[i] = r.m_height;
+}
+
+Rect<int> RectArray::Get(std::size_t i) const
+{
+    return Rect<int>(m_x[i], m_y[i], m_width[i], m_height[i]);
+}
+
+void RectArray::SwapRemove(std::size_t i)
+{
+    const std::size_t last = GetSize() - 1;
+    Set(i, Get(last));
+    Resize(last);
+}
+
+namespace
+{
+    // Every kernel works on the range [begin, end) of the arrays, so the
+    // wide versions can hand their tail to a narrower one.
+    using IntersectFn = void (*)(const Rect<int>& r, const RectArray& rects, RectArray& out,
+                                 std::size_t begin, std::size_t end);
+    using ClampFn = void (*)(const Rect<int>& bounds, RectArray& rects, std::size_t begin, std::size_t end);
+    using FindFn = std::size_t (*)(const Rect<int>& r, const RectArray& rects, std::uint32_t* indices,
+                                   std::size_t begin, std::size_t end);
+    using SumAreasFn = std::int64_t (*)(const Rect<int>& r, const RectArray& rects,
+                                        std::size_t begin, std::size_t end);
+
+    struct Kernels
+    {
+        IntersectFn m_intersect;
+        ClampFn m_clamp;
+        FindFn m_find;
+        SumAreasFn m_sumAreas;
+    };
+
+    //------------------------------------------------------------------//
+    //                              SCALAR                              //
+    //------------------------------------------------------------------//
+
+    // Intersection of r with rectangle i, width and height <= 0 if empty.
+    inline Rect<int> IntersectOne(const Rect<int>& r, const RectArray& rects, std::size_t i)
+    {
+        const int x0 = std::max(r.m_x, rects.GetX()[i]);
+        const int y0 = std::max(r.m_y, rects.GetY()[i]);
+        const int x1 = std::min(r.GetRight(), rects.GetX()[i] + rects.GetWidth()[i]);
+        const int y1 = std::min(r.GetBottom(), rects.GetY()[i] + rects.GetHeight()[i]);
+        return Rect<int>(x0, y0, x1 - x0, y1 - y0);
+    }
+
+    void IntersectScalar(const Rect<int>& r, const RectArray& rects, RectArray& out,
+                         std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const Rect<int> intersection = IntersectOne(r, rects, i);
+            out.Set(i, intersection.IsEmpty() ? Rect<int>() : intersection);
+        }
+    }
+
+    void ClampScalar(const Rect<int>& bounds, RectArray& rects, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            rects.Set(i, rects.Get(i).ClampedTo(bounds));
+        }
+    }
+
+    std::size_t FindScalar(const Rect<int>& r, const RectArray& rects, std::uint32_t* indices,
+                           std::size_t begin, std::size_t end)
+    {
+        std::size_t count = 0;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            if (!IntersectOne(r, rects, i).IsEmpty())
+            {
+                indices[count++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        return count;
+    }
+
+    std::int64_t SumAreasScalar(const Rect<int>& r, const RectArray& rects, std::size_t begin, std::size_t end)
+    {
+        std::int64_t sum = 0;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const Rect<int> intersection = IntersectOne(r, rects, i);
+            if (!intersection.IsEmpty())
+            {
+                sum += static_cast<std::int64_t>(intersection.m_width) * intersection.m_height;
+            }
+        }
+        return sum;
+    }
+
+#ifdef WM_RECT_X86
+    //------------------------------------------------------------------//
+    //                              SSE4.1                              //
+    //------------------------------------------------------------------//
+
+    // Intersection of r (broadcast) with 4 rectangles. Width and height are
+    // <= 0 where there is none.
+    struct Intersection4
+    {
+        __m128i m_x;
+        __m128i m_y;
+        __m128i m_width;
+        __m128i m_height;
+    };
+
+    __attribute__((target("sse4.1")))
+    inline Intersection4 Intersect4(const Rect<int>& r, const RectArray& rects, std::size_t i)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rects.GetX() + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rects.GetY() + i));
+        const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rects.GetWidth() + i));
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rects.GetHeight() + i));
+
+        const __m128i x0 = _mm_max_epi32(x, _mm_set1_epi32(r.m_x));
+        const __m128i y0 = _mm_max_epi32(y, _mm_set1_epi32(r.m_y));
+        const __m128i x1 = _mm_min_epi32(_mm_add_epi32(x, w), _mm_set1_epi32(r.GetRight()));
+        const __m128i y1 = _mm_min_epi32(_mm_add_epi32(y, h), _mm_set1_epi32(r.GetBottom()));
+        return Intersection4{x0, y0, _mm_sub_epi32(x1, x0), _mm_sub_epi32(y1, y0)};
+    }
+
+    // All ones in the lanes with a non empty intersection.
+    __attribute__((target("sse4.1")))
+    inline __m128i NonEmpty4(const Intersection4& r)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_and_si128(_mm_cmpgt_epi32(r.m_width, zero), _mm_cmpgt_epi32(r.m_height, zero));
+    }
+
+    __attribute__((target("sse4.1")))
+    void IntersectSse41(const Rect<int>& r, const RectArray& rects, RectArray& out,
+                        std::size_t begin, std::size_t end)
+    {
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const Intersection4 intersection = Intersect4(r, rects, i);
+            const __m128i mask = NonEmpty4(intersection);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.GetX() + i), _mm_and_si128(mask, intersection.m_x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.GetY() + i), _mm_and_si128(mask, intersection.m_y));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.GetWidth() + i), _mm_and_si128(mask, intersection.m_width));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.GetHeight() + i), _mm_and_si128(mask, intersection.m_height));
+        }
+        IntersectScalar(r, rects, out, i, end);
+    }
+
+    __attribute__((target("sse4.1")))
+    void ClampSse41(const Rect<int>& bounds, RectArray& rects, std::size_t begin, std::size_t end)
+    {
+        const __m128i left = _mm_set1_epi32(bounds.m_x);
+        const __m128i top = _mm_set1_epi32(bounds.m_y);
+        const __m128i right = _mm_set1_epi32(bounds.GetRight());
+        const __m128i bottom = _mm_set1_epi32(bounds.GetBottom());
+        const __m128i max_width = _mm_set1_epi32(bounds.m_width);
+        const __m128i max_height = _mm_set1_epi32(bounds.m_height);
+
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128i* px = reinterpret_cast<__m128i*>(rects.GetX() + i);
+            __m128i* py = reinterpret_cast<__m128i*>(rects.GetY() + i);
+            __m128i* pw = reinterpret_cast<__m128i*>(rects.GetWidth() + i);
+            __m128i* ph = reinterpret_cast<__m128i*>(rects.GetHeight() + i);
+
+            const __m128i w = _mm_min_epi32(_mm_loadu_si128(pw), max_width);
+            const __m128i h = _mm_min_epi32(_mm_loadu_si128(ph), max_height);
+            const __m128i x = _mm_min_epi32(_mm_max_epi32(_mm_loadu_si128(px), left), _mm_sub_epi32(right, w));
+            const __m128i y = _mm_min_epi32(_mm_max_epi32(_mm_loadu_si128(py), top), _mm_sub_epi32(bottom, h));
+
+            _mm_storeu_si128(px, x);
+            _mm_storeu_si128(py, y);
+            _mm_storeu_si128(pw, w);
+            _mm_storeu_si128(ph, h);
+        }
+        ClampScalar(bounds, rects, i, end);
+    }
+
+    __attribute__((target("sse4.1")))
+    std::size_t FindSse41(const Rect<int>& r, const RectArray& rects, std::uint32_t* indices,
+                          std::size_t begin, std::size_t end)
+    {
+        std::size_t count = 0;
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            unsigned int mask = static_cast<unsigned int>(
+                _mm_movemask_ps(_mm_castsi128_ps(NonEmpty4(Intersect4(r, rects, i)))));
+            while (mask != 0)
+            {
+                indices[count++] = static_cast<std::uint32_t>(i) + static_cast<std::uint32_t>(__builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+        return count + FindScalar(r, rects, indices + count, i, end);
+    }
+
+    __attribute__((target("sse4.1")))
+    std::int64_t SumAreasSse41(const Rect<int>& r, const RectArray& rects, std::size_t begin, std::size_t end)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum = zero;
+
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const Intersection4 intersection = Intersect4(r, rects, i);
+            // Both sides are at most 65535, so the area fits 32 unsigned bits.
+            const __m128i w = _mm_max_epi32(intersection.m_width, zero);
+            const __m128i h = _mm_max_epi32(intersection.m_height, zero);
+            const __m128i area = _mm_mullo_epi32(w, h);
+
+            sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(area));
+            sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(_mm_srli_si128(area, 8)));
+        }
+
+        alignas(16) std::int64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        return lanes[0] + lanes[1] + SumAreasScalar(r, rects, i, end);
+    }
+
+    //------------------------------------------------------------------//
+    //                               AVX2                               //
+    //------------------------------------------------------------------//
+
+    struct Intersection8
+    {
+        __m256i m_x;
+        __m256i m_y;
+        __m256i m_width;
+        __m256i m_height;
+    };
+
+    __attribute__((target("avx2")))
+    inline Intersection8 Intersect8(const Rect<int>& r, const RectArray& rects, std::size_t i)
+    {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rects.GetX() + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rects.GetY() + i));
+        const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rects.GetWidth() + i));
+        const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rects.GetHeight() + i));
+
+        const __m256i x0 = _mm256_max_epi32(x, _mm256_set1_epi32(r.m_x));
+        const __m256i y0 = _mm256_max_epi32(y, _mm256_set1_epi32(r.m_y));
+        const __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x, w), _mm256_set1_epi32(r.GetRight()));
+        const __m256i y1 = _mm256_min_epi32(_mm256_add_epi32(y, h), _mm256_set1_epi32(r.GetBottom()));
+        return Intersection8{x0, y0, _mm256_sub_epi32(x1, x0), _mm256_sub_epi32(y1, y0)};
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i NonEmpty8(const Intersection8& r)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        return _mm256_and_si256(_mm256_cmpgt_epi32(r.m_width, zero), _mm256_cmpgt_epi32(r.m_height, zero));
+    }
+
+    __attribute__((target("avx2")))
+    void IntersectAvx2(const Rect<int>& r, const RectArray& rects, RectArray& out,
+                       std::size_t begin, std::size_t end)
+    {
+        std::size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            const Intersection8 intersection = Intersect8(r, rects, i);
+            const __m256i mask = NonEmpty8(intersection);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.GetX() + i), _mm256_and_si256(mask, intersection.m_x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.GetY() + i), _mm256_and_si256(mask, intersection.m_y));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.GetWidth() + i), _mm256_and_si256(mask, intersection.m_width));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.GetHeight() + i), _mm256_and_si256(mask, intersection.m_height));
+        }
+        IntersectSse41(r, rects, out, i, end);
+    }
+
+    __attribute__((target("avx2")))
+    void ClampAvx2(const Rect<int>& bounds, RectArray& rects, std::size_t begin, std::size_t end)
+    {
+        const __m256i left = _mm256_set1_epi32(bounds.m_x);
+        const __m256i top = _mm256_set1_epi32(bounds.m_y);
+        const __m256i right = _mm256_set1_epi32(bounds.GetRight());
+        const __m256i bottom = _mm256_set1_epi32(bounds.GetBottom());
+        const __m256i max_width = _mm256_set1_epi32(bounds.m_width);
+        const __m256i max_height = _mm256_set1_epi32(bounds.m_height);
+
+        std::size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256i* px = reinterpret_cast<__m256i*>(rects.GetX() + i);
+            __m256i* py = reinterpret_cast<__m256i*>(rects.GetY() + i);
+            __m256i* pw = reinterpret_cast<__m256i*>(rects.GetWidth() + i);
+            __m256i* ph = reinterpret_cast<__m256i*>(rects.GetHeight() + i);
+
+            const __m256i w = _mm256_min_epi32(_mm256_loadu_si256(pw), max_width);
+            const __m256i h = _mm256_min_epi32(_mm256_loadu_si256(ph), max_height);
+            const __m256i x = _mm256_min_epi32(_mm256_max_epi32(_mm256_loadu_si256(px), left), _mm256_sub_epi32(right, w));
+            const __m256i y = _mm256_min_epi32(_mm256_max_epi32(_mm256_loadu_si256(py), top), _mm256_sub_epi32(bottom, h));
+
+            _mm256_storeu_si256(px, x);
+            _mm256_storeu_si256(py, y);
+            _mm256_storeu_si256(pw, w);
+            _mm256_storeu_si256(ph, h);
+        }
+        ClampSse41(bounds, rects, i, end);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t FindAvx2(const Rect<int>& r, const RectArray& rects, std::uint32_t* indices,
+                         std::size_t begin, std::size_t end)
+    {
+        std::size_t count = 0;
+        std::size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            unsigned int mask = static_cast<unsigned int>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(NonEmpty8(Intersect8(r, rects, i)))));
+            while (mask != 0)
+            {
+                indices[count++] = static_cast<std::uint32_t>(i) + static_cast<std::uint32_t>(__builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+        return count + FindSse41(r, rects, indices + count, i, end);
+    }
+
+    __attribute__((target("avx2")))
+    std::int64_t SumAreasAvx2(const Rect<int>& r, const RectArray& rects, std::size_t begin, std::size_t end)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i sum = zero;
+
+        std::size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            const Intersection8 intersection = Intersect8(r, rects, i);
+            const __m256i w = _mm256_max_epi32(intersection.m_width, zero);
+            const __m256i h = _mm256_max_epi32(intersection.m_height, zero);
+            const __m256i area = _mm256_mullo_epi32(w, h);
+
+            sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(area)));
+            sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(area, 1)));
+        }
+
+        alignas(32) std::int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumAreasSse41(r, rects, i, end);
+    }
+#endif
+
+    Kernels SelectKernels()
+    {
+#ifdef WM_RECT_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return Kernels{&IntersectAvx2, &ClampAvx2, &FindAvx2, &SumAreasAvx2};
+        }
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            return Kernels{&IntersectSse41, &ClampSse41, &FindSse41, &SumAreasSse41};
+        }
+#endif
+        return Kernels{&IntersectScalar, &ClampScalar, &FindScalar, &SumAreasScalar};
+    }
+
+    const Kernels& GetKernels()
+    {
+        static const Kernels kernels{SelectKernels()};
+        return kernels;
+    }
+}
+
+void IntersectRects(const Rect<int>& r, const RectArray& rects, RectArray& out)
+{
+    out.Resize(rects.GetSize());
+    GetKernels().m_intersect(r, rects, out, 0, rects.GetSize());
+}
+
+void ClampRects(const Rect<int>& bounds, RectArray& rects)
+{
+    GetKernels().m_clamp(bounds, rects, 0, rects.GetSize());
+}
+
+std::size_t FindIntersecting(const Rect<int>& r, const RectArray& rects, std::uint32_t* indices)
+{
+    return GetKernels().m_find(r, rects, indices, 0, rects.GetSize());
+}
+
+std::int64_t SumIntersectionAreas(const Rect<int>& r, const RectArray& rects)
+{
+    return GetKernels().m_sumAreas(r, rects, 0, rects.GetSize());
+}
@@ -0,0 +1,191 @@
+#include "resource_sampler.h"
+#include "xcb_request.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+extern "C"
+{
+    #include <xcb/xcb.h>
+    #include <xcb/xcbext.h>
+    #include <X11/Xproto.h>
+    #include <X11/extensions/XResproto.h>
+}
+
+
+namespace WM
+{
+    namespace
+    {
+        // There is no xcb-res here, the two requests used are sent raw.
+        xcb_extension_t XRES_EXTENSION{XRES_NAME, 0};
+
+        // Sends XResQueryClientResources or XResQueryClientPixmapBytes for
+        // the client owning xid. Both are the same 8 bytes.
+        unsigned int SendQuery(xcb_connection_t* connection, std::uint8_t minor_opcode, Window xid)
+        {
+            struct
+            {
+                std::uint32_t m_header;
+                std::uint32_t m_xid;
+            } request{0, static_cast<std::uint32_t>(xid)};
+            return Xcb::SendRequest(connection, &XRES_EXTENSION, minor_opcode, &request, sizeof(request), true);
+        }
+    }
+
+    //------------------------------------------------------------------//
+    //                         RESOURCE HISTORY                         //
+    //------------------------------------------------------------------//
+
+    void ResourceHistory::Push(const ResourceSample& sample)
+    {
+        m_samples[m_next] = sample;
+        m_next = (m_next + 1) % m_samples.size();
+        if (m_size < m_samples.size())
+        {
+            ++m_size;
+        }
+    }
+
+    const ResourceSample& ResourceHistory::GetLatest() const
+    {
+        return m_samples[(m_next + m_samples.size() - 1) % m_samples.size()];
+    }
+
+    const ResourceSample& ResourceHistory::GetOldest() const
+    {
+        return m_samples[(m_next + m_samples.size() - m_size) % m_samples.size()];
+    }
+
+    std::int64_t ResourceHistory::GetPixmapGrowth() const
+    {
+        if (IsEmpty())
+        {
+            return 0;
+        }
+        return static_cast<std::int64_t>(GetLatest().m_pixmapBytes) - static_cast<std::int64_t>(GetOldest().m_pixmapBytes);
+    }
+
+    //------------------------------------------------------------------//
+    //                         RESOURCE SAMPLER                         //
+    //------------------------------------------------------------------//
+
+    ResourceSampler::ResourceSampler(const std::string& displayName, Clock::duration interval)
+        : m_connection{xcb_connect(displayName.empty() ? nullptr : displayName.c_str(), nullptr)},
+          m_interval{interval}
+    {
+        if (xcb_connection_has_error(m_connection))
+        {
+            xcb_disconnect(m_connection);
+            throw std::runtime_error("Resource sampler failed to connect to X display " + displayName);
+        }
+
+        // The only round trips, at startup: whether there is X-Resource, and
+        // which resource type pixmaps are.
+        const xcb_intern_atom_cookie_t pixmap_cookie = xcb_intern_atom(m_connection, true, 6, "PIXMAP");
+        const xcb_query_extension_reply_t* extension = xcb_get_extension_data(m_connection, &XRES_EXTENSION);
+        m_available = extension != nullptr && extension->present;
+
+        if (xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(m_connection, pixmap_cookie, nullptr))
+        {
+            m_pixmapType = reply->atom;
+            std::free(reply);
+        }
+    }
+
+    ResourceSampler::~ResourceSampler()
+    {
+        xcb_disconnect(m_connection);
+    }
+
+    int ResourceSampler::GetFd() const
+    {
+        return m_available ? xcb_get_file_descriptor(m_connection) : -1;
+    }
+
+    void ResourceSampler::Request(const std::vector<Window>& windows, Clock::time_point now)
+    {
+        if (!m_available || !m_pending.empty() || now - m_lastRequest < m_interval)
+        {
+            return;
+        }
+        m_lastRequest = now;
+
+        for (const Window w : windows)
+        {
+            m_pending.push_back({w,
+                                 SendQuery(m_connection, X_XResQueryClientResources, w),
+                                 SendQuery(m_connection, X_XResQueryClientPixmapBytes, w)});
+        }
+        xcb_flush(m_connection);
+    }
+
+    std::vector<std::pair<Window, ResourceSample>> ResourceSampler::Collect()
+    {
+        std::vector<std::pair<Window, ResourceSample>> samples;
+        const Clock::time_point now = Clock::now();
+
+        for (Pending& pending : m_pending)
+        {
+            unsigned char* reply = nullptr;
+
+            // 1. Resource counts: num_types, then (type, count) pairs after
+            // the 32 byte header.
+            if (!pending.m_resourcesDone && Xcb::PollReply(m_connection, pending.m_resourcesRequest, reply))
+            {
+                pending.m_resourcesDone = true;
+                if (reply != nullptr)
+                {
+                    ResourceSample& sample = pending.m_sample ? *pending.m_sample : pending.m_sample.emplace();
+                    const std::uint32_t length = Xcb::ReadCard32(reply, 4);
+                    const std::uint32_t num_types = std::min(Xcb::ReadCard32(reply, 8), length / 2);
+                    for (std::uint32_t i = 0; i < num_types; ++i)
+                    {
+                        const std::uint32_t type = Xcb::ReadCard32(reply, 32 + 8 * i);
+                        const std::uint32_t count = Xcb::ReadCard32(reply, 32 + 8 * i + 4);
+                        sample.m_resourceCount += count;
+                        if (type == m_pixmapType)
+                        {
+                            sample.m_pixmapCount = count;
+                        }
+                    }
+                    std::free(reply);
+                    reply = nullptr;
+                }
+            }
+
+            // 2. Pixmap bytes, with the high word in bytes_overflow.
+            if (!pending.m_pixmapBytesDone && Xcb::PollReply(m_connection, pending.m_pixmapBytesRequest, reply))
+            {
+                pending.m_pixmapBytesDone = true;
+                if (reply != nullptr)
+                {
+                    ResourceSample& sample = pending.m_sample ? *pending.m_sample : pending.m_sample.emplace();
+                    sample.m_pixmapBytes = Xcb::ReadCard32(reply, 8) | static_cast<std::uint64_t>(Xcb::ReadCard32(reply, 12)) << 32;
+                    std::free(reply);
+                }
+            }
+
+            if (pending.m_resourcesDone && pending.m_pixmapBytesDone && pending.m_sample)
+            {
+                pending.m_sample->m_time = now;
+                samples.emplace_back(pending.m_window, *pending.m_sample);
+            }
+        }
+
+        std::erase_if(m_pending, [](const Pending& pending)
+        {
+            return pending.m_resourcesDone && pending.m_pixmapBytesDone;
+        });
+        return samples;
+    }
+
+    std::optional<ResourceSampler::Clock::duration> ResourceSampler::GetTimeout(Clock::time_point now) const
+    {
+        if (!m_available || !m_pending.empty())
+        {
+            return std::nullopt;
+        }
+        return std::max(Clock::duration::zero(), m_lastRequest + m_interval - now);
+    }
+}
@@ -0,0 +1,403 @@
+#include "rules.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+
+namespace WM
+{
+    namespace
+    {
+        constexpr std::uint32_t NO_STATE = UINT32_MAX;
+
+        // Splits a line into whitespace separated tokens. Double quotes group
+        // whitespace into a token and are dropped.
+        std::vector<std::string> Tokenize(std::string_view line)
+        {
+            std::vector<std::string> tokens;
+            std::string token;
+            bool quoted = false;
+            bool in_token = false;
+
+            for (const char c : line)
+            {
+                if (c == '"')
+                {
+                    quoted = !quoted;
+                    in_token = true;
+                }
+                else if (!quoted && (c == ' ' || c == '\t'))
+                {
+                    if (in_token)
+                    {
+                        tokens.push_back(std::move(token));
+                        token.clear();
+                        in_token = false;
+                    }
+                }
+                else
+                {
+                    token.push_back(c);
+                    in_token = true;
+                }
+            }
+
+            if (quoted)
+            {
+                throw std::runtime_error("unterminated quote");
+            }
+            if (in_token)
+            {
+                tokens.push_back(std::move(token));
+            }
+            return tokens;
+        }
+
+        // Returns the longest run of a glob pattern without wildcards.
+        std::string_view LongestLiteral(std::string_view pattern)
+        {
+            std::string_view best;
+            std::size_t start = 0;
+            for (std::size_t i = 0; i <= pattern.size(); ++i)
+            {
+                if (i == pattern.size() || pattern[i] == '*' || pattern[i] == '?')
+                {
+                    if (i - start > best.size())
+                    {
+                        best = pattern.substr(start, i - start);
+                    }
+                    start = i + 1;
+                }
+            }
+            return best;
+        }
+
+        bool Matches(const Rule& rule, const WindowIdentity& window)
+        {
+            return (!rule.m_class || *rule.m_class == window.m_class)
+                && (!rule.m_instance || *rule.m_instance == window.m_instance)
+                && (!rule.m_title || GlobMatch(*rule.m_title, window.m_title));
+        }
+    }
+
+    void RuleActions::Merge(const RuleActions& other)
+    {
+        if (other.m_workspace)
+        {
+            m_workspace = other.m_workspace;
+        }
+        m_floating = m_floating || other.m_floating;
+        m_above = m_above || other.m_above;
+    }
+
+    bool GlobMatch(std::string_view pattern, std::string_view text)
+    {
+        // Greedy matching, backtracking only to the last '*'.
+        std::size_t p = 0;
+        std::size_t t = 0;
+        std::size_t star = std::string_view::npos;
+        std::size_t star_text = 0;
+
+        while (t < text.size())
+        {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+            {
+                ++p;
+                ++t;
+            }
+            else if (p < pattern.size() && pattern[p] == '*')
+            {
+                star = p++;
+                star_text = t;
+            }
+            else if (star != std::string_view::npos)
+            {
+                p = star + 1;
+                t = ++star_text;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while (p < pattern.size() && pattern[p] == '*')
+        {
+            ++p;
+        }
+        return p == pattern.size();
+    }
+
+    //------------------------------------------------------------------//
+    //                            AUTOMATON                             //
+    //------------------------------------------------------------------//
+
+    void RuleSet::Automaton::Add(std::string_view pattern, std::uint32_t id)
+    {
+        m_patterns.emplace_back(std::string{pattern}, id);
+    }
+
+    void RuleSet::Automaton::Compile()
+    {
+        // 1. Only bytes used by some pattern get their own class.
+        m_classOf.fill(0);
+        m_numClasses = 1;
+        for (const auto& [pattern, id] : m_patterns)
+        {
+            for (const char c : pattern)
+            {
+                std::uint8_t& cls = m_classOf[static_cast<unsigned char>(c)];
+                if (cls == 0)
+                {
+                    cls = static_cast<std::uint8_t>(m_numClasses++);
+                }
+            }
+        }
+
+        // 2. Build the trie.
+        m_next.assign(m_numClasses, NO_STATE);
+        std::vector<std::vector<std::uint32_t>> outputs(1);
+
+        for (const auto& [pattern, id] : m_patterns)
+        {
+            std::uint32_t state = 0;
+            for (const char c : pattern)
+            {
+                std::uint32_t& next = m_next[state * m_numClasses + m_classOf[static_cast<unsigned char>(c)]];
+                if (next == NO_STATE)
+                {
+                    next = static_cast<std::uint32_t>(outputs.size());
+                    outputs.emplace_back();
+                    m_next.resize(m_next.size() + m_numClasses, NO_STATE);
+                }
+                // m_next may have been reallocated, index again.
+                state = m_next[state * m_numClasses + m_classOf[static_cast<unsigned char>(c)]];
+            }
+            outputs[state].push_back(id);
+        }
+
+        // 3. Breadth first, fill in failure transitions so that every state
+        // has a transition for every class.
+        const std::size_t num_states = outputs.size();
+        std::vector<std::uint32_t> fail(num_states, 0);
+        std::vector<std::uint32_t> queue;
+        queue.reserve(num_states);
+
+        for (std::size_t c = 0; c < m_numClasses; ++c)
+        {
+            std::uint32_t& next = m_next[c];
+            if (next == NO_STATE)
+            {
+                next = 0;
+            }
+            else
+            {
+                queue.push_back(next);
+            }
+        }
+
+        for (std::size_t head = 0; head < queue.size(); ++head)
+        {
+            const std::uint32_t state = queue[head];
+            const std::uint32_t fallback = fail[state];
+
+            // Patterns ending in the failure state also end here.
+            outputs[state].insert(outputs[state].end(), outputs[fallback].begin(), outputs[fallback].end());
+
+            for (std::size_t c = 0; c < m_numClasses; ++c)
+            {
+                std::uint32_t& next = m_next[state * m_numClasses + c];
+                if (next == NO_STATE)
+                {
+                    next = m_next[fallback * m_numClasses + c];
+                }
+                else
+                {
+                    fail[next] = m_next[fallback * m_numClasses + c];
+                    queue.push_back(next);
+                }
+            }
+        }
+
+        // 4. Flatten the outputs.
+        m_outputStart.assign(num_states + 1, 0);
+        m_outputs.clear();
+        for (std::size_t state = 0; state < num_states; ++state)
+        {
+            m_outputStart[state] = static_cast<std::uint32_t>(m_outputs.size());
+            m_outputs.insert(m_outputs.end(), outputs[state].begin(), outputs[state].end());
+        }
+        m_outputStart[num_states] = static_cast<std::uint32_t>(m_outputs.size());
+    }
+
+    void RuleSet::Automaton::FindAll(std::string_view text, std::vector<std::uint32_t>& out) const
+    {
+        if (m_patterns.empty())
+        {
+            return;
+        }
+
+        std::uint32_t state = 0;
+        for (const char c : text)
+        {
+            state = m_next[state * m_numClasses + m_classOf[static_cast<unsigned char>(c)]];
+            out.insert(out.end(), m_outputs.begin() + m_outputStart[state], m_outputs.begin() + m_outputStart[state + 1]);
+        }
+    }
+
+    //------------------------------------------------------------------//
+    //                             RULE SET                             //
+    //------------------------------------------------------------------//
+
+    RuleSet::RuleSet(std::vector<Rule> rules)
+        : m_rules{std::move(rules)}
+    {
+        for (std::uint32_t id = 0; id < m_rules.size(); ++id)
+        {
+            const Rule& rule = m_rules[id];
+            if (rule.m_class)
+            {
+                m_byClass[*rule.m_class].push_back(id);
+            }
+            else if (rule.m_instance)
+            {
+                m_byInstance[*rule.m_instance].push_back(id);
+            }
+            else if (rule.m_title && !LongestLiteral(*rule.m_title).empty())
+            {
+                m_titles.Add(LongestLiteral(*rule.m_title), id);
+            }
+            else
+            {
+                m_always.push_back(id);
+            }
+        }
+        m_titles.Compile();
+    }
+
+    RuleSet RuleSet::Parse(std::string_view text)
+    {
+        std::vector<Rule> rules;
+        std::size_t line_number = 0;
+
+        while (!text.empty())
+        {
+            // 1. Cut the next line, drop comments.
+            const std::size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            ++line_number;
+
+            if (const std::size_t comment = line.find('#'); comment != std::string_view::npos)
+            {
+                line = line.substr(0, comment);
+            }
+
+            try
+            {
+                const std::vector<std::string> tokens = Tokenize(line);
+                if (tokens.empty())
+                {
+                    continue;
+                }
+
+                // 2. Conditions up to "->", actions after it.
+                Rule rule;
+                bool actions = false;
+                for (const std::string& token : tokens)
+                {
+                    if (token == "->")
+                    {
+                        if (actions)
+                        {
+                            throw std::runtime_error("more than one '->'");
+                        }
+                        actions = true;
+                        continue;
+                    }
+
+                    const std::size_t equals = token.find('=');
+                    const std::string key = token.substr(0, equals);
+                    const std::string value = equals == std::string::npos ? std::string{} : token.substr(equals + 1);
+
+                    if (!actions && key == "class")
+                    {
+                        rule.m_class = value;
+                    }
+                    else if (!actions && key == "instance")
+                    {
+                        rule.m_instance = value;
+                    }
+                    else if (!actions && key == "title")
+                    {
+                        rule.m_title = value;
+                    }
+                    else if (actions && key == "workspace")
+                    {
+                        int workspace = 0;
+                        const auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), workspace);
+                        if (error != std::errc{} || ptr != value.data() + value.size() || workspace < 0)
+                        {
+                            throw std::runtime_error("invalid workspace '" + value + "'");
+                        }
+                        rule.m_actions.m_workspace = workspace;
+                    }
+                    else if (actions && token == "floating")
+                    {
+                        rule.m_actions.m_floating = true;
+                    }
+                    else if (actions && token == "above")
+                    {
+                        rule.m_actions.m_above = true;
+                    }
+                    else
+                    {
+                        throw std::runtime_error("unknown " + std::string{actions ? "action" : "condition"} + " '" + token + "'");
+                    }
+                }
+
+                if (!actions)
+                {
+                    throw std::runtime_error("missing '->'");
+                }
+                rules.push_back(std::move(rule));
+            }
+            catch (const std::runtime_error& e)
+            {
+                throw std::runtime_error("rules:" + std::to_string(line_number) + ": " + e.what());
+            }
+        }
+        return RuleSet{std::move(rules)};
+    }
+
+    RuleActions RuleSet::Match(const WindowIdentity& window) const
+    {
+        // 1. Collect candidates from the indices.
+        std::vector<std::uint32_t> candidates;
+
+        if (const auto i = m_byClass.find(window.m_class); i != m_byClass.end())
+        {
+            candidates.insert(candidates.end(), i->second.begin(), i->second.end());
+        }
+        if (const auto i = m_byInstance.find(window.m_instance); i != m_byInstance.end())
+        {
+            candidates.insert(candidates.end(), i->second.begin(), i->second.end());
+        }
+        m_titles.FindAll(window.m_title, candidates);
+        candidates.insert(candidates.end(), m_always.begin(), m_always.end());
+
+        // 2. Check them in rule order, a literal may occur several times.
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        RuleActions actions;
+        for (const std::uint32_t id : candidates)
+        {
+            if (Matches(m_rules[id], window))
+            {
+                actions.Merge(m_rules[id].m_actions);
+            }
+        }
+        return actions;
+    }
+}
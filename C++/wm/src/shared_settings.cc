@@ -0,0 +1,96 @@
+#include "shared_settings.h"
+#include "util.h"
+#include <iostream>
+#include <stdexcept>
+
+
+namespace WM
+{
+    SharedSettings::SharedSettings(const std::string& directory)
+        : m_directory{directory},
+          m_watcher{directory}
+    {
+        auto settings = std::make_shared<Settings>();
+        LoadConfig(settings->m_config);
+        LoadRules(settings->m_rules);
+        m_settings = std::move(settings);
+    }
+
+    void SharedSettings::Refresh()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // 1. Start from the current snapshot, it's never changed in place.
+        auto settings = std::make_shared<Settings>(*m_settings);
+        bool changed = false;
+        for (const std::string& name : m_watcher.ReadChanges())
+        {
+            if (name == "config")
+            {
+                changed |= LoadConfig(settings->m_config);
+            }
+            else if (name == "rules")
+            {
+                changed |= LoadRules(settings->m_rules);
+            }
+        }
+
+        // 2. Publish it.
+        if (changed)
+        {
+            m_settings = std::move(settings);
+            m_generation.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    std::shared_ptr<const Settings> SharedSettings::Get() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_settings;
+    }
+
+    bool SharedSettings::LoadConfig(Config& config) const
+    {
+        const std::string path = m_directory + "config";
+        const std::optional<std::string> text = ReadFile(path);
+        if (!text)
+        {
+            return false;
+        }
+
+        // A broken file keeps the current settings.
+        try
+        {
+            config = Config::Parse(*text);
+            return true;
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << path << ": " << e.what() << '\n';
+            return false;
+        }
+    }
+
+    bool SharedSettings::LoadRules(RuleSet& rules) const
+    {
+        const std::string path = m_directory + "rules";
+        const std::optional<std::string> text = ReadFile(path);
+        if (!text)
+        {
+            return false;
+        }
+
+        // Keep running with the current rules rather than failing.
+        try
+        {
+            rules = RuleSet::Parse(*text);
+            std::cout << "Loaded " << rules.GetSize() << " window rules from " << path << '\n';
+            return true;
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << path << ": " << e.what() << '\n';
+            return false;
+        }
+    }
+}
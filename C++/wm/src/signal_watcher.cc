@@ -0,0 +1,63 @@
+#include "signal_watcher.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sys/signalfd.h>
+
+
+namespace WM
+{
+    namespace
+    {
+        sigset_t MakeSet(int signal)
+        {
+            sigset_t set;
+            sigemptyset(&set);
+            sigaddset(&set, signal);
+            return set;
+        }
+    }
+
+    SignalWatcher::SignalWatcher(int signal)
+        : m_fd{-1}
+    {
+        const sigset_t set = MakeSet(signal);
+        if (pthread_sigmask(SIG_BLOCK, &set, nullptr) != 0)
+        {
+            std::cerr << "Can't block signal " << signal << '\n';
+            return;
+        }
+
+        m_fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (m_fd < 0)
+        {
+            std::cerr << "Can't watch signal " << signal << ": " << std::strerror(errno) << '\n';
+        }
+    }
+
+    SignalWatcher::~SignalWatcher()
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    bool SignalWatcher::ReadSignals()
+    {
+        if (m_fd < 0)
+        {
+            return false;
+        }
+
+        bool received = false;
+        signalfd_siginfo info;
+        while (read(m_fd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info)))
+        {
+            received = true;
+        }
+        return received;
+    }
+}
@@ -0,0 +1,127 @@
+#include "switcher.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace WM
+{
+    Switcher::Switcher(unsigned int cell_width, unsigned int cell_height, unsigned int padding)
+        : m_cellWidth{cell_width},
+          m_cellHeight{cell_height},
+          m_padding{padding}
+    {
+
+    }
+
+    void Switcher::Open(std::vector<Window> clients, const Rect<int>& output)
+    {
+        m_open = true;
+        m_clients = std::move(clients);
+        m_selected = m_clients.size() > 1 ? 1 : 0;
+        m_output = output;
+        m_firstRow = 0;
+        Layout();
+        Scroll();
+    }
+
+    void Switcher::Close()
+    {
+        m_open = false;
+        m_clients.clear();
+        m_selected = 0;
+    }
+
+    bool Switcher::Next()
+    {
+        if (m_clients.empty())
+        {
+            return false;
+        }
+
+        m_selected = (m_selected + 1) % m_clients.size();
+        return Scroll();
+    }
+
+    bool Switcher::Remove(Window client)
+    {
+        const std::optional<std::size_t> i = Find(client);
+        if (!i)
+        {
+            return false;
+        }
+
+        m_clients.erase(m_clients.begin() + static_cast<std::ptrdiff_t>(*i));
+        if (*i < m_selected || m_selected >= m_clients.size())
+        {
+            m_selected = m_selected > 0 ? m_selected - 1 : 0;
+        }
+        Layout();
+        Scroll();
+        return true;
+    }
+
+    Window Switcher::GetSelected() const
+    {
+        return m_selected < m_clients.size() ? m_clients[m_selected] : None;
+    }
+
+    std::optional<std::size_t> Switcher::Find(Window client) const
+    {
+        const auto i = std::find(m_clients.begin(), m_clients.end(), client);
+        if (i == m_clients.end())
+        {
+            return std::nullopt;
+        }
+        return static_cast<std::size_t>(i - m_clients.begin());
+    }
+
+    std::optional<Position<int>> Switcher::GetCellPosition(std::size_t i) const
+    {
+        const std::size_t row = i / m_columns;
+        if (row < m_firstRow || row >= m_firstRow + m_visibleRows)
+        {
+            return std::nullopt;
+        }
+
+        const std::size_t column = i % m_columns;
+        return Position<int>(static_cast<int>(m_padding + column * (m_cellWidth + m_padding)),
+                             static_cast<int>(m_padding + (row - m_firstRow) * (m_cellHeight + m_padding)));
+    }
+
+    void Switcher::Layout()
+    {
+        const std::size_t count = std::max<std::size_t>(m_clients.size(), 1);
+        const std::size_t cell_width = m_cellWidth + m_padding;
+        const std::size_t cell_height = m_cellHeight + m_padding;
+
+        // 1. Roughly square, as many columns as fit on the output.
+        const auto usable_width = static_cast<std::size_t>(std::max(m_output.m_width - static_cast<int>(m_padding), 0));
+        const std::size_t fit_columns = std::max<std::size_t>(1, usable_width / cell_width);
+        m_columns = std::min(fit_columns, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(count)))));
+
+        // 2. As many rows as fit, the rest scrolls.
+        const std::size_t rows = (count + m_columns - 1) / m_columns;
+        const auto usable_height = static_cast<std::size_t>(std::max(m_output.m_height - static_cast<int>(m_padding), 0));
+        const std::size_t fit_rows = std::max<std::size_t>(1, usable_height / cell_height);
+        m_visibleRows = std::min(rows, fit_rows);
+        m_firstRow = std::min(m_firstRow, rows - m_visibleRows);
+
+        // 3. Center on the output.
+        const int width = static_cast<int>(m_columns * cell_width + m_padding);
+        const int height = static_cast<int>(m_visibleRows * cell_height + m_padding);
+        m_bounds = Rect<int>(m_output.m_x + (m_output.m_width - width) / 2,
+                             m_output.m_y + (m_output.m_height - height) / 2,
+                             width, height);
+    }
+
+    bool Switcher::Scroll()
+    {
+        const std::size_t row = m_selected / m_columns;
+        const std::size_t first_row = row < m_firstRow ? row
+                                    : row >= m_firstRow + m_visibleRows ? row + 1 - m_visibleRows
+                                    : m_firstRow;
+        const bool scrolled = first_row != m_firstRow;
+        m_firstRow = first_row;
+        return scrolled;
+    }
+}
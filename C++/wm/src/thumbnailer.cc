@@ -0,0 +1,413 @@
+#include "thumbnailer.h"
+#include "pixel_ops.h"
+#include "xcb_request.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+extern "C"
+{
+    #include <xcb/xcb.h>
+    #include <xcb/xcbext.h>
+    #include <X11/extensions/composite.h>
+    #include <X11/extensions/damagewire.h>
+}
+
+
+namespace WM
+{
+    namespace
+    {
+        // There is no xcb-composite or xcb-damage here, the requests used
+        // are sent raw.
+        xcb_extension_t COMPOSITE_EXTENSION{COMPOSITE_NAME, 0};
+        xcb_extension_t DAMAGE_EXTENSION{DAMAGE_NAME, 0};
+
+        // Sends a request made of 32 bit fields after the header.
+        template <std::size_t N>
+        unsigned int Send(xcb_connection_t* connection, xcb_extension_t* extension, std::uint8_t minor_opcode,
+                          const std::uint32_t (&fields)[N], bool has_reply)
+        {
+            std::uint32_t request[N + 1]{};
+            std::copy_n(fields, N, request + 1);
+            return Xcb::SendRequest(connection, extension, minor_opcode, request, sizeof(request), has_reply);
+        }
+
+        void Signal(int fd)
+        {
+            const std::uint64_t one = 1;
+            if (write(fd, &one, sizeof(one)) < 0)
+            {
+                // The counter can only overflow after 2^64 signals.
+            }
+        }
+
+        void Drain(int fd)
+        {
+            std::uint64_t counter;
+            if (read(fd, &counter, sizeof(counter)) < 0)
+            {
+                // EAGAIN, nothing was signalled.
+            }
+        }
+    }
+
+    Thumbnailer::Thumbnailer(const std::string& displayName, unsigned int width, unsigned int height,
+                             std::uint32_t background, Clock::duration frame_interval, Clock::duration frame_budget)
+        : m_connection{nullptr},
+          m_width{width}, m_height{height}, m_background{background},
+          m_frameInterval{frame_interval}, m_frameBudget{frame_budget},
+          m_wakeFd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)},
+          m_notifyFd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+    {
+        int screen_number = 0;
+        m_connection = xcb_connect(displayName.empty() ? nullptr : displayName.c_str(), &screen_number);
+        if (xcb_connection_has_error(m_connection) || m_wakeFd < 0 || m_notifyFd < 0)
+        {
+            xcb_disconnect(m_connection);
+            close(m_wakeFd);
+            close(m_notifyFd);
+            throw std::runtime_error("Thumbnailer failed to connect to X display " + displayName);
+        }
+
+        xcb_screen_iterator_t screen = xcb_setup_roots_iterator(xcb_get_setup(m_connection));
+        for (int i = 0; i < screen_number && screen.rem > 0; ++i)
+        {
+            xcb_screen_next(&screen);
+        }
+        m_rootWindow = screen.data->root;
+        m_rootDepth = screen.data->root_depth;
+
+        // 1. The only round trips outside the worker, at startup: whether
+        // the server has both extensions, and their versions, which have to
+        // be asked before use.
+        const xcb_query_extension_reply_t* composite = xcb_get_extension_data(m_connection, &COMPOSITE_EXTENSION);
+        const xcb_query_extension_reply_t* damage = xcb_get_extension_data(m_connection, &DAMAGE_EXTENSION);
+        if (composite == nullptr || !composite->present || damage == nullptr || !damage->present)
+        {
+            return;
+        }
+        m_damageEvent = damage->first_event;
+
+        const unsigned int composite_version = Send(m_connection, &COMPOSITE_EXTENSION, X_CompositeQueryVersion,
+                                                    {COMPOSITE_MAJOR, COMPOSITE_MINOR}, true);
+        const unsigned int damage_version = Send(m_connection, &DAMAGE_EXTENSION, X_DamageQueryVersion,
+                                                 {DAMAGE_MAJOR, DAMAGE_MINOR}, true);
+        for (const unsigned int request : {composite_version, damage_version})
+        {
+            void* reply = xcb_wait_for_reply(m_connection, request, nullptr);
+            m_available = reply != nullptr;
+            std::free(reply);
+            if (!m_available)
+            {
+                return;
+            }
+        }
+
+        // 2. Keep the contents of top-level windows off screen, the server
+        // still draws them to the screen itself.
+        Send(m_connection, &COMPOSITE_EXTENSION, X_CompositeRedirectSubwindows,
+             {m_rootWindow, CompositeRedirectAutomatic}, false);
+
+        m_gc = xcb_generate_id(m_connection);
+        xcb_create_gc(m_connection, m_gc, m_rootWindow, 0, nullptr);
+        xcb_flush(m_connection);
+
+        m_worker = std::thread{&Thumbnailer::WorkerMain, this};
+    }
+
+    Thumbnailer::~Thumbnailer()
+    {
+        if (m_worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            Signal(m_wakeFd);
+            m_worker.join();
+        }
+
+        // The server frees the thumbnails, damage objects and redirection
+        // with the connection.
+        xcb_disconnect(m_connection);
+        close(m_wakeFd);
+        close(m_notifyFd);
+    }
+
+    void Thumbnailer::Add(Window client, Window top_level)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_commands.push_back({client, top_level});
+        }
+        Signal(m_wakeFd);
+    }
+
+    void Thumbnailer::Remove(Window client)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_commands.push_back({client, None});
+        }
+        Signal(m_wakeFd);
+    }
+
+    void Thumbnailer::Show(std::vector<Window> clients)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shown = std::move(clients);
+            m_visible = true;
+        }
+        Signal(m_wakeFd);
+    }
+
+    void Thumbnailer::Hide()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_visible = false;
+        }
+        Signal(m_wakeFd);
+    }
+
+    std::vector<Thumbnailer::Update> Thumbnailer::TakeUpdates()
+    {
+        // Reset the eventfd counter before taking the queue, so an update
+        // posted in between wakes the loop again.
+        Drain(m_notifyFd);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Update> updates;
+        updates.swap(m_updates);
+        return updates;
+    }
+
+    //------------------------------------------------------------------//
+    //                              WORKER                              //
+    //------------------------------------------------------------------//
+
+    void Thumbnailer::WorkerMain()
+    {
+        pollfd fds[2];
+        fds[0].fd = m_wakeFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = xcb_get_file_descriptor(m_connection);
+        fds[1].events = POLLIN;
+
+        Clock::time_point next_frame = Clock::now();
+        while (true)
+        {
+            // 1. Catch up on commands and damage.
+            Drain(m_wakeFd);
+            if (!TakeCommands())
+            {
+                return;
+            }
+            ReadDamage();
+            if (xcb_connection_has_error(m_connection))
+            {
+                return;
+            }
+
+            // 2. Render a frame when it's due. Damage arriving meanwhile is
+            // queued by xcb while waiting for replies, poll wouldn't see it.
+            const Clock::time_point now = Clock::now();
+            if (m_active && now >= next_frame && HasDirty())
+            {
+                RenderFrame(now + m_frameBudget);
+                next_frame = now + m_frameInterval;
+                ReadDamage();
+            }
+
+            // 3. Sleep until told something, damage arrives, or the next
+            // frame if there is something to render.
+            int timeout = -1;
+            if (m_active && HasDirty())
+            {
+                const auto remaining = std::max(Clock::duration::zero(), next_frame - Clock::now());
+                timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+            }
+            poll(fds, 2, timeout);
+        }
+    }
+
+    bool Thumbnailer::TakeCommands()
+    {
+        std::vector<Command> commands;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop)
+            {
+                return false;
+            }
+            commands.swap(m_commands);
+            if (m_visible)
+            {
+                m_order = m_shown;
+            }
+            m_active = m_visible;
+        }
+
+        for (const Command& command : commands)
+        {
+            // Replace a client's tracking, or stop it.
+            const auto i = m_entries.find(command.m_client);
+            if (i != m_entries.end())
+            {
+                // Damage objects go with their window, this may fail.
+                Send(m_connection, &DAMAGE_EXTENSION, X_DamageDestroy, {i->second.m_damage}, false);
+                if (i->second.m_pixmap != None)
+                {
+                    xcb_free_pixmap(m_connection, static_cast<xcb_pixmap_t>(i->second.m_pixmap));
+                }
+                m_damages.erase(i->second.m_damage);
+                m_entries.erase(i);
+            }
+
+            if (command.m_topLevel != None)
+            {
+                // Report once until subtracted, not every draw.
+                const std::uint32_t damage = xcb_generate_id(m_connection);
+                Send(m_connection, &DAMAGE_EXTENSION, X_DamageCreate,
+                     {damage, static_cast<std::uint32_t>(command.m_topLevel), XDamageReportNonEmpty}, false);
+                m_entries.emplace(command.m_client, Entry{command.m_topLevel, damage});
+                m_damages.emplace(damage, command.m_client);
+            }
+        }
+        xcb_flush(m_connection);
+        return true;
+    }
+
+    void Thumbnailer::ReadDamage()
+    {
+        while (xcb_generic_event_t* event = xcb_poll_for_event(m_connection))
+        {
+            // Errors are expected, windows may be gone.
+            if ((event->response_type & 0x7f) == m_damageEvent + XDamageNotify)
+            {
+                const std::uint32_t damage = Xcb::ReadCard32(reinterpret_cast<const unsigned char*>(event), 8);
+                const auto i = m_damages.find(damage);
+                if (i != m_damages.end())
+                {
+                    m_entries.at(i->second).m_dirty = true;
+                }
+            }
+            std::free(event);
+        }
+    }
+
+    bool Thumbnailer::HasDirty() const
+    {
+        return std::any_of(m_order.begin(), m_order.end(), [this](Window client)
+        {
+            const auto i = m_entries.find(client);
+            return i != m_entries.end() && i->second.m_dirty;
+        });
+    }
+
+    void Thumbnailer::RenderFrame(Clock::time_point deadline)
+    {
+        std::vector<Update> updates;
+        for (const Window client : m_order)
+        {
+            const auto i = m_entries.find(client);
+            if (i == m_entries.end() || !i->second.m_dirty)
+            {
+                continue;
+            }
+
+            // Unreadable windows are tried again once drawn to.
+            i->second.m_dirty = false;
+            if (Capture(i->second))
+            {
+                updates.push_back({client, i->second.m_pixmap});
+            }
+
+            if (Clock::now() >= deadline)
+            {
+                break;
+            }
+        }
+
+        if (updates.empty())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_updates.insert(m_updates.end(), updates.begin(), updates.end());
+        }
+        Signal(m_notifyFd);
+    }
+
+    bool Thumbnailer::Capture(Entry& entry)
+    {
+        const auto window = static_cast<std::uint32_t>(entry.m_topLevel);
+
+        // 1. Take the damage first, drawing from now on dirties it again.
+        Send(m_connection, &DAMAGE_EXTENSION, X_DamageSubtract, {entry.m_damage, 0u, 0u}, false);
+
+        // 2. The contents include the border.
+        xcb_get_geometry_reply_t* geometry =
+            xcb_get_geometry_reply(m_connection, xcb_get_geometry(m_connection, window), nullptr);
+        if (geometry == nullptr)
+        {
+            return false;
+        }
+        const std::uint16_t width = static_cast<std::uint16_t>(geometry->width + 2 * geometry->border_width);
+        const std::uint16_t height = static_cast<std::uint16_t>(geometry->height + 2 * geometry->border_width);
+        std::free(geometry);
+
+        // 3. Read the contents through a pixmap named for this capture, a
+        // resize gives the window a new one.
+        const std::uint32_t contents = xcb_generate_id(m_connection);
+        Send(m_connection, &COMPOSITE_EXTENSION, X_CompositeNameWindowPixmap, {window, contents}, false);
+        const xcb_get_image_cookie_t image_cookie =
+            xcb_get_image(m_connection, XCB_IMAGE_FORMAT_Z_PIXMAP, contents, 0, 0, width, height, ~0u);
+        xcb_free_pixmap(m_connection, contents);
+
+        xcb_get_image_reply_t* image = xcb_get_image_reply(m_connection, image_cookie, nullptr);
+        if (image == nullptr)
+        {
+            return false;
+        }
+
+        // 4. Top-level windows are 24 or 32 bit deep, 32 bits per pixel.
+        const std::size_t expected = std::size_t{width} * height * sizeof(std::uint32_t);
+        const bool readable = (image->depth == 24 || image->depth == 32)
+            && static_cast<std::size_t>(xcb_get_image_data_length(image)) >= expected;
+        if (readable)
+        {
+            // Reply data follows the 32 byte header of a malloc'ed block, it
+            // is aligned for pixels and read in place.
+            const auto* pixels = reinterpret_cast<const std::uint32_t*>(xcb_get_image_data(image));
+            m_pixels.resize(std::size_t{m_width} * m_height);
+            Pixel::ScaleThumbnailArgb(pixels, width, height, m_pixels.data(), m_width, m_height, m_background);
+        }
+        std::free(image);
+        if (!readable)
+        {
+            return false;
+        }
+
+        // 5. Upload, reusing the client's thumbnail pixmap.
+        if (entry.m_pixmap == None)
+        {
+            entry.m_pixmap = xcb_generate_id(m_connection);
+            xcb_create_pixmap(m_connection, m_rootDepth, static_cast<xcb_pixmap_t>(entry.m_pixmap), m_rootWindow,
+                              static_cast<std::uint16_t>(m_width), static_cast<std::uint16_t>(m_height));
+        }
+        xcb_put_image(m_connection, XCB_IMAGE_FORMAT_Z_PIXMAP, static_cast<xcb_pixmap_t>(entry.m_pixmap), m_gc,
+                      static_cast<std::uint16_t>(m_width), static_cast<std::uint16_t>(m_height), 0, 0, 0, m_rootDepth,
+                      static_cast<std::uint32_t>(m_pixels.size() * sizeof(std::uint32_t)),
+                      reinterpret_cast<const std::uint8_t*>(m_pixels.data()));
+        xcb_flush(m_connection);
+        return true;
+    }
+}
@@ -0,0 +1,286 @@
+#include "trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace WM
+{
+    namespace
+    {
+        constexpr char TRACE_MAGIC[8] = {'W', 'M', 'T', 'R', 'A', 'C', 'E', '\0'};
+        constexpr std::uint32_t TRACE_VERSION = 1;
+
+        // Written out once this much is buffered.
+        constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+        std::string ErrnoString()
+        {
+            return std::strerror(errno);
+        }
+
+        // write(2) until everything is written.
+        bool WriteAll(int fd, const unsigned char* data, std::size_t size)
+        {
+            while (size > 0)
+            {
+                const ssize_t written = write(fd, data, size);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= static_cast<std::size_t>(written);
+            }
+            return true;
+        }
+    }
+
+    std::size_t GetEventSize(int type)
+    {
+        switch (type)
+        {
+            case KeyPress:
+            case KeyRelease:
+                return sizeof(XKeyEvent);
+            case ButtonPress:
+            case ButtonRelease:
+                return sizeof(XButtonEvent);
+            case MotionNotify:
+                return sizeof(XMotionEvent);
+            case EnterNotify:
+            case LeaveNotify:
+                return sizeof(XCrossingEvent);
+            case FocusIn:
+            case FocusOut:
+                return sizeof(XFocusChangeEvent);
+            case Expose:
+                return sizeof(XExposeEvent);
+            case CreateNotify:
+                return sizeof(XCreateWindowEvent);
+            case DestroyNotify:
+                return sizeof(XDestroyWindowEvent);
+            case UnmapNotify:
+                return sizeof(XUnmapEvent);
+            case MapNotify:
+                return sizeof(XMapEvent);
+            case MapRequest:
+                return sizeof(XMapRequestEvent);
+            case ReparentNotify:
+                return sizeof(XReparentEvent);
+            case ConfigureNotify:
+                return sizeof(XConfigureEvent);
+            case ConfigureRequest:
+                return sizeof(XConfigureRequestEvent);
+            case PropertyNotify:
+                return sizeof(XPropertyEvent);
+            case ClientMessage:
+                return sizeof(XClientMessageEvent);
+            default:
+                return sizeof(XEvent);
+        }
+    }
+
+    //------------------------------------------------------------------//
+    //                              WRITER                              //
+    //------------------------------------------------------------------//
+
+    TraceWriter::TraceWriter(const std::string& path)
+        : m_fd{open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)},
+          m_start{std::chrono::steady_clock::now()}
+    {
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("Can't create trace " + path + ": " + ErrnoString());
+        }
+
+        m_buffer.reserve(BUFFER_SIZE + sizeof(XEvent) + sizeof(TraceRecordHeader));
+
+        TraceHeader header;
+        std::memcpy(header.m_magic, TRACE_MAGIC, sizeof(header.m_magic));
+        header.m_version = TRACE_VERSION;
+        header.m_longSize = sizeof(long);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(header));
+    }
+
+    TraceWriter::~TraceWriter()
+    {
+        Flush();
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    void TraceWriter::WriteEvent(TraceRecordKind kind, const XEvent& e)
+    {
+        Append(kind, &e, GetEventSize(e.type));
+    }
+
+    void TraceWriter::WriteRequest(std::uint8_t opcode, Window w, const std::vector<Window>& results)
+    {
+        TraceRequest request{};
+        request.m_opcode = opcode;
+        request.m_window = static_cast<std::uint32_t>(w);
+
+        // X ids are 29 bits, stored as 32 whatever the size of Window.
+        std::vector<std::uint32_t> ids(results.begin(), results.end());
+        Append(TraceRecordKind::Request, &request, sizeof(request),
+               ids.data(), ids.size() * sizeof(std::uint32_t));
+    }
+
+    void TraceWriter::Append(TraceRecordKind kind, const void* payload, std::size_t size,
+                             const void* extra, std::size_t extra_size)
+    {
+        if (m_fd < 0)
+        {
+            return;
+        }
+
+        TraceRecordHeader header{};
+        header.m_time = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_start).count());
+        header.m_size = static_cast<std::uint32_t>(size + extra_size);
+        header.m_kind = kind;
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(header));
+        bytes = static_cast<const unsigned char*>(payload);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        if (extra_size > 0)
+        {
+            bytes = static_cast<const unsigned char*>(extra);
+            m_buffer.insert(m_buffer.end(), bytes, bytes + extra_size);
+        }
+
+        if (m_buffer.size() >= BUFFER_SIZE)
+        {
+            Flush();
+        }
+    }
+
+    void TraceWriter::Flush()
+    {
+        if (m_fd < 0 || m_buffer.empty())
+        {
+            return;
+        }
+
+        if (!WriteAll(m_fd, m_buffer.data(), m_buffer.size()))
+        {
+            std::cerr << "Can't write trace, recording stopped: " << ErrnoString() << '\n';
+            close(m_fd);
+            m_fd = -1;
+        }
+        m_buffer.clear();
+    }
+
+    //------------------------------------------------------------------//
+    //                              READER                              //
+    //------------------------------------------------------------------//
+
+    TraceReader::TraceReader(const std::string& path)
+        : m_data{nullptr},
+          m_size{0}
+    {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't open trace " + path + ": " + ErrnoString());
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) < 0 || static_cast<std::size_t>(status.st_size) < sizeof(TraceHeader))
+        {
+            close(fd);
+            throw std::runtime_error(path + " is not a trace");
+        }
+        m_size = static_cast<std::size_t>(status.st_size);
+
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Can't map trace " + path + ": " + ErrnoString());
+        }
+        m_data = static_cast<const unsigned char*>(data);
+        madvise(data, m_size, MADV_SEQUENTIAL);
+
+        TraceHeader header;
+        std::memcpy(&header, m_data, sizeof(header));
+        if (std::memcmp(header.m_magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+            header.m_version != TRACE_VERSION || header.m_longSize != sizeof(long))
+        {
+            munmap(data, m_size);
+            throw std::runtime_error(path + " is not a trace of this version and machine type");
+        }
+    }
+
+    TraceReader::~TraceReader()
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+
+    bool TraceReader::Read(std::size_t& offset, Record& record) const
+    {
+        if (offset + sizeof(TraceRecordHeader) > m_size)
+        {
+            return false;
+        }
+
+        TraceRecordHeader header;
+        std::memcpy(&header, m_data + offset, sizeof(header));
+
+        // A truncated last record, e.g. from a crash while writing.
+        if (offset + sizeof(header) + header.m_size > m_size)
+        {
+            return false;
+        }
+
+        record.m_kind = header.m_kind;
+        record.m_time = std::chrono::nanoseconds{header.m_time};
+        record.m_payload = m_data + offset + sizeof(header);
+        record.m_size = header.m_size;
+        offset += sizeof(header) + header.m_size;
+        return true;
+    }
+
+    XEvent TraceReader::Record::GetEvent() const
+    {
+        XEvent e;
+        std::memset(&e, 0, sizeof(e));
+        std::memcpy(&e, m_payload, std::min(m_size, sizeof(e)));
+        return e;
+    }
+
+    TraceRequest TraceReader::Record::GetRequest() const
+    {
+        TraceRequest request{};
+        std::memcpy(&request, m_payload, std::min(m_size, sizeof(request)));
+        return request;
+    }
+
+    std::vector<Window> TraceReader::Record::GetResults() const
+    {
+        std::vector<Window> results;
+        for (std::size_t offset = sizeof(TraceRequest); offset + sizeof(std::uint32_t) <= m_size;
+             offset += sizeof(std::uint32_t))
+        {
+            std::uint32_t id;
+            std::memcpy(&id, m_payload + offset, sizeof(id));
+            results.push_back(id);
+        }
+        return results;
+    }
+}
@@ -1,5 +1,7 @@
 #include "util.h"
 #include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <sstream>
 #include <vector>
 
@@ -352,3 +354,27 @@ std::string XRequestCodeToString(unsigned char request_code)
     };
     return X_REQUEST_CODE_NAMES[request_code];
 }
+
+std::string ConfigPath(const std::string& name)
+{
+    if (const char* config_home = std::getenv("XDG_CONFIG_HOME"); config_home != nullptr && *config_home != '\0')
+    {
+        return std::string{config_home} + "/wm/" + name;
+    }
+
+    const char* home = std::getenv("HOME");
+    return std::string{home != nullptr ? home : ""} + "/.config/wm/" + name;
+}
+
+std::optional<std::string> ReadFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return std::nullopt;
+    }
+
+    std::ostringstream out;
+    out << in.rdbuf();
+    return out.str();
+}
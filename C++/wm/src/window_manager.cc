@@ -1,51 +1,161 @@
 #include "window_manager.h"
 #include "util.h"
+#include "xlib_backend.h"
 #include <X11/X.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cerrno>
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <cstring>
+#include <csignal>
+#include <poll.h>
 
 // For spacial keys such as audio keys
 #include <X11/XF86keysym.h>
 
 // general keys
 #include <X11/Xutil.h>
+#include <X11/Xatom.h>
 
 
 
 namespace WM
 {
-    // Init static member
-    bool WindowManager::m_wmDetected{};
-    std::mutex WindowManager::m_wmDetectedMutex{};
+    namespace
+    {
+        // Title bar decorations.
+        constexpr unsigned int ICON_SIZE = 16;
+        constexpr unsigned int TITLE_BAR_PADDING = 2;
+        constexpr unsigned int TITLE_BAR_HEIGHT = ICON_SIZE + 2 * TITLE_BAR_PADDING;
+
+        // Clients managed in place have no title bar.
+        constexpr int GetTitleBarHeight(bool reparented)
+        {
+            return reparented ? static_cast<int>(TITLE_BAR_HEIGHT) : 0;
+        }
+
+        // Switcher thumbnails, the space between them and the marker around
+        // the selected one.
+        constexpr unsigned int THUMBNAIL_WIDTH = 192;
+        constexpr unsigned int THUMBNAIL_HEIGHT = 120;
+        constexpr unsigned int SWITCHER_PADDING = 12;
+        constexpr unsigned int SWITCHER_MARKER_WIDTH = 3;
+
+        // Modifiers that don't change which key binding a key press means.
+        constexpr unsigned int IGNORED_MODIFIERS = LockMask | Mod2Mask;
+
+        // Events dispatched before checking the connection for newer ones.
+        constexpr int EVENT_BATCH_SIZE = 16;
+
+        // The handler of an event type, the phase its requests are
+        // accounted to.
+        const char* GetHandlerName(int type)
+        {
+            switch (type)
+            {
+                case CreateNotify: return "OnCreateNotify";
+                case ConfigureRequest: return "OnConfigureRequest";
+                case ConfigureNotify: return "OnConfigureNotify";
+                case MapRequest: return "OnMapRequest";
+                case UnmapNotify: return "OnUnmapNotify";
+                case ReparentNotify: return "OnReparentNotify";
+                case MapNotify: return "OnMapNotify";
+                case DestroyNotify: return "OnDestroyNotify";
+                case ButtonPress: return "OnButtonPress";
+                case ButtonRelease: return "OnButtonRelease";
+                case MotionNotify: return "OnMotionNotify";
+                case GenericEvent: return "OnPointerEvent";
+                case KeyPress: return "OnKeyPress";
+                case KeyRelease: return "OnKeyRelease";
+                case Expose: return "OnExpose";
+                case EnterNotify: return "OnEnterNotify";
+                case PropertyNotify: return "OnPropertyNotify";
+                default: return "Ignored";
+            }
+        }
+    }
 
     WindowManager::WindowManager(const std::string& displayName)
-                            // Return the default root window for a given X server
-        :     m_connection{createConnection(displayName)}, m_rootWindow{DefaultRootWindow(m_connection)},
-              WM_PROTOCOLS(XInternAtom(m_connection, "WM_PROTOCOLS", false)),
-              WM_DELETE_WINDOW(XInternAtom(m_connection, "WM_DELETE_WINDOW", false))
+        : WindowManager(std::make_unique<XlibBackend>(displayName))
+    {
+
+    }
+
+    WindowManager::WindowManager(std::unique_ptr<XBackend> backend, std::shared_ptr<SharedSettings> settings)
+        :     m_backend{std::move(backend)},
+              // Return the default root window for a given X server
+              m_rootWindow{m_backend->GetRootWindow()},
+              m_sharedSettings{settings ? std::move(settings) : std::make_shared<SharedSettings>(ConfigPath(""))},
+              m_switcher{THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, SWITCHER_PADDING},
+              WM_PROTOCOLS(m_backend->InternAtom("WM_PROTOCOLS")),
+              WM_DELETE_WINDOW(m_backend->InternAtom("WM_DELETE_WINDOW")),
+              NET_WM_NAME(m_backend->InternAtom("_NET_WM_NAME")),
+              NET_WM_DESKTOP(m_backend->InternAtom("_NET_WM_DESKTOP")),
+              UTF8_STRING(m_backend->InternAtom("UTF8_STRING")),
+              NET_WM_ICON(m_backend->InternAtom("_NET_WM_ICON")),
+              NET_WM_WINDOW_TYPE(m_backend->InternAtom("_NET_WM_WINDOW_TYPE"))
     {
+        m_propertyAtoms = PropertyAtoms{WM_PROTOCOLS, NET_WM_NAME, NET_WM_WINDOW_TYPE, UTF8_STRING};
+
+        // The generation first, a newer snapshot is only applied again.
+        m_settingsGeneration = m_sharedSettings->GetGeneration();
+        m_settings = m_sharedSettings->Get();
+        m_config = m_settings->m_config;
+
+        // SIGUSR1 prints the stats. Blocked before the icon loader thread
+        // starts, so it's only ever read from the event loop.
+        m_statsSignal = std::make_unique<SignalWatcher>(SIGUSR1);
+
+        // Icons are decoded on a connection of their own, which needs a real
+        // server.
+        if (const std::optional<std::string> display_name = m_backend->GetDisplayName())
+        {
+            m_iconLoader = std::make_unique<IconLoader>(*display_name, ICON_SIZE, m_config.m_backgroundColor);
+            m_resourceSampler = std::make_unique<ResourceSampler>(*display_name);
 
+            // Without Composite the switcher switches blindly, as before.
+            m_thumbnailer = std::make_unique<Thumbnailer>(*display_name, THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT,
+                                                          static_cast<std::uint32_t>(m_config.m_backgroundColor));
+            if (!m_thumbnailer->IsAvailable())
+            {
+                m_thumbnailer.reset();
+            }
+        }
     }
 
     WindowManager::~WindowManager()
     {
-        // Close the connection with X server
-        XCloseDisplay(m_connection);
+        // Release icons before the loader that owns their pixmaps.
+        m_clients.clear();
+        m_iconLoader.reset();
     }
 
     // Move copy constructor
     WindowManager::WindowManager(WindowManager&& wm)
+        : m_sharedSettings{std::move(wm.m_sharedSettings)},
+          m_settings{std::move(wm.m_settings)},
+          m_settingsGeneration{wm.m_settingsGeneration},
+          m_config{wm.m_config},
+          m_switcher{wm.m_switcher},
+          m_propertyAtoms{wm.m_propertyAtoms},
+          NET_WM_NAME{wm.NET_WM_NAME},
+          NET_WM_DESKTOP{wm.NET_WM_DESKTOP},
+          UTF8_STRING{wm.UTF8_STRING},
+          NET_WM_ICON{wm.NET_WM_ICON},
+          NET_WM_WINDOW_TYPE{wm.NET_WM_WINDOW_TYPE}
     {
-        m_connection = wm.m_connection;
+        m_backend = std::move(wm.m_backend);
 
         m_rootWindow = wm.m_rootWindow;
 
         WM_PROTOCOLS = wm.WM_PROTOCOLS;
 
         wm.m_rootWindow = 0;
-        wm.m_connection = nullptr;
     }
 
     // Move assignment operator
@@ -55,224 +165,309 @@ namespace WM
         if(&wm == this)
             return *this;
 
-        m_connection = wm.m_connection;
+        m_backend = std::move(wm.m_backend);
 
         m_rootWindow = wm.m_rootWindow;
 
-        wm.m_rootWindow = 0;
-        wm.m_connection = nullptr;
-
-        return *this;
-    }
-
-    Display* WindowManager::createConnection(const std::string& displayName)
-    {
-        // 1. Open X display.
-
-        //Check if display is specified
-        const char* display_c_str = displayName.empty() ? nullptr : displayName.c_str();
-
-        Display* connection= XOpenDisplay(display_c_str);
+        m_sharedSettings = std::move(wm.m_sharedSettings);
+        m_settings = std::move(wm.m_settings);
+        m_settingsGeneration = wm.m_settingsGeneration;
+        m_config = wm.m_config;
 
+        m_propertyAtoms = wm.m_propertyAtoms;
 
-        if (connection == nullptr)
-        {
-            throw std::runtime_error("Failed to open X display " + std::string{XDisplayName(nullptr)});
-        }
+        wm.m_rootWindow = 0;
 
-        return connection;
+        return *this;
     }
 
-    void WindowManager::Run()
+    void WindowManager::Start()
     {
         // 1. Initialization.
-        //   a. Select events on root window. Use a special error handler so we can
-        //   exit gracefully if another window manager is already running.
-        {
-            std::lock_guard<std::mutex> lock(m_wmDetectedMutex);
-            m_wmDetected= false;
-
-            // Setup temporary error handler
-            XSetErrorHandler(&WindowManager::OnWMDetected);
-
-            // Take control over the root window
-            //            server,  window, events
-            XSelectInput(m_connection, m_rootWindow , SubstructureRedirectMask | SubstructureNotifyMask);
-
-              /* XSelectInput doesn't  send a request to the X server,
-               *
-               * instead only queues the request and returns
-               * we have to explicitly flush the request queue with XSync
-               *
-               * False means that XSync  will not discard the events
-               * */
-            XSync(m_connection, false);
-            if (m_wmDetected)
-            {
-                throw std::runtime_error("Detected another window manager on display " +
-                        std::string{XDisplayString(m_connection)});
-                return;
-            }
+        //   a. Select events on root window. Fails if another window manager
+        //   is already running.
+        m_backend->SetPhase("Start.RedirectRoot");
+        m_backend->RedirectRoot(SubstructureRedirectMask | SubstructureNotifyMask);
+
+        //   b. Place new windows on the root window. Without RandR, it is the
+        //   only output.
+        m_backend->SetPhase("Start.Outputs");
+        int root_x, root_y;
+        unsigned int root_width, root_height;
+        if (m_backend->GetGeometry(m_rootWindow, root_x, root_y, root_width, root_height))
+        {
+            m_placement.SetOutputs({Rect<int>(root_x, root_y, static_cast<int>(root_width), static_cast<int>(root_height))});
         }
 
-        //   b. Set error handler.
-        XSetErrorHandler(&WindowManager::OnXError);
-
         //   c. Grab X server to prevent windows from changing under us while we
         //   frame them.
-        XGrabServer(m_connection);
+        m_backend->GrabServer();
 
         //   d. Frame existing top-level windows.
         //     i. Query existing top-level windows.
-        Window returned_root;
-        Window returned_parent;
-
-        Window* top_level_windows;
-        unsigned int num_top_level_windows;
-
-        if (XQueryTree(m_connection, m_rootWindow, &returned_root, &returned_parent,
-                       &top_level_windows, &num_top_level_windows) == 0)
-        {
-            throw std::runtime_error("We can't query the window list");
-        }
-
-        if(returned_root != m_rootWindow)
-        {
-            throw std::runtime_error("returned_root != m_rootWindow");
-        }
+        m_backend->SetPhase("Start.QueryTree");
+        const std::vector<Window> top_level_windows = m_backend->QueryTree(m_rootWindow);
 
         //     ii. Frame each top-level window.
-        for (unsigned int i = 0; i < num_top_level_windows; ++i)
+        for (const Window w : top_level_windows)
         {
-            Frame(top_level_windows[i], true /* was_created_before_window_manager */);
+            m_backend->SetPhase("Start.Frame");
+            Frame(w, true /* was_created_before_window_manager */);
         }
-        //     iii. Free top-level window array.
-        XFree(top_level_windows);
 
         //   e. Ungrab X server.
-        XUngrabServer(m_connection);
+        m_backend->SetPhase("Start.Done");
+        m_backend->UngrabServer();
+    }
 
+    void WindowManager::Run()
+    {
+        Start();
+
+        // 2. Main event loop. Sleep on the X connection, the icon loader and
+        // the configuration directory, so finished icons and edited files
+        // are picked up without polling. A negative fd is skipped by poll.
+        pollfd fds[6];
+        fds[0].fd = m_backend->GetConnectionFd();
+        fds[0].events = POLLIN;
+        fds[1].fd = m_iconLoader ? m_iconLoader->GetNotifyFd() : -1;
+        fds[1].events = POLLIN;
+        fds[2].fd = m_sharedSettings->GetFd();
+        fds[2].events = POLLIN;
+        fds[3].fd = m_statsSignal->GetFd();
+        fds[3].events = POLLIN;
+        fds[4].fd = m_resourceSampler ? m_resourceSampler->GetFd() : -1;
+        fds[4].events = POLLIN;
+        fds[5].fd = m_thumbnailer ? m_thumbnailer->GetNotifyFd() : -1;
+        fds[5].events = POLLIN;
 
-        // 2. Main event loop.
         while(true)
         {
-            // 1. Get next event.
-            XEvent e;
-            XNextEvent(m_connection, &e);
-            std::cout << "Received event: " << ToString(e);
+            // 1. Handle every event already read from the connection. Pending
+            // also flushes our own requests.
+            ProcessPendingEvents();
+            m_backend->SetPhase("Run");
 
-            // 2. Dispatch event.
-            switch (e.type)
+            // 2. Destroy frames the pool has kept unused for too long.
+            for (const Window frame : m_framePool.TakeIdle(FramePool::Clock::now()))
             {
-                // When a client want to create window
-                case CreateNotify:
-                    OnCreateNotify(e.xcreatewindow);
-                break;
+                m_backend->DestroyWindow(frame);
+            }
 
-                case ConfigureRequest:
-                    OnConfigureRequest(e.xconfigurerequest);
-                break;
+            //   a. Sample client resources when it's time.
+            SampleResources();
 
-                case ConfigureNotify:
-                    OnConfigureNotify(e.xconfigure);
-                break;
+            //   b. Pick up settings reloaded here or by another display.
+            if (m_sharedSettings->GetGeneration() != m_settingsGeneration)
+            {
+                OnSettingsChanged();
+                continue;
+            }
 
-                case MapRequest:
-                    OnMapRequest(e.xmaprequest);
-                break;
+            // 3. Wait for more, or until held back motion, configure requests
+            // or focus are due, a pooled frame goes idle or resources are to
+            // be sampled.
+            using Duration = std::chrono::steady_clock::duration;
+            const auto now = std::chrono::steady_clock::now();
+            std::optional<Duration> wake_up;
+            for (const std::optional<Duration> timeout : {m_motion.GetTimeout(now),
+                                                          m_configureThrottle.GetTimeout(now),
+                                                          m_focusSettle.GetTimeout(now),
+                                                          m_framePool.GetTimeout(now),
+                                                          m_resourceSampler ? m_resourceSampler->GetTimeout(now) : std::nullopt})
+            {
+                if (timeout && (!wake_up || *timeout < *wake_up))
+                {
+                    wake_up = timeout;
+                }
+            }
+            const int timeout = wake_up ? static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(*wake_up).count()) : -1;
 
-                case UnmapNotify:
-                    OnUnmapNotify(e.xunmap);
-                break;
+            if (poll(fds, 6, timeout) < 0 && errno != EINTR)
+            {
+                throw std::runtime_error("poll failed: " + std::string{std::strerror(errno)});
+            }
 
-                case ReparentNotify:
-                    OnReparentNotify(e.xreparent);
-                break;
+            if (fds[1].revents & POLLIN)
+            {
+                OnIconsReady();
+            }
 
-                case MapNotify:
-                    OnMapNotify(e.xmap);
-                break;
+            if (fds[2].revents & POLLIN)
+            {
+                m_sharedSettings->Refresh();
+            }
 
-                case DestroyNotify:
-                    OnDestroyNotify(e.xdestroywindow);
-                break;
+            if ((fds[3].revents & POLLIN) && m_statsSignal->ReadSignals())
+            {
+                PrintStats(std::cout);
+            }
 
-                case ButtonPress:
-                    OnButtonPress(e.xbutton);
-                break;
+            if (fds[4].revents & POLLIN)
+            {
+                OnResourcesReady();
+            }
 
-                case ButtonRelease:
-                    OnButtonRelease(e.xbutton);
-                break;
+            if (fds[5].revents & POLLIN)
+            {
+                OnThumbnailsReady();
+            }
+        }
+    }
 
-                case MotionNotify:
-                    // Skip any already pending motion events.
-                    while (XCheckTypedWindowEvent(m_connection, e.xmotion.window, MotionNotify, &e))
-                    {
+    void WindowManager::ProcessPendingEvents()
+    {
+        while (true)
+        {
+            // 1. Take everything queued so far, so input behind a flood of
+            // other events is seen.
+            while (m_backend->Pending())
+            {
+                XEvent e;
+                m_backend->NextEvent(e);
+                std::cout << "Received event: " << ToString(e);
 
+                // XInput2 data is gone after the next read, decode it now.
+                if (e.type == GenericEvent)
+                {
+                    PointerEvent pointer;
+                    if (m_backend->GetPointerEvent(e, pointer))
+                    {
+                        m_scheduler.Push(e, pointer);
                     }
-                    OnMotionNotify(e.xmotion);
-                break;
-
-                case KeyPress:
-                    OnKeyPress(e.xkey);
-                break;
+                    continue;
+                }
+                m_scheduler.Push(e);
+            }
 
-                case KeyRelease:
-                    OnKeyRelease(e.xkey);
+            if (m_scheduler.IsEmpty())
+            {
                 break;
+            }
 
-                default:
-                std::cerr << "Ignored event";
-
+            // 2. Dispatch a batch by priority, then look for newer events.
+            EventScheduler::Entry entry;
+            for (int i = 0; i < EVENT_BATCH_SIZE && m_scheduler.Pop(entry); ++i)
+            {
+                if (entry.m_pointer)
+                {
+                    m_backend->SetPhase("OnPointerEvent");
+                    OnPointerEvent(*entry.m_pointer);
+                }
+                else
+                {
+                    HandleEvent(entry.m_event);
+                }
             }
         }
+
+        // Motion, configure requests and focus held back while events were
+        // queued may be due by now.
+        m_backend->SetPhase("DeliverMotion");
+        DeliverMotion();
+        m_backend->SetPhase("DeliverConfigures");
+        DeliverConfigures();
+        m_backend->SetPhase("DeliverFocus");
+        DeliverFocus();
+
+        // Properties changed by those events, read in one batch.
+        m_backend->SetPhase("RefreshProperties");
+        RefreshProperties();
     }
 
-    // Temporary error handler, to catch errors during this XSync invocation
-    int WindowManager::OnWMDetected(Display* display, XErrorEvent* e)
+    void WindowManager::HandleEvent(XEvent& e)
     {
-        // In the case of an already running window manager, the error code from
-        // XSelectInput is BadAccess. We don't expect this handler to receive any
-        // other errors.
-        if(static_cast<int>(e->error_code) == BadAccess)
-            throw std::runtime_error("A window manager is running!");
+        m_backend->SetPhase(GetHandlerName(e.type));
+        switch (e.type)
+        {
+            // When a client want to create window
+            case CreateNotify:
+                OnCreateNotify(e.xcreatewindow);
+            break;
+
+            case ConfigureRequest:
+                OnConfigureRequest(e.xconfigurerequest);
+            break;
+
+            case ConfigureNotify:
+                OnConfigureNotify(e.xconfigure);
+            break;
+
+            case MapRequest:
+                OnMapRequest(e.xmaprequest);
+            break;
+
+            case UnmapNotify:
+                OnUnmapNotify(e.xunmap);
+            break;
+
+            case ReparentNotify:
+                OnReparentNotify(e.xreparent);
+            break;
+
+            case MapNotify:
+                OnMapNotify(e.xmap);
+            break;
+
+            case DestroyNotify:
+                OnDestroyNotify(e.xdestroywindow);
+            break;
+
+            case ButtonPress:
+                OnButtonPress(e.xbutton);
+            break;
+
+            case ButtonRelease:
+                OnButtonRelease(e.xbutton);
+            break;
+
+            case MotionNotify:
+                // Skip any already pending motion events.
+                while (m_backend->CheckTypedWindowEvent(e.xmotion.window, MotionNotify, e))
+                {
 
-        // Set flag.
-        m_wmDetected= true;
-        // The return value is ignored.
-        return 0;
-    }
+                }
+                OnMotionNotify(e.xmotion);
+            break;
 
-    // Error handler
-    int WindowManager::OnXError(Display* display, XErrorEvent* e)
-    {
-        // Print the Error and continue
-        const int MAX_ERROR_TEXT_LENGTH = 1024;
+            case GenericEvent:
+            {
+                PointerEvent pointer;
+                if (m_backend->GetPointerEvent(e, pointer))
+                {
+                    OnPointerEvent(pointer);
+                }
+            }
+            break;
+
+            case KeyPress:
+                OnKeyPress(e.xkey);
+            break;
 
-        char error_text[MAX_ERROR_TEXT_LENGTH];
+            case KeyRelease:
+                OnKeyRelease(e.xkey);
+            break;
 
-        XGetErrorText(display, e->error_code, error_text, sizeof(error_text));
+            case Expose:
+                OnExpose(e.xexpose);
+            break;
 
-        std::cerr << "Received X error:\n"
-            << "    Request: " << int(e->request_code)
-            << " - " <<  XRequestCodeToString(e->request_code) << "\n"
-            << "    Error code: " << int(e->error_code)
-            << " - " << error_text << "\n"
-            << "    Resource ID: " << e->resourceid;
+            case EnterNotify:
+                OnEnterNotify(e.xcrossing);
+            break;
 
-        // The return value is ignored.
-        return 0;
+            case PropertyNotify:
+                OnPropertyNotify(e.xproperty);
+            break;
 
+            default:
+            std::cerr << "Ignored event";
+
+        }
     }
 
     void WindowManager::Frame(Window w, bool was_created_before_window_manager)
     {
-        // Visual properties of the frame to create.
-        constexpr unsigned int BORDER_WIDTH = 3;
-        constexpr unsigned long BORDER_COLOR = 0xff0000;
-        constexpr unsigned long BG_COLOR = 0x0000ff;
-
         // 1. Retrieve attributes of window to frame.
         XWindowAttributes x_window_attrs;
 
@@ -281,7 +476,7 @@ namespace WM
             throw std::runtime_error("We shouldn't be framing windows we've already framed.");
         }
 
-        if(XGetWindowAttributes(m_connection, w, &x_window_attrs) == 0)
+        if(!m_backend->GetWindowAttributes(w, x_window_attrs))
         {
             throw std::runtime_error("We can't get window attributes!");
         }
@@ -298,84 +493,127 @@ namespace WM
             }
         }
 
-        // 3. Create frame.
-        const Window frame { XCreateSimpleWindow(
-        m_connection,
-        m_rootWindow,
-        x_window_attrs.x,
-        x_window_attrs.y,
-        static_cast<unsigned int>(x_window_attrs.width),
-        static_cast<unsigned int>(x_window_attrs.height),
-        BORDER_WIDTH,
-        BORDER_COLOR,
-        BG_COLOR)
-        };
+        //   a. Follow property changes, then read the properties in one
+        //   batch. The batch is read after the select took effect, so no
+        //   change is missed in between.
+        //   Crossings are for focus to follow the pointer, on a client
+        //   managed in place, which gets its border colour in the same
+        //   request. The client's own event mask is its own, this one is
+        //   ours.
+        const bool reparent = m_config.m_frameMode == FrameMode::Reparent;
+        XSetWindowAttributes attributes;
+        attributes.event_mask = PropertyChangeMask | (reparent ? NoEventMask : EnterWindowMask);
+        attributes.border_pixel = m_config.m_borderColor;
+        m_backend->ChangeWindowAttributes(w, static_cast<unsigned long>(reparent ? CWEventMask : CWEventMask | CWBorderPixel), attributes);
+        ClientProperties properties;
+        const std::vector<PropertyRequest> requests = ClientProperties::GetRequests(m_propertyAtoms, w);
+        const std::vector<PropertyReply> replies = m_backend->GetProperties(requests);
+        for (std::size_t i = 0; i < requests.size(); ++i)
+        {
+            properties.Store(m_propertyAtoms, requests[i].m_property, replies[i]);
+        }
+
+        // 3. New windows go where they cover the others the least, unless
+        // they asked for a position.
+        const int title_bar_height = GetTitleBarHeight(reparent);
+        Position<int> frame_pos(x_window_attrs.x, x_window_attrs.y);
+        if (!was_created_before_window_manager)
+        {
+            frame_pos = PlaceFrame(properties, x_window_attrs).value_or(frame_pos);
+        }
+
+        Window frame = w;
+        if (reparent)
+        {
+            // 4. Create frame, with room for the title bar above the client.
+            // A pooled frame already has its colours and event mask, it only
+            // needs the new geometry.
+            frame = m_framePool.Take();
+            if (frame != None)
+            {
+                XWindowChanges changes;
+                changes.x = frame_pos.m_x;
+                changes.y = frame_pos.m_y;
+                changes.width = x_window_attrs.width;
+                changes.height = x_window_attrs.height + static_cast<int>(TITLE_BAR_HEIGHT);
+                m_backend->ConfigureWindow(frame, CWX | CWY | CWWidth | CWHeight, changes);
+            }
+            else
+            {
+                frame = m_backend->CreateSimpleWindow(
+                m_rootWindow,
+                frame_pos.m_x,
+                frame_pos.m_y,
+                static_cast<unsigned int>(x_window_attrs.width),
+                static_cast<unsigned int>(x_window_attrs.height) + TITLE_BAR_HEIGHT,
+                m_config.m_borderWidth,
+                m_config.m_borderColor,
+                m_config.m_backgroundColor);
+
+                //   a. Select events on frame. Exposure is needed to redraw the title bar,
+                //   crossings for focus to follow the pointer.
+                m_backend->SelectInput(frame, SubstructureRedirectMask | SubstructureNotifyMask | ExposureMask | EnterWindowMask);
+            }
+
 
-        // 4. Select events on frame.
-        XSelectInput(m_connection, frame, SubstructureRedirectMask | SubstructureNotifyMask);
+            //   b. Add client to save set, so that it will be restored and kept alive if we
+            //   crash.
+            m_backend->AddToSaveSet(w);
 
+            //   c. Reparent client window to the frame, below the title bar.
+            m_backend->ReparentWindow(w, frame, 0, TITLE_BAR_HEIGHT);  // Offset of client window within frame.
 
-        // 5. Add client to save set, so that it will be restored and kept alive if we
-        // crash.
-        XAddToSaveSet(m_connection, w);
+            //   d. Map frame, make it visible
+            m_backend->MapWindow(frame);
+        }
+        else
+        {
+            // 4. Manage the client in place, it is its own frame. Its events
+            // already reach us through the root window.
+            // The border and position go in a single request, the border
+            // colour was set along with the event mask.
+            XWindowChanges changes;
+            changes.x = frame_pos.m_x;
+            changes.y = frame_pos.m_y;
+            changes.border_width = static_cast<int>(m_config.m_borderWidth);
+            m_backend->ConfigureWindow(w, CWX | CWY | CWBorderWidth, changes);
+        }
 
-        // 6. Reparent client window to the frame
-        XReparentWindow(m_connection, w, frame, 0, 0);  // Offset of client window within frame.
+        // 5. Save frame handle.
+        Client& client = m_clients[w];
+        client.m_frame = frame;
+        client.m_reparented = reparent;
+        client.m_originalBorderWidth = static_cast<unsigned int>(x_window_attrs.border_width);
+        client.m_properties = std::move(properties);
+        m_frames[frame] = w;
+        const int border = 2 * static_cast<int>(m_config.m_borderWidth);
+        m_placement.Add(frame, Rect<int>(frame_pos.m_x, frame_pos.m_y,
+                                         x_window_attrs.width + border,
+                                         x_window_attrs.height + title_bar_height + border));
+        m_hitIndex.Raise(frame);
+
+        // 6. Ask for the window icon, it shows up in the title bar once decoded.
+        if (m_iconLoader && reparent)
+        {
+            m_iconLoader->Request(w);
+        }
 
-        // 7. Map frame, make it visible
-        XMapWindow(m_connection, frame);
+        //   a. Track its contents for the switcher.
+        if (m_thumbnailer)
+        {
+            m_thumbnailer->Add(w, frame);
+        }
 
-        // 8. Save frame handle.
-        m_clients[w] = frame;
+        // 7. Apply window rules.
+        ApplyRules(w, client);
 
         //   a. Move windows with alt + left button.
-        XGrabButton(
-            m_connection,
-            Button1,
-            Mod1Mask,
-            w,
-            false,
-            ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
-            GrabModeAsync,
-            GrabModeAsync,
-            None,
-            None
-        );
+        m_backend->GrabButton(Button1, Mod1Mask, w, ButtonPressMask | ButtonReleaseMask | ButtonMotionMask);
         //   b. Resize windows with alt + right button.
-        XGrabButton
-        (
-            m_connection,
-            Button3,
-            Mod1Mask,
-            w,
-            false,
-            ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
-            GrabModeAsync,
-            GrabModeAsync,
-            None,
-            None
-        );
-
-        //   c. Kill windows with alt + f4.
-        XGrabKey
-        (
-            m_connection,
-            XKeysymToKeycode(m_connection, XK_F4),
-            Mod1Mask,
-            w,
-            false,
-            GrabModeAsync,
-            GrabModeAsync);
-            //   d. Switch windows with alt + tab.
-            XGrabKey(
-            m_connection,
-            XKeysymToKeycode(m_connection, XK_Tab),
-            Mod1Mask,
-            w,
-            false,
-            GrabModeAsync,
-            GrabModeAsync
-        );
+        m_backend->GrabButton(Button3, Mod1Mask, w, ButtonPressMask | ButtonReleaseMask | ButtonMotionMask);
+
+        //   c. Key bindings.
+        GrabKeys(w, m_config.m_keyBindings);
 
 
         std::cout << "Framed window " << w << " [" << frame << "]";
@@ -385,22 +623,61 @@ namespace WM
     void WindowManager::Unframe(Window w)
     {
         // We reverse the steps taken in Frame().
-        const Window frame = m_clients[w];
+        const Client& client = m_clients[w];
+        const Window frame = client.m_frame;
 
-        // 1. Unmap frame.
-        XUnmapWindow(m_connection, frame);
+        if (client.m_reparented)
+        {
+            // 1. Unmap frame.
+            m_backend->UnmapWindow(frame);
 
-        // 2. Reparent client window back to root window.
-        XReparentWindow( m_connection, w, m_rootWindow, 0, 0);  // Offset of client window within root.
+            // 2. Reparent client window back to root window.
+            m_backend->ReparentWindow(w, m_rootWindow, 0, 0);  // Offset of client window within root.
 
-        // 3. Remove client window from save set, as it is now unrelated to us.
-        XRemoveFromSaveSet(m_connection, w);
+            // 3. Remove client window from save set, as it is now unrelated to us.
+            m_backend->RemoveFromSaveSet(w);
 
-        // 4. Destroy frame.
-        XDestroyWindow(m_connection, frame);
+            // 4. Keep the frame for the next client, or destroy it if the
+            // pool is full.
+            if (!m_framePool.Give(frame, FramePool::Clock::now()))
+            {
+                m_backend->DestroyWindow(frame);
+            }
+        }
+        else
+        {
+            // 1. Give the client its own border back.
+            m_backend->SetWindowBorderWidth(w, client.m_originalBorderWidth);
+        }
+        //   a. Stop following its properties and crossings.
+        m_backend->SelectInput(w, NoEventMask);
 
-        // 5. Drop reference to frame handle.
+        // 5. Drop reference to frame handle, and the thumbnail.
+        if (m_thumbnailer)
+        {
+            m_thumbnailer->Remove(w);
+            if (m_switcher.Remove(w))
+            {
+                if (m_switcher.GetClients().empty())
+                {
+                    CloseSwitcher(CurrentTime);
+                }
+                else
+                {
+                    m_backend->ClearWindow(m_switcherWindow);
+                }
+            }
+        }
+        m_configureThrottle.Remove(w);
         m_clients.erase(w);
+        m_frames.erase(frame);
+        m_placement.Remove(frame);
+        m_hitIndex.Remove(frame);
+        if (m_focusedClient == w)
+        {
+            m_focusedClient = None;
+        }
+        m_aboveClients.erase(w);
 
         std::cout  << "Unframed window " << w << " [" << frame << "]";
     }
@@ -417,6 +694,17 @@ namespace WM
     }
 
     void WindowManager::OnConfigureRequest(const XConfigureRequestEvent& e)
+    {
+        // Clients asking faster than the throttle allows get their latest
+        // geometry later, from DeliverConfigures.
+        if (m_clients.count(e.window) && !m_configureThrottle.Admit(e, ConfigureThrottle::Clock::now()))
+        {
+            return;
+        }
+        ApplyConfigureRequest(e);
+    }
+
+    void WindowManager::ApplyConfigureRequest(const XConfigureRequestEvent& e)
     {
         XWindowChanges changes;
         // Copy fields from e to changes.
@@ -432,13 +720,76 @@ namespace WM
         // Configure a window that is currently visible
         if (m_clients.count(e.window))
         {
-            const Window frame = m_clients[e.window];
-            XConfigureWindow(m_connection, frame, e.value_mask, &changes);
+            // The frame takes the position and stacking, and is taller by the
+            // title bar. The client only changes size inside the frame.
+            const Client& client = m_clients[e.window];
+            XWindowChanges frame_changes = changes;
+            frame_changes.height = e.height + GetTitleBarHeight(client.m_reparented);
+
+            const Window frame = client.m_frame;
+            const auto sibling = (e.value_mask & CWSibling) ? m_clients.find(e.above) : m_clients.end();
+            if (sibling != m_clients.end())
+            {
+                frame_changes.sibling = sibling->second.m_frame;
+            }
+            m_backend->ConfigureWindow(frame, static_cast<unsigned int>(e.value_mask & ~static_cast<unsigned long>(CWBorderWidth)), frame_changes);
+
+            // Keep the hit index in the stacking order the client asked for.
+            // TopIf, BottomIf and Opposite depend on overlap the server
+            // decides, they are taken as the raise or lower they ask for.
+            if (e.value_mask & CWStackMode)
+            {
+                const bool above = e.detail == Above || e.detail == TopIf || e.detail == Opposite;
+                if (sibling != m_clients.end())
+                {
+                    m_hitIndex.Restack(frame, sibling->second.m_frame, above);
+                }
+                else if (above)
+                {
+                    m_hitIndex.Raise(frame);
+                }
+                else
+                {
+                    m_hitIndex.Lower(frame);
+                }
+            }
+
+            // Keep the placement up to date with the fields that changed.
+            if (std::optional<Rect<int>> rect = m_placement.GetRect(frame))
+            {
+                const int border = 2 * static_cast<int>(m_config.m_borderWidth);
+                if (e.value_mask & CWX)
+                {
+                    rect->m_x = e.x;
+                }
+                if (e.value_mask & CWY)
+                {
+                    rect->m_y = e.y;
+                }
+                if (e.value_mask & CWWidth)
+                {
+                    rect->m_width = e.width + border;
+                }
+                if (e.value_mask & CWHeight)
+                {
+                    rect->m_height = frame_changes.height + border;
+                }
+                m_placement.Move(frame, *rect);
+            }
             std::cout << "Resize [" << frame << "] to " << Size<int>(e.width, e.height);
-        }
 
-        // Grant request by calling XConfigureWindow().
-        XConfigureWindow(m_connection, e.window, e.value_mask, &changes);
+            // A client managed in place is its own frame, and its border is
+            // ours.
+            if (client.m_reparented)
+            {
+                m_backend->ConfigureWindow(e.window, static_cast<unsigned int>(e.value_mask & (CWWidth | CWHeight | CWBorderWidth)), changes);
+            }
+        }
+        else
+        {
+            // Grant request by calling XConfigureWindow().
+            m_backend->ConfigureWindow(e.window, static_cast<unsigned int>(e.value_mask), changes);
+        }
 
         std::cout << "Resize " << e.window << " to " << Size<int>(e.width, e.height);
     }
@@ -449,7 +800,7 @@ namespace WM
         Frame(e.window, false /* was_created_before_window_manager */);
 
         // 2. Actually map window.
-        XMapWindow(m_connection, e.window);
+        m_backend->MapWindow(e.window);
 
     }
 
@@ -490,7 +841,10 @@ namespace WM
         // should have this attribute set to a frame window we maintain. Only an
         // UnmapNotify event triggered by reparenting a pre-existing window will have
         // this attribute set to the root window.
-        if (e.event == m_rootWindow)
+        //
+        // Clients managed in place stay children of the root window, all of
+        // their UnmapNotify events come from there.
+        if (e.event == m_rootWindow && m_clients[e.window].m_reparented)
         {
             std::cout << "Ignore UnmapNotify for reparented pre-existing window " << e.window;
             return;
@@ -506,148 +860,833 @@ namespace WM
 
     void WindowManager::OnButtonPress(const XButtonEvent& e)
     {
-        if(!(m_clients.count(e.window)))
+        // Input is dispatched ahead of structure events, the window may
+        // already be unframed.
+        const auto client = m_clients.find(e.window);
+        if (client == m_clients.end())
         {
-            throw std::runtime_error("There is no window!\n");
+            return;
         }
-
-        const Window frame = m_clients[e.window];
+        const Window frame = client->second.m_frame;
 
         // 1. Save initial cursor position.
         drag_start_pos_ = Position<int>(e.x_root, e.y_root);
 
-        // 2. Save initial window info.
-        Window returned_root;
-        int x, y;
-        unsigned width, height, border_width, depth;
-
-        if(XGetGeometry(m_connection, frame, &returned_root, &x, &y,
-                        &width, &height, &border_width, &depth) == BadDrawable)
+        // 2. Save initial window info. The placement holds the frame
+        // geometry, border included, so there is no need to ask the server.
+        const std::optional<Rect<int>> rect = m_placement.GetRect(frame);
+        if (!rect)
         {
-            throw std::runtime_error("Drawable argument does not name a defined Window or Pixmap!\n");
+            return;
         }
-        drag_start_frame_pos_ = Position<int>(x, y);
-        drag_start_frame_size_ = Size<int>(static_cast<int>(width), static_cast<int>(height));
+        const int border = 2 * static_cast<int>(m_config.m_borderWidth);
+        drag_start_frame_pos_ = Position<int>(rect->m_x, rect->m_y);
+        drag_start_frame_size_ = Size<int>(rect->m_width - border, rect->m_height - border);
+        m_dragFrameRect = Rect<int>(drag_start_frame_pos_, drag_start_frame_size_);
+        m_edges.Update(m_placement);
 
         // 3. Raise clicked window to top.
-        XRaiseWindow(m_connection, frame);
+        RaiseClient(e.window);
+
+        // 4. Follow the pointer with XInput2 if possible, for sub-pixel
+        // motion that can be thinned out per frame.
+        m_pointerGrabbed = m_backend->GrabPointerMotion(e.window, e.time);
     }
 
-    // Ignore button release
     void WindowManager::OnButtonRelease(const XButtonEvent& e)
     {
-
+        EndDrag(e.window);
     }
 
-    void WindowManager::OnMotionNotify(const XMotionEvent& e)
+    void WindowManager::OnPointerEvent(const PointerEvent& e)
     {
-        if(!(m_clients.count(e.window)))
+        if (e.m_type == XI_Motion)
         {
-            throw std::runtime_error("There is no window!\n");
+            if (m_motion.Push(e, MotionCompressor::Clock::now()))
+            {
+                DragTo(e.m_window, e.m_rootX, e.m_rootY, e.m_state);
+            }
         }
-        const Window frame = m_clients[e.window];
-        const Position<int> drag_pos(e.x_root, e.y_root);
-        const Vector2D<int> delta = drag_pos - drag_start_pos_;
-
-        if (e.state & Button1Mask )
+        else if (e.m_type == XI_ButtonRelease)
         {
-            // alt + left button: Move window.
-            const Position<int> dest_frame_pos = drag_start_frame_pos_ + delta;
-            XMoveWindow(
-            m_connection,
-            frame,
-            dest_frame_pos.m_x, dest_frame_pos.m_y);
+            // Catch up with the last position before letting go.
+            if (const std::optional<PointerEvent> pending = m_motion.TakePending(e.m_device))
+            {
+                DragTo(pending->m_window, pending->m_rootX, pending->m_rootY, pending->m_state);
+            }
+            EndDrag(e.m_window);
         }
-        else if (e.state & Button3Mask)
-        {
-            // alt + right button: Resize window.
-            // Window dimensions cannot be negative.
-            const Vector2D<int> size_delta(
-            std::max(delta.m_x, -drag_start_frame_size_.m_width),
-            std::max(delta.m_y, -drag_start_frame_size_.m_height));
-            const Size<int> dest_frame_size = drag_start_frame_size_ + size_delta;
-            // 1. Resize frame.
-            XResizeWindow(m_connection, frame,
-                        static_cast<unsigned int>(dest_frame_size.m_width),
-                        static_cast<unsigned int>(dest_frame_size.m_height));
+    }
 
-            // 2. Resize client window.
-            XResizeWindow(m_connection, e.window,
-                        static_cast<unsigned int>(dest_frame_size.m_width),
-                        static_cast<unsigned int>(dest_frame_size.m_height));
+    void WindowManager::DeliverConfigures()
+    {
+        for (const XConfigureRequestEvent& e : m_configureThrottle.TakeDue(ConfigureThrottle::Clock::now()))
+        {
+            // Held back requests of clients since unframed were dropped.
+            ApplyConfigureRequest(e);
         }
     }
 
-    void WindowManager::OnKeyPress(const XKeyEvent& e)
+    void WindowManager::OnEnterNotify(const XCrossingEvent& e)
     {
-        if ((e.state & Mod1Mask) && (e.keycode == XKeysymToKeycode(m_connection, XK_F4)))
+        // Crossings from a child, or caused by grabs, don't move the pointer
+        // to another frame. Neither does a move/resize or the switcher.
+        if (m_config.m_focusMode != FocusMode::Mouse || e.detail == NotifyInferior || e.mode != NotifyNormal ||
+            m_pointerGrabbed || m_switcher.IsOpen())
         {
-            // alt + f4: Close window.
-            //
-            // There are two ways to tell an X window to close. The first is to send it
-            // a message of type WM_PROTOCOLS and value WM_DELETE_WINDOW. If the client
-            // has not explicitly marked itself as supporting this more civilized
-            // behavior (using XSetWMProtocols()), we kill it with XKillClient().
-            Atom* supported_protocols;
+            return;
+        }
+        m_focusSettle.Push(Position<int>(e.x_root, e.y_root), FocusSettle::Clock::now());
+    }
 
-            int num_supported_protocols;
+    void WindowManager::OnPropertyNotify(const XPropertyEvent& e)
+    {
+        if (!m_clients.count(e.window))
+        {
+            return;
+        }
 
-            if (XGetWMProtocols(m_connection, e.window, &supported_protocols,
-                    &num_supported_protocols) && (::std::find(supported_protocols,
-                    supported_protocols + num_supported_protocols, WM_DELETE_WINDOW) !=
-                    supported_protocols + num_supported_protocols))
+        // A new icon is decoded like the first one.
+        if (e.atom == NET_WM_ICON)
+        {
+            if (m_iconLoader && m_clients[e.window].m_reparented)
             {
-                std::cout << "Gracefully deleting window " << e.window;
+                m_iconLoader->Request(e.window);
+            }
+            return;
+        }
 
-                // 1. Construct message.
-                XEvent msg;
-                std::memset(&msg, 0, sizeof(msg));
-                msg.xclient.type = ClientMessage;
-                msg.xclient.message_type = WM_PROTOCOLS;
-                msg.xclient.window = e.window;
-                msg.xclient.format = 32;
-                msg.xclient.data.l[0] = static_cast<long>(WM_DELETE_WINDOW);
+        // Re-read it with the others changed in the same run of events.
+        if (ClientProperties::IsCached(m_propertyAtoms, e.atom) &&
+            std::find(m_staleProperties.begin(), m_staleProperties.end(), std::pair{e.window, e.atom}) == m_staleProperties.end())
+        {
+            m_staleProperties.emplace_back(e.window, e.atom);
+        }
+    }
 
-                // 2. Send message to window to be closed.
+    void WindowManager::RefreshProperties()
+    {
+        if (m_staleProperties.empty())
+        {
+            return;
+        }
 
-                //TODO: Check for BadValue
-                if(XSendEvent(m_connection, e.window, false, 0, &msg) == BadWindow)
-                {
-                    throw std::runtime_error("We can't send close message to the window!");
-                }
-            }
-            else
+        std::vector<PropertyRequest> requests;
+        for (const auto& [w, property] : m_staleProperties)
+        {
+            for (const PropertyRequest& request : ClientProperties::GetRequests(m_propertyAtoms, w, {property}))
             {
-                std::cout << "Killing window " << e.window;
-                XKillClient(m_connection, e.window);
+                requests.push_back(request);
             }
         }
-        else if ((e.state & Mod1Mask) && (e.keycode == XKeysymToKeycode(m_connection, XK_Tab)))
-        {
-            // alt + tab: Switch window.
-            // 1. Find next window.
-            auto i = m_clients.find(e.window);
+        m_staleProperties.clear();
 
-            if(i == m_clients.end())
+        const std::vector<PropertyReply> replies = m_backend->GetProperties(requests);
+        for (std::size_t i = 0; i < requests.size(); ++i)
+        {
+            // The client may have gone since the notify.
+            const auto client = m_clients.find(requests[i].m_window);
+            if (client != m_clients.end())
             {
-                throw std::runtime_error("We can't find The window!\n");
+                client->second.m_properties.Store(m_propertyAtoms, requests[i].m_property, replies[i]);
+                ++m_propertyRefreshCount;
             }
-            ++i;
+        }
+    }
 
-            if (i == m_clients.end())
-            {
-                i = m_clients.begin();
-            }
-            // 2. Raise and set focus.
-            XRaiseWindow(m_connection, i->second);
-            XSetInputFocus(m_connection, i->first, RevertToPointerRoot, CurrentTime);
+    void WindowManager::DeliverFocus()
+    {
+        const std::optional<Position<int>> pos = m_focusSettle.TakeDue(FocusSettle::Clock::now());
+        if (!pos)
+        {
+            return;
+        }
+
+        // The pointer rests in the topmost frame under it, which may not be
+        // the one last crossed into.
+        m_hitIndex.Update(m_placement);
+        const auto frame = m_frames.find(m_hitIndex.FindTopmost(*pos));
+        if (frame != m_frames.end() && frame->second != m_focusedClient)
+        {
+            FocusClient(frame->second);
         }
     }
 
-    // Ignore key release events
-    void WindowManager::OnKeyRelease(const XKeyEvent& e)
+    void WindowManager::DeliverMotion()
     {
+        std::vector<PointerEvent> due;
+        m_motion.TakeDue(MotionCompressor::Clock::now(), due);
+        for (const PointerEvent& e : due)
+        {
+            DragTo(e.m_window, e.m_rootX, e.m_rootY, e.m_state);
+        }
+    }
+
+    void WindowManager::EndDrag(Window w)
+    {
+        if (m_pointerGrabbed)
+        {
+            m_backend->UngrabPointerMotion(CurrentTime);
+            m_pointerGrabbed = false;
+        }
+
+        // The frame has stopped moving, update the placement once.
+        const auto client = m_clients.find(w);
+        if (client == m_clients.end() || m_dragFrameRect.IsEmpty())
+        {
+            return;
+        }
+
+        // The geometry from XGetGeometry excludes the border.
+        const int border = 2 * static_cast<int>(m_config.m_borderWidth);
+        m_placement.Move(client->second.m_frame,
+                         Rect<int>(m_dragFrameRect.m_x, m_dragFrameRect.m_y,
+                                   m_dragFrameRect.m_width + border, m_dragFrameRect.m_height + border));
+        m_dragFrameRect = Rect<int>();
+    }
+
+    void WindowManager::OnMotionNotify(const XMotionEvent& e)
+    {
+        DragTo(e.window, e.x_root, e.y_root, e.state);
+    }
+
+    void WindowManager::DragTo(Window w, double root_x, double root_y, unsigned int state)
+    {
+        const auto client = m_clients.find(w);
+        if (client == m_clients.end())
+        {
+            return;
+        }
+        const Window frame = client->second.m_frame;
+        // Round once here, so sub-pixel motion never adds up to an error.
+        const Vector2D<int> delta(static_cast<int>(std::lround(root_x - drag_start_pos_.m_x)),
+                                  static_cast<int>(std::lround(root_y - drag_start_pos_.m_y)));
+
+        // Snapping works on the outer geometry, border included.
+        const int border = 2 * static_cast<int>(m_config.m_borderWidth);
+        const Vector2D<int> border_size(border, border);
+        const int snap_distance = static_cast<int>(m_config.m_snapDistance);
+        m_edges.Update(m_placement);
+
+        if (state & Button1Mask )
+        {
+            // alt + left button: Move window, snapping to nearby edges.
+            const Rect<int> outer(drag_start_frame_pos_ + delta, drag_start_frame_size_ + border_size);
+            const Position<int> dest_frame_pos = m_edges.SnapPosition(outer, frame, snap_distance);
+            m_backend->MoveWindow(frame, dest_frame_pos.m_x, dest_frame_pos.m_y);
+            m_dragFrameRect = Rect<int>(dest_frame_pos, drag_start_frame_size_);
+        }
+        else if (state & Button3Mask)
+        {
+            // alt + right button: Resize window.
+            // Window dimensions cannot be negative.
+            const Vector2D<int> size_delta(
+            std::max(delta.m_x, -drag_start_frame_size_.m_width),
+            std::max(delta.m_y, -drag_start_frame_size_.m_height));
+            const Rect<int> outer(drag_start_frame_pos_, drag_start_frame_size_ + size_delta + border_size);
+            const Size<int> snapped = m_edges.SnapSize(outer, frame, snap_distance);
+            const Size<int> dest_frame_size(std::max(1, snapped.m_width - border), std::max(1, snapped.m_height - border));
+            m_dragFrameRect = Rect<int>(drag_start_frame_pos_, dest_frame_size);
+
+            // 1. Resize frame.
+            m_backend->ResizeWindow(frame,
+                        static_cast<unsigned int>(dest_frame_size.m_width),
+                        static_cast<unsigned int>(dest_frame_size.m_height));
+
+            // 2. Resize client window, below the title bar.
+            if (client->second.m_reparented)
+            {
+                m_backend->ResizeWindow(w,
+                            static_cast<unsigned int>(dest_frame_size.m_width),
+                            static_cast<unsigned int>(std::max(1, dest_frame_size.m_height - static_cast<int>(TITLE_BAR_HEIGHT))));
+            }
+        }
+    }
+
+    void WindowManager::OnKeyPress(const XKeyEvent& e)
+    {
+        const unsigned int modifiers = e.state & ~IGNORED_MODIFIERS;
+
+        for (const KeyBinding& binding : m_config.m_keyBindings)
+        {
+            if (binding.m_modifiers != modifiers || e.keycode != m_backend->KeysymToKeycode(binding.m_keysym))
+            {
+                continue;
+            }
+
+            // The switcher has the keyboard, only switching means something.
+            if (m_switcher.IsOpen())
+            {
+                if (binding.m_action == KeyAction::SwitchNext)
+                {
+                    SelectNextInSwitcher();
+                }
+                return;
+            }
+
+            switch (binding.m_action)
+            {
+                case KeyAction::Close:
+                    CloseClient(e.window);
+                break;
+
+                case KeyAction::SwitchNext:
+                    if (!m_thumbnailer || !OpenSwitcher(e.window, e.time))
+                    {
+                        SwitchToNext(e.window);
+                    }
+                break;
+            }
+            return;
+        }
+    }
+
+    void WindowManager::CloseClient(Window w)
+    {
+        // Close window.
+        //
+        // There are two ways to tell an X window to close. The first is to send it
+        // a message of type WM_PROTOCOLS and value WM_DELETE_WINDOW. If the client
+        // has not explicitly marked itself as supporting this more civilized
+        // behavior (using XSetWMProtocols()), we kill it with XKillClient().
+        const auto client = m_clients.find(w);
+        if (client == m_clients.end())
+        {
+            return;
+        }
+        const std::vector<Atom>& supported_protocols = client->second.m_properties.m_protocols;
+
+        if (std::find(supported_protocols.begin(), supported_protocols.end(), WM_DELETE_WINDOW) !=
+                supported_protocols.end())
+        {
+            std::cout << "Gracefully deleting window " << w;
+
+            // 1. Construct message.
+            XEvent msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.xclient.type = ClientMessage;
+            msg.xclient.message_type = WM_PROTOCOLS;
+            msg.xclient.window = w;
+            msg.xclient.format = 32;
+            msg.xclient.data.l[0] = static_cast<long>(WM_DELETE_WINDOW);
+
+            // 2. Send message to window to be closed.
+
+            //TODO: Check for BadValue
+            if(!m_backend->SendEvent(w, 0, msg))
+            {
+                throw std::runtime_error("We can't send close message to the window!");
+            }
+        }
+        else
+        {
+            std::cout << "Killing window " << w;
+            m_backend->KillClient(w);
+        }
+    }
+
+    void WindowManager::SwitchToNext(Window w)
+    {
+        // Switch window.
+        // 1. Find next window.
+        auto i = m_clients.find(w);
+
+        if(i == m_clients.end())
+        {
+            throw std::runtime_error("We can't find The window!\n");
+        }
+        ++i;
+
+        if (i == m_clients.end())
+        {
+            i = m_clients.begin();
+        }
+        // 2. Raise and set focus.
+        RaiseClient(i->first);
+        FocusClient(i->first);
+    }
+
+    void WindowManager::OnKeyRelease(const XKeyEvent& e)
+    {
+        if (!m_switcher.IsOpen())
+        {
+            return;
+        }
+
+        // Releasing anything but a switching key, i.e. its modifiers, picks
+        // the selected client.
+        for (const KeyBinding& binding : m_config.m_keyBindings)
+        {
+            if (binding.m_action == KeyAction::SwitchNext && e.keycode == m_backend->KeysymToKeycode(binding.m_keysym))
+            {
+                return;
+            }
+        }
+
+        const Window selected = m_switcher.GetSelected();
+        CloseSwitcher(e.time);
+        if (selected != None)
+        {
+            RaiseClient(selected);
+            FocusClient(selected);
+        }
+    }
+
+    bool WindowManager::OpenSwitcher(Window w, Time time)
+    {
+        auto i = m_clients.find(w);
+        if (i == m_clients.end() || !m_backend->GrabKeyboard(m_rootWindow, time))
+        {
+            return false;
+        }
+
+        // 1. Clients in switching order, starting with w.
+        std::vector<Window> clients;
+        clients.reserve(m_clients.size());
+        for (std::size_t n = 0; n < m_clients.size(); ++n)
+        {
+            clients.push_back(i->first);
+            if (++i == m_clients.end())
+            {
+                i = m_clients.begin();
+            }
+        }
+
+        // 2. Lay them out on the first output.
+        int root_x = 0, root_y = 0;
+        unsigned int root_width = 0, root_height = 0;
+        const std::vector<Rect<int>>& outputs = m_placement.GetOutputs();
+        if (outputs.empty())
+        {
+            m_backend->GetGeometry(m_rootWindow, root_x, root_y, root_width, root_height);
+        }
+        const Rect<int> output = outputs.empty()
+            ? Rect<int>(root_x, root_y, static_cast<int>(root_width), static_cast<int>(root_height))
+            : outputs.front();
+        m_switcher.Open(clients, output);
+
+        // 3. Show the overlay, drawn once exposed. It's ours, so mapping it
+        // isn't redirected to us.
+        const Rect<int>& bounds = m_switcher.GetBounds();
+        if (m_switcherWindow == None)
+        {
+            m_switcherWindow = m_backend->CreateSimpleWindow(m_rootWindow, bounds.m_x, bounds.m_y,
+                                                             static_cast<unsigned int>(bounds.m_width),
+                                                             static_cast<unsigned int>(bounds.m_height),
+                                                             0, m_config.m_borderColor, m_config.m_backgroundColor);
+            m_switcherMarker = m_backend->CreateSimpleWindow(m_switcherWindow, 0, 0, THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT,
+                                                             SWITCHER_MARKER_WIDTH, m_config.m_borderColor,
+                                                             m_config.m_backgroundColor);
+            m_backend->SelectInput(m_switcherWindow, ExposureMask);
+            m_backend->SelectInput(m_switcherMarker, ExposureMask);
+            m_backend->MapWindow(m_switcherMarker);
+        }
+        else
+        {
+            XWindowChanges changes;
+            changes.x = bounds.m_x;
+            changes.y = bounds.m_y;
+            changes.width = bounds.m_width;
+            changes.height = bounds.m_height;
+            m_backend->ConfigureWindow(m_switcherWindow, CWX | CWY | CWWidth | CWHeight, changes);
+        }
+        m_backend->MapWindow(m_switcherWindow);
+        m_backend->RaiseWindow(m_switcherWindow);
+
+        // 4. Render thumbnails of what changed since last time, the
+        // selection first.
+        std::vector<Window> order{m_switcher.GetSelected()};
+        order.insert(order.end(), clients.begin(), clients.end());
+        m_thumbnailer->Show(std::move(order));
+        return true;
+    }
+
+    void WindowManager::CloseSwitcher(Time time)
+    {
+        m_switcher.Close();
+        m_thumbnailer->Hide();
+        m_backend->UnmapWindow(m_switcherWindow);
+        m_backend->UngrabKeyboard(time);
+    }
+
+    void WindowManager::SelectNextInSwitcher()
+    {
+        // Scrolling redraws everything once exposed, otherwise only the
+        // marker moves; what it uncovers is exposed.
+        if (m_switcher.Next())
+        {
+            m_backend->ClearWindow(m_switcherWindow);
+        }
+        DrawThumbnail(m_switcher.GetSelectedIndex());
+    }
+
+    void WindowManager::DrawSwitcher()
+    {
+        for (std::size_t i = 0; i < m_switcher.GetClients().size(); ++i)
+        {
+            DrawThumbnail(i);
+        }
+    }
+
+    void WindowManager::DrawThumbnail(std::size_t i)
+    {
+        const std::optional<Position<int>> position = m_switcher.GetCellPosition(i);
+        if (!position)
+        {
+            return;
+        }
+
+        // The selected thumbnail is drawn in the marker, which sits on its
+        // cell.
+        const bool selected = i == m_switcher.GetSelectedIndex();
+        if (selected)
+        {
+            m_backend->MoveWindow(m_switcherMarker, position->m_x - static_cast<int>(SWITCHER_MARKER_WIDTH),
+                                  position->m_y - static_cast<int>(SWITCHER_MARKER_WIDTH));
+        }
+
+        const Window client = m_switcher.GetClients()[i];
+        const Pixmap thumbnail = m_clients[client].m_thumbnail;
+        if (thumbnail != None)
+        {
+            m_backend->CopyArea(thumbnail, selected ? m_switcherMarker : m_switcherWindow, 0, 0,
+                                THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT,
+                                selected ? 0 : position->m_x, selected ? 0 : position->m_y);
+        }
+    }
+
+    void WindowManager::OnThumbnailsReady()
+    {
+        for (const Thumbnailer::Update& update : m_thumbnailer->TakeUpdates())
+        {
+            // The client may have gone while its thumbnail was rendered.
+            const auto client = m_clients.find(update.m_client);
+            if (client == m_clients.end())
+            {
+                continue;
+            }
+
+            client->second.m_thumbnail = update.m_pixmap;
+            if (const std::optional<std::size_t> i = m_switcher.Find(update.m_client))
+            {
+                DrawThumbnail(*i);
+            }
+        }
+    }
+
+    void WindowManager::OnExpose(const XExposeEvent& e)
+    {
+        // Only redraw once the last expose of a series arrives.
+        if (e.count != 0)
+        {
+            return;
+        }
+
+        if (e.window == m_switcherWindow || e.window == m_switcherMarker)
+        {
+            if (m_switcher.IsOpen())
+            {
+                DrawSwitcher();
+            }
+            return;
+        }
+
+        const auto i = m_frames.find(e.window);
+        if (i == m_frames.end())
+        {
+            return;
+        }
+        DrawTitleBar(m_clients[i->second]);
+    }
+
+    void WindowManager::DrawTitleBar(const Client& client)
+    {
+        if (!client.m_icon)
+        {
+            return;
+        }
+
+        const unsigned int size = client.m_icon->GetSize();
+        m_backend->CopyArea(client.m_icon->GetPixmap(), client.m_frame,
+                            0, 0, size, size, TITLE_BAR_PADDING, TITLE_BAR_PADDING);
+    }
+
+    void WindowManager::OnIconsReady()
+    {
+        for (IconLoader::Result& result : m_iconLoader->TakeResults())
+        {
+            // The client may have gone away while its icon was decoded.
+            const auto i = m_clients.find(result.m_client);
+            if (i == m_clients.end() || !result.m_icon)
+            {
+                continue;
+            }
+
+            i->second.m_icon = std::move(result.m_icon);
+            DrawTitleBar(i->second);
+        }
+    }
+
+    std::optional<Position<int>> WindowManager::PlaceFrame(const ClientProperties& properties, const XWindowAttributes& attrs)
+    {
+        // 1. Respect positions set by the user or the program.
+        if (properties.m_normalHintsFlags & (USPosition | PPosition))
+        {
+            return std::nullopt;
+        }
+
+        // 2. Place the whole frame, title bar and border included.
+        const int border = 2 * static_cast<int>(m_config.m_borderWidth);
+        const Size<int> frame_size(attrs.width + border,
+                                   attrs.height + GetTitleBarHeight(m_config.m_frameMode == FrameMode::Reparent) + border);
+        return m_placement.Place(frame_size, Position<int>(attrs.x, attrs.y));
+    }
+
+    void WindowManager::ApplyRules(Window w, Client& client)
+    {
+        const RuleSet& rules = m_settings->m_rules;
+        if (rules.GetSize() == 0)
+        {
+            return;
+        }
+
+        client.m_actions = rules.Match(client.m_properties.GetIdentity());
+
+        // Advertise the workspace to pagers and the client.
+        if (client.m_actions.m_workspace)
+        {
+            const long desktop = *client.m_actions.m_workspace;
+            m_backend->ChangeProperty(w, NET_WM_DESKTOP, XA_CARDINAL, 32,
+                                      reinterpret_cast<const unsigned char*>(&desktop), 1);
+        }
+
+        if (client.m_actions.m_above)
+        {
+            m_aboveClients.insert(w);
+            m_backend->RaiseWindow(client.m_frame);
+        }
+        else
+        {
+            // New windows are mapped on top, put the ones marked above back.
+            RaiseClient(w);
+        }
+    }
+
+    void WindowManager::RaiseClient(Window w)
+    {
+        m_backend->RaiseWindow(m_clients[w].m_frame);
+        m_hitIndex.Raise(m_clients[w].m_frame);
+
+        if (m_aboveClients.count(w))
+        {
+            return;
+        }
+
+        for (const Window above : m_aboveClients)
+        {
+            m_backend->RaiseWindow(m_clients[above].m_frame);
+            m_hitIndex.Raise(m_clients[above].m_frame);
+        }
+    }
+
+    void WindowManager::FocusClient(Window w)
+    {
+        // Focus given otherwise overrides where the pointer was going.
+        m_focusSettle.Cancel();
+        m_backend->SetInputFocus(w);
+        m_focusedClient = w;
+        ++m_focusChangeCount;
+    }
+
+    void WindowManager::GrabKeys(Window w, const std::vector<KeyBinding>& bindings)
+    {
+        for (const KeyBinding& binding : bindings)
+        {
+            m_backend->GrabKey(m_backend->KeysymToKeycode(binding.m_keysym), binding.m_modifiers, w);
+        }
+    }
+
+    void WindowManager::UngrabKeys(Window w, const std::vector<KeyBinding>& bindings)
+    {
+        for (const KeyBinding& binding : bindings)
+        {
+            m_backend->UngrabKey(m_backend->KeysymToKeycode(binding.m_keysym), binding.m_modifiers, w);
+        }
+    }
+
+    void WindowManager::PrintStats(std::ostream& out) const
+    {
+        const std::size_t takes = m_framePool.GetHitCount() + m_framePool.GetMissCount();
+        const double hit_rate = takes ? 100.0 * static_cast<double>(m_framePool.GetHitCount()) / static_cast<double>(takes) : 0.0;
+
+        out << "Stats:\n"
+            << "  clients: " << m_clients.size() << '\n'
+            << "  frame pool: " << m_framePool.GetSize() << " frames, "
+            << m_framePool.GetHitCount() << " hits, " << m_framePool.GetMissCount() << " misses ("
+            << hit_rate << "% hit rate), " << m_framePool.GetOverflowCount() << " overflowed, "
+            << m_framePool.GetTrimmedCount() << " trimmed\n"
+            << "  pointer motion: " << m_motion.GetPushedCount() << " samples, "
+            << m_motion.GetDeliveredCount() << " applied\n"
+            << "  events: " << m_scheduler.GetDispatchedCount(EventClass::Input) << " input, "
+            << m_scheduler.GetDispatchedCount(EventClass::Structure) << " structure, "
+            << m_scheduler.GetDispatchedCount(EventClass::Cosmetic) << " cosmetic, "
+            << m_scheduler.GetCoalescedCount() << " motion coalesced, "
+            << m_scheduler.GetStarvedCount() << " starved, " << m_scheduler.GetMaxQueued() << " most queued\n"
+            << "  focus: " << m_focusSettle.GetPushedCount() << " crossings, "
+            << m_focusSettle.GetSettledCount() << " settled, " << m_focusChangeCount << " changes\n"
+            << "  properties: " << m_propertyRefreshCount << " refreshed on change\n";
+
+        // Clients asking to be configured faster than the throttle allows.
+        const std::vector<ThrottleStats> offenders = m_configureThrottle.GetOffenders();
+        out << "  configure requests: " << m_configureThrottle.GetGrantedCount() << " granted, "
+            << m_configureThrottle.GetCollapsedCount() << " collapsed, " << offenders.size() << " throttled clients\n";
+        for (std::size_t i = 0; i < std::min<std::size_t>(offenders.size(), 5); ++i)
+        {
+            out << "    0x" << std::hex << offenders[i].m_window << std::dec << ": "
+                << offenders[i].m_requestCount << " requests, " << offenders[i].m_collapsedCount << " collapsed\n";
+        }
+
+        // Clients holding the most pixmap memory, with its growth over the
+        // samples kept, which is what gives a leak away.
+        std::vector<std::pair<Window, const ResourceHistory*>> sampled;
+        for (const auto& [w, client] : m_clients)
+        {
+            if (!client.m_resources.IsEmpty())
+            {
+                sampled.emplace_back(w, &client.m_resources);
+            }
+        }
+        const std::size_t num_top = std::min<std::size_t>(sampled.size(), 5);
+        std::partial_sort(sampled.begin(), sampled.begin() + static_cast<std::ptrdiff_t>(num_top), sampled.end(),
+                          [](const auto& a, const auto& b)
+                          {
+                              return a.second->GetLatest().m_pixmapBytes > b.second->GetLatest().m_pixmapBytes;
+                          });
+
+        out << "  resources, top " << num_top << " by pixmap memory:\n";
+        for (std::size_t i = 0; i < num_top; ++i)
+        {
+            const ResourceHistory& history = *sampled[i].second;
+            const ResourceSample& latest = history.GetLatest();
+            const auto span = std::chrono::duration_cast<std::chrono::seconds>(latest.m_time - history.GetOldest().m_time);
+            out << "    0x" << std::hex << sampled[i].first << std::dec << ": "
+                << latest.m_pixmapBytes / 1024 << " KiB in " << latest.m_pixmapCount << " pixmaps ("
+                << std::showpos << history.GetPixmapGrowth() / 1024 << std::noshowpos << " KiB over "
+                << span.count() << " s), " << latest.m_resourceCount << " resources\n";
+        }
+        out.flush();
+    }
+
+    void WindowManager::SampleResources()
+    {
+        const auto now = ResourceSampler::Clock::now();
+        const std::optional<ResourceSampler::Clock::duration> timeout =
+            m_resourceSampler ? m_resourceSampler->GetTimeout(now) : std::nullopt;
+        if (!timeout || *timeout > ResourceSampler::Clock::duration::zero())
+        {
+            return;
+        }
+
+        std::vector<Window> windows;
+        windows.reserve(m_clients.size());
+        for (const auto& [w, client] : m_clients)
+        {
+            windows.push_back(w);
+        }
+        m_resourceSampler->Request(windows, now);
+    }
+
+    void WindowManager::OnResourcesReady()
+    {
+        for (const auto& [w, sample] : m_resourceSampler->Collect())
+        {
+            // The client may have gone while its queries were out.
+            const auto client = m_clients.find(w);
+            if (client != m_clients.end())
+            {
+                client->second.m_resources.Push(sample);
+            }
+        }
+    }
+
+    void WindowManager::OnSettingsChanged()
+    {
+        m_settingsGeneration = m_sharedSettings->GetGeneration();
+        m_settings = m_sharedSettings->Get();
+
+        const ConfigDiff diff = Diff(m_config, m_settings->m_config);
+        if (diff.IsEmpty())
+        {
+            return;
+        }
+
+        const Config previous = std::exchange(m_config, m_settings->m_config);
+        ApplyConfigDiff(diff, previous);
+        std::cout << "Reloaded the settings\n";
+    }
+
+    void WindowManager::ApplyConfigDiff(const ConfigDiff& diff, const Config& previous)
+    {
+        // Only what changed is sent, for every client, and flushed once at
+        // the end. Clients stay in their frames.
+
+        // Pooled frames would come back with the old look, drop them.
+        if (diff.m_borderWidth || diff.m_borderColor || diff.m_backgroundColor)
+        {
+            for (const Window frame : m_framePool.TakeAll())
+            {
+                m_backend->DestroyWindow(frame);
+            }
+        }
+
+        for (const auto& [w, client] : m_clients)
+        {
+            if (diff.m_borderWidth)
+            {
+                m_backend->SetWindowBorderWidth(client.m_frame, m_config.m_borderWidth);
+
+                // The placement holds outer sizes, the frame grows or
+                // shrinks by the border on each side.
+                if (std::optional<Rect<int>> rect = m_placement.GetRect(client.m_frame))
+                {
+                    const int delta = 2 * (static_cast<int>(m_config.m_borderWidth) - static_cast<int>(previous.m_borderWidth));
+                    rect->m_width += delta;
+                    rect->m_height += delta;
+                    m_placement.Move(client.m_frame, *rect);
+                }
+            }
+
+            if (diff.m_borderColor)
+            {
+                m_backend->SetWindowBorder(client.m_frame, m_config.m_borderColor);
+            }
+
+            // Clients managed in place have no background of ours.
+            if (diff.m_backgroundColor && client.m_reparented)
+            {
+                // Clearing with exposures redraws the title bar.
+                m_backend->SetWindowBackground(client.m_frame, m_config.m_backgroundColor);
+                m_backend->ClearWindow(client.m_frame);
+            }
+
+            UngrabKeys(w, diff.m_removedKeys);
+            GrabKeys(w, diff.m_addedKeys);
+        }
+
+        // Icons are flattened onto the background, decode them again.
+        if (diff.m_backgroundColor && m_iconLoader)
+        {
+            m_iconLoader->SetBackground(static_cast<std::uint32_t>(m_config.m_backgroundColor));
+            for (const auto& [w, client] : m_clients)
+            {
+                if (client.m_reparented)
+                {
+                    m_iconLoader->Request(w);
+                }
+            }
+        }
 
+        m_backend->Flush();
     }
 
 }
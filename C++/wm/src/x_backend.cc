@@ -0,0 +1,21 @@
+#include "x_backend.h"
+
+
+namespace WM
+{
+    std::string PropertyReply::AsString() const
+    {
+        if (m_format != 8)
+        {
+            return std::string{};
+        }
+
+        // Drop a trailing NUL, some clients include it.
+        std::string value(m_data.begin(), m_data.end());
+        while (!value.empty() && value.back() == '\0')
+        {
+            value.pop_back();
+        }
+        return value;
+    }
+}
@@ -0,0 +1,51 @@
+#include "xcb_request.h"
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/uio.h>
+
+extern "C"
+{
+    #include <xcb/xcb.h>
+    #include <xcb/xcbext.h>
+}
+
+
+namespace WM::Xcb
+{
+    unsigned int SendRequest(xcb_connection_t* connection, xcb_extension_t* extension, std::uint8_t minor_opcode,
+                             void* request, std::size_t length, bool has_reply)
+    {
+        // xcb_send_request wants two spare iovecs in front.
+        iovec parts[4];
+        parts[2].iov_base = request;
+        parts[2].iov_len = length;
+        parts[3].iov_base = nullptr;
+        parts[3].iov_len = 0;
+
+        const xcb_protocol_request_t protocol{2, extension, minor_opcode, static_cast<std::uint8_t>(!has_reply)};
+        return xcb_send_request(connection, has_reply ? XCB_REQUEST_CHECKED : 0, parts + 2, &protocol);
+    }
+
+    bool PollReply(xcb_connection_t* connection, unsigned int request, unsigned char*& reply)
+    {
+        void* data = nullptr;
+        xcb_generic_error_t* error = nullptr;
+        if (!xcb_poll_for_reply(connection, request, &data, &error))
+        {
+            return false;
+        }
+
+        // Errors are expected, windows may be gone.
+        std::free(error);
+        reply = static_cast<unsigned char*>(data);
+        return true;
+    }
+
+    std::uint32_t ReadCard32(const unsigned char* data, std::size_t offset)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data + offset, sizeof(value));
+        return value;
+    }
+}
@@ -0,0 +1,510 @@
+#include "xlib_backend.h"
+#include "util.h"
+#include <iostream>
+#include <stdexcept>
+
+#include <X11/Xutil.h>
+
+#ifdef WM_HAVE_XI2
+#include <X11/extensions/XInput2.h>
+#endif
+
+#ifdef WM_HAVE_XLIB_XCB
+#include <X11/Xlib-xcb.h>
+#endif
+
+
+namespace WM
+{
+    // Init static member
+    std::mutex XlibBackend::m_backendsMutex{};
+    std::unordered_map<Display*, XlibBackend*> XlibBackend::m_backends{};
+
+    namespace
+    {
+        // Opens the connection to the X server.
+        Display* OpenDisplay(const std::string& displayName)
+        {
+            //Check if display is specified
+            const char* display_c_str = displayName.empty() ? nullptr : displayName.c_str();
+
+            Display* connection = XOpenDisplay(display_c_str);
+
+            if (connection == nullptr)
+            {
+                throw std::runtime_error("Failed to open X display " + std::string{XDisplayName(display_c_str)});
+            }
+
+            return connection;
+        }
+
+        // Property batches share the connection of the display if they can,
+        // so they are sent after whatever Xlib has buffered.
+        std::unique_ptr<PropertyFetcher> MakePropertyFetcher(Display* connection)
+        {
+#ifdef WM_HAVE_XLIB_XCB
+            return std::make_unique<PropertyFetcher>(XGetXCBConnection(connection));
+#else
+            return std::make_unique<PropertyFetcher>(XDisplayString(connection));
+#endif
+        }
+    }
+
+    XlibBackend::XlibBackend(const std::string& displayName)
+        :     m_connection{OpenDisplay(displayName)},
+              // Return the default root window for a given X server
+              m_rootWindow{DefaultRootWindow(m_connection)},
+              m_gc{XCreateGC(m_connection, m_rootWindow, 0, nullptr)},
+              m_propertyFetcher{MakePropertyFetcher(m_connection)}
+    {
+        // Errors are routed to the backend of their display, the handler is
+        // set once for the whole process.
+        {
+            std::lock_guard<std::mutex> lock(m_backendsMutex);
+            if (m_backends.empty())
+            {
+                XSetErrorHandler(&XlibBackend::OnXError);
+            }
+            m_backends[m_connection] = this;
+        }
+
+#ifdef WM_HAVE_XI2
+        // Drags use XInput 2 when the server has it.
+        int event, error;
+        int major = 2, minor = 0;
+        if (!XQueryExtension(m_connection, "XInputExtension", &m_xiOpcode, &event, &error)
+            || XIQueryVersion(m_connection, &major, &minor) != Success)
+        {
+            m_xiOpcode = -1;
+        }
+#endif
+    }
+
+    XlibBackend::~XlibBackend()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_backendsMutex);
+            m_backends.erase(m_connection);
+        }
+
+        XFreeGC(m_connection, m_gc);
+        // Close the connection with X server
+        XCloseDisplay(m_connection);
+    }
+
+    std::optional<std::string> XlibBackend::GetDisplayName() const
+    {
+        return std::string{XDisplayString(m_connection)};
+    }
+
+    Atom XlibBackend::InternAtom(const std::string& name)
+    {
+        return XInternAtom(m_connection, name.c_str(), false);
+    }
+
+    void XlibBackend::RedirectRoot(long event_mask)
+    {
+        // Watch for BadAccess so we can exit gracefully if another window
+        // manager is already running.
+        m_wmDetected = false;
+        m_redirectingRoot = true;
+
+        // Take control over the root window
+        //            server,  window, events
+        XSelectInput(m_connection, m_rootWindow, event_mask);
+
+          /* XSelectInput doesn't  send a request to the X server,
+           *
+           * instead only queues the request and returns
+           * we have to explicitly flush the request queue with XSync
+           *
+           * False means that XSync  will not discard the events
+           * */
+        XSync(m_connection, false);
+        m_redirectingRoot = false;
+        if (m_wmDetected)
+        {
+            throw std::runtime_error("Detected another window manager on display " +
+                    std::string{XDisplayString(m_connection)});
+        }
+    }
+
+    int XlibBackend::OnXError(Display* display, XErrorEvent* e)
+    {
+        // Errors are delivered on the thread that reads the connection, the
+        // lock only guards the map against displays coming and going.
+        XlibBackend* backend = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_backendsMutex);
+            const auto i = m_backends.find(display);
+            if (i != m_backends.end())
+            {
+                backend = i->second;
+            }
+        }
+
+        if (backend != nullptr && backend->m_redirectingRoot)
+        {
+            backend->OnError(e);
+            // The return value is ignored.
+            return 0;
+        }
+
+        // Print the Error and continue
+        const int MAX_ERROR_TEXT_LENGTH = 1024;
+
+        char error_text[MAX_ERROR_TEXT_LENGTH];
+
+        XGetErrorText(display, e->error_code, error_text, sizeof(error_text));
+
+        std::cerr << "Received X error on " << XDisplayString(display) << ":\n"
+            << "    Request: " << int(e->request_code)
+            << " - " <<  XRequestCodeToString(e->request_code) << "\n"
+            << "    Error code: " << int(e->error_code)
+            << " - " << error_text << "\n"
+            << "    Resource ID: " << e->resourceid;
+
+        // The return value is ignored.
+        return 0;
+
+    }
+
+    void XlibBackend::OnError(XErrorEvent* e)
+    {
+        // In the case of an already running window manager, the error code
+        // from XSelectInput is BadAccess.
+        if (static_cast<int>(e->error_code) == BadAccess)
+        {
+            m_wmDetected = true;
+        }
+    }
+
+    //------------------------------------------------------------------//
+    //                              EVENTS                              //
+    //------------------------------------------------------------------//
+
+    int XlibBackend::GetConnectionFd() const
+    {
+        return ConnectionNumber(m_connection);
+    }
+
+    bool XlibBackend::Pending()
+    {
+        return XPending(m_connection) != 0;
+    }
+
+    void XlibBackend::NextEvent(XEvent& e)
+    {
+        XNextEvent(m_connection, &e);
+    }
+
+    bool XlibBackend::CheckTypedWindowEvent(Window w, int type, XEvent& e)
+    {
+        return XCheckTypedWindowEvent(m_connection, w, type, &e);
+    }
+
+    bool XlibBackend::GrabPointerMotion([[maybe_unused]] Window w, [[maybe_unused]] Time time)
+    {
+#ifdef WM_HAVE_XI2
+        if (m_xiOpcode < 0)
+        {
+            return false;
+        }
+
+        // Replace the core grab the button press activated with one that
+        // reports motion at full resolution.
+        int device;
+        if (!XIGetClientPointer(m_connection, None, &device))
+        {
+            return false;
+        }
+
+        unsigned char mask_bits[XIMaskLen(XI_LASTEVENT)] = {};
+        XISetMask(mask_bits, XI_Motion);
+        XISetMask(mask_bits, XI_ButtonRelease);
+        XIEventMask mask{device, static_cast<int>(sizeof(mask_bits)), mask_bits};
+
+        return XIGrabDevice(m_connection, device, w, time, None, XIGrabModeAsync, XIGrabModeAsync, False, &mask) == XIGrabSuccess;
+#else
+        return false;
+#endif
+    }
+
+    void XlibBackend::UngrabPointerMotion([[maybe_unused]] Time time)
+    {
+#ifdef WM_HAVE_XI2
+        int device;
+        if (m_xiOpcode >= 0 && XIGetClientPointer(m_connection, None, &device))
+        {
+            XIUngrabDevice(m_connection, device, time);
+        }
+#endif
+    }
+
+    bool XlibBackend::GetPointerEvent([[maybe_unused]] XEvent& e, [[maybe_unused]] PointerEvent& pointer)
+    {
+#ifdef WM_HAVE_XI2
+        if (e.type != GenericEvent || e.xcookie.extension != m_xiOpcode || !XGetEventData(m_connection, &e.xcookie))
+        {
+            return false;
+        }
+
+        const bool is_pointer = e.xcookie.evtype == XI_Motion || e.xcookie.evtype == XI_ButtonRelease;
+        if (is_pointer)
+        {
+            const XIDeviceEvent* device_event = static_cast<const XIDeviceEvent*>(e.xcookie.data);
+            pointer.m_type = device_event->evtype;
+            pointer.m_device = device_event->deviceid;
+            pointer.m_window = device_event->event;
+            pointer.m_rootX = device_event->root_x;
+            pointer.m_rootY = device_event->root_y;
+            pointer.m_button = device_event->evtype == XI_ButtonRelease ? static_cast<unsigned int>(device_event->detail) : 0;
+            pointer.m_time = device_event->time;
+
+            // Core state: modifiers, then buttons 1 to 5 from Button1Mask up.
+            pointer.m_state = static_cast<unsigned int>(device_event->mods.effective);
+            for (int button = 1; button <= 5; ++button)
+            {
+                if (button < device_event->buttons.mask_len * 8 && XIMaskIsSet(device_event->buttons.mask, button))
+                {
+                    pointer.m_state |= Button1Mask << (button - 1);
+                }
+            }
+        }
+
+        XFreeEventData(m_connection, &e.xcookie);
+        return is_pointer;
+#else
+        return false;
+#endif
+    }
+
+    void XlibBackend::Flush()
+    {
+        XFlush(m_connection);
+    }
+
+    void XlibBackend::Sync()
+    {
+        XSync(m_connection, false);
+    }
+
+    //------------------------------------------------------------------//
+    //                             REQUESTS                             //
+    //------------------------------------------------------------------//
+
+    void XlibBackend::GrabServer()
+    {
+        XGrabServer(m_connection);
+    }
+
+    void XlibBackend::UngrabServer()
+    {
+        XUngrabServer(m_connection);
+    }
+
+    std::vector<Window> XlibBackend::QueryTree(Window w)
+    {
+        Window returned_root;
+        Window returned_parent;
+
+        Window* children;
+        unsigned int num_children;
+
+        if (XQueryTree(m_connection, w, &returned_root, &returned_parent,
+                       &children, &num_children) == 0)
+        {
+            throw std::runtime_error("We can't query the window list");
+        }
+
+        if(returned_root != m_rootWindow)
+        {
+            throw std::runtime_error("returned_root != m_rootWindow");
+        }
+
+        std::vector<Window> result(children, children + num_children);
+        XFree(children);
+        return result;
+    }
+
+    bool XlibBackend::GetWindowAttributes(Window w, XWindowAttributes& attributes)
+    {
+        return XGetWindowAttributes(m_connection, w, &attributes) != 0;
+    }
+
+    bool XlibBackend::GetGeometry(Window w, int& x, int& y, unsigned int& width, unsigned int& height)
+    {
+        Window returned_root;
+        unsigned int border_width;
+        unsigned int depth;
+
+        return XGetGeometry(m_connection, w, &returned_root, &x, &y,
+                            &width, &height, &border_width, &depth) != 0;
+    }
+
+    Window XlibBackend::CreateSimpleWindow(Window parent, int x, int y, unsigned int width, unsigned int height,
+                                           unsigned int border_width, unsigned long border, unsigned long background)
+    {
+        return XCreateSimpleWindow(m_connection, parent, x, y, width, height, border_width, border, background);
+    }
+
+    void XlibBackend::DestroyWindow(Window w)
+    {
+        XDestroyWindow(m_connection, w);
+    }
+
+    void XlibBackend::SelectInput(Window w, long event_mask)
+    {
+        XSelectInput(m_connection, w, event_mask);
+    }
+
+    void XlibBackend::ChangeWindowAttributes(Window w, unsigned long value_mask, const XSetWindowAttributes& attributes)
+    {
+        // Xlib doesn't modify the attributes, it just isn't const correct.
+        XChangeWindowAttributes(m_connection, w, value_mask, const_cast<XSetWindowAttributes*>(&attributes));
+    }
+
+    void XlibBackend::MapWindow(Window w)
+    {
+        XMapWindow(m_connection, w);
+    }
+
+    void XlibBackend::UnmapWindow(Window w)
+    {
+        XUnmapWindow(m_connection, w);
+    }
+
+    void XlibBackend::ReparentWindow(Window w, Window parent, int x, int y)
+    {
+        XReparentWindow(m_connection, w, parent, x, y);
+    }
+
+    void XlibBackend::AddToSaveSet(Window w)
+    {
+        XAddToSaveSet(m_connection, w);
+    }
+
+    void XlibBackend::RemoveFromSaveSet(Window w)
+    {
+        XRemoveFromSaveSet(m_connection, w);
+    }
+
+    void XlibBackend::ConfigureWindow(Window w, unsigned int value_mask, const XWindowChanges& changes)
+    {
+        // Xlib doesn't modify the changes, it just isn't const correct.
+        XConfigureWindow(m_connection, w, value_mask, const_cast<XWindowChanges*>(&changes));
+    }
+
+    void XlibBackend::MoveWindow(Window w, int x, int y)
+    {
+        XMoveWindow(m_connection, w, x, y);
+    }
+
+    void XlibBackend::ResizeWindow(Window w, unsigned int width, unsigned int height)
+    {
+        XResizeWindow(m_connection, w, width, height);
+    }
+
+    void XlibBackend::RaiseWindow(Window w)
+    {
+        XRaiseWindow(m_connection, w);
+    }
+
+    void XlibBackend::SetWindowBorderWidth(Window w, unsigned int width)
+    {
+        XSetWindowBorderWidth(m_connection, w, width);
+    }
+
+    void XlibBackend::SetWindowBorder(Window w, unsigned long pixel)
+    {
+        XSetWindowBorder(m_connection, w, pixel);
+    }
+
+    void XlibBackend::SetWindowBackground(Window w, unsigned long pixel)
+    {
+        XSetWindowBackground(m_connection, w, pixel);
+    }
+
+    void XlibBackend::ClearWindow(Window w)
+    {
+        XClearArea(m_connection, w, 0, 0, 0, 0, true);
+    }
+
+    void XlibBackend::CopyArea(Drawable src, Drawable dst, int src_x, int src_y,
+                               unsigned int width, unsigned int height, int dst_x, int dst_y)
+    {
+        XCopyArea(m_connection, src, dst, m_gc, src_x, src_y, width, height, dst_x, dst_y);
+    }
+
+    void XlibBackend::GrabButton(unsigned int button, unsigned int modifiers, Window w, unsigned int event_mask)
+    {
+        XGrabButton(
+            m_connection,
+            button,
+            modifiers,
+            w,
+            false,
+            event_mask,
+            GrabModeAsync,
+            GrabModeAsync,
+            None,
+            None
+        );
+    }
+
+    void XlibBackend::GrabKey(KeyCode keycode, unsigned int modifiers, Window w)
+    {
+        XGrabKey(m_connection, keycode, modifiers, w, false, GrabModeAsync, GrabModeAsync);
+    }
+
+    void XlibBackend::UngrabKey(KeyCode keycode, unsigned int modifiers, Window w)
+    {
+        XUngrabKey(m_connection, keycode, modifiers, w);
+    }
+
+    bool XlibBackend::GrabKeyboard(Window w, Time time)
+    {
+        return XGrabKeyboard(m_connection, w, false, GrabModeAsync, GrabModeAsync, time) == GrabSuccess;
+    }
+
+    void XlibBackend::UngrabKeyboard(Time time)
+    {
+        XUngrabKeyboard(m_connection, time);
+    }
+
+    KeyCode XlibBackend::KeysymToKeycode(KeySym keysym)
+    {
+        return XKeysymToKeycode(m_connection, keysym);
+    }
+
+    void XlibBackend::SetInputFocus(Window w)
+    {
+        XSetInputFocus(m_connection, w, RevertToPointerRoot, CurrentTime);
+    }
+
+    void XlibBackend::KillClient(Window w)
+    {
+        XKillClient(m_connection, w);
+    }
+
+    bool XlibBackend::SendEvent(Window w, long event_mask, XEvent& e)
+    {
+        return XSendEvent(m_connection, w, false, event_mask, &e) != 0;
+    }
+
+    std::vector<PropertyReply> XlibBackend::GetProperties(const std::vector<PropertyRequest>& requests)
+    {
+#ifndef WM_HAVE_XLIB_XCB
+        // The batch goes out on another connection, what was asked before it,
+        // like selecting property changes, must have been processed first.
+        XSync(m_connection, false);
+#endif
+        return m_propertyFetcher->Fetch(requests);
+    }
+
+    void XlibBackend::ChangeProperty(Window w, Atom property, Atom type, int format,
+                                     const unsigned char* data, int num_items)
+    {
+        XChangeProperty(m_connection, w, property, type, format, PropModeReplace, data, num_items);
+    }
+}
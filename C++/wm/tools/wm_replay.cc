@@ -0,0 +1,272 @@
+// Feeds a trace recorded with `WM --trace FILE` back into the window manager,
+// running against FakeBackend, and reports how long each event took to
+// handle.
+//
+// Usage: wm_replay [--realtime] [--verbose] TRACE
+//   --realtime  keep the recorded pacing instead of replaying flat out
+//   --verbose   keep the window manager's own log output
+
+#include "fake_backend.h"
+#include "trace.h"
+#include "util.h"
+#include "window_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <X11/Xproto.h>
+
+namespace
+{
+    struct Sample
+    {
+        std::size_t m_index;
+        std::chrono::nanoseconds m_time;
+        double m_ns;
+        XEvent m_event;
+    };
+
+    // Creates the windows an event refers to, so handlers find them.
+    void EnsureWindows(WM::FakeBackend& fake, const XEvent& e)
+    {
+        fake.EnsureWindow(e.xany.window);
+
+        switch (e.type)
+        {
+            case CreateNotify:
+                if (!fake.FindWindow(e.xcreatewindow.window))
+                {
+                    // Give the new window its real geometry, for Frame().
+                    fake.EnsureWindow(e.xcreatewindow.window);
+                    XWindowChanges changes;
+                    std::memset(&changes, 0, sizeof(changes));
+                    changes.x = e.xcreatewindow.x;
+                    changes.y = e.xcreatewindow.y;
+                    changes.width = e.xcreatewindow.width;
+                    changes.height = e.xcreatewindow.height;
+                    fake.ConfigureWindow(e.xcreatewindow.window, CWX | CWY | CWWidth | CWHeight, changes);
+                }
+            break;
+
+            case DestroyNotify:
+                fake.EnsureWindow(e.xdestroywindow.window);
+            break;
+
+            case UnmapNotify:
+                fake.EnsureWindow(e.xunmap.window);
+            break;
+
+            case MapNotify:
+                fake.EnsureWindow(e.xmap.window);
+            break;
+
+            case MapRequest:
+                fake.EnsureWindow(e.xmaprequest.window);
+            break;
+
+            case ReparentNotify:
+                fake.EnsureWindow(e.xreparent.window);
+            break;
+
+            case ConfigureNotify:
+                fake.EnsureWindow(e.xconfigure.window);
+            break;
+
+            case ConfigureRequest:
+                fake.EnsureWindow(e.xconfigurerequest.window);
+            break;
+        }
+    }
+
+    // Prepares the fake server for the records following an event, up to
+    // the next event: compressed events are queued where the handler will
+    // look for them, and windows the handler creates get their recorded ids.
+    // Requests made before the first event come from Start(), the children
+    // of the root window it queries are created mapped.
+    // Returns the offset of the next event.
+    std::size_t PrepareSegment(const WM::TraceReader& reader, std::size_t offset, WM::FakeBackend& fake,
+                               std::size_t& num_requests)
+    {
+        WM::TraceReader::Record record;
+        std::size_t next = offset;
+        while (reader.Read(next, record) && record.m_kind != WM::TraceRecordKind::Event)
+        {
+            offset = next;
+            if (record.m_kind == WM::TraceRecordKind::CheckedEvent)
+            {
+                const XEvent e = record.GetEvent();
+                EnsureWindows(fake, e);
+                fake.QueueEvent(e);
+                continue;
+            }
+
+            ++num_requests;
+            const WM::TraceRequest request = record.GetRequest();
+            if (request.m_opcode == X_CreateWindow)
+            {
+                for (const Window w : record.GetResults())
+                {
+                    fake.ReserveWindowId(w);
+                }
+            }
+            else if (request.m_opcode == X_QueryTree)
+            {
+                for (const Window w : record.GetResults())
+                {
+                    if (!fake.FindWindow(w))
+                    {
+                        fake.EnsureWindow(w);
+                        fake.MapWindow(w);
+                    }
+                }
+            }
+        }
+        return offset;
+    }
+
+    double Percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        const std::size_t i = std::min(values.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(values.size())));
+        std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(i), values.end());
+        return values[i];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool realtime = false;
+    bool verbose = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--realtime") == 0)
+        {
+            realtime = true;
+        }
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+        {
+            verbose = true;
+        }
+        else if (path.empty())
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path.clear();
+            break;
+        }
+    }
+
+    if (path.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--realtime] [--verbose] TRACE\n";
+        return 1;
+    }
+
+    try
+    {
+        const WM::TraceReader reader{path};
+
+        std::streambuf* const out = std::cout.rdbuf();
+        if (!verbose)
+        {
+            std::cout.rdbuf(nullptr);
+        }
+
+        auto backend = std::make_unique<WM::FakeBackend>();
+        WM::FakeBackend& fake = *backend;
+        WM::WindowManager wm{std::move(backend)};
+
+        // 1. Recreate the session as the window manager found it.
+        std::size_t num_requests = 0;
+        std::size_t offset = PrepareSegment(reader, reader.GetBegin(), fake, num_requests);
+        wm.Start();
+        fake.DiscardEvents();
+
+        // 2. Dispatch the recorded events one by one, dropping the events
+        // the fake server generates in response: the trace already has the
+        // real server's.
+        std::vector<double> latencies;
+        std::vector<Sample> slowest;
+        std::size_t num_errors = 0;
+        const auto start = std::chrono::steady_clock::now();
+
+        WM::TraceReader::Record record;
+        while (reader.Read(offset, record))
+        {
+            XEvent e = record.GetEvent();
+            EnsureWindows(fake, e);
+            offset = PrepareSegment(reader, offset, fake, num_requests);
+
+            if (realtime)
+            {
+                std::this_thread::sleep_until(start + record.m_time);
+            }
+
+            const auto before = std::chrono::steady_clock::now();
+            try
+            {
+                wm.HandleEvent(e);
+            }
+            catch (const std::runtime_error& error)
+            {
+                // The live window manager would have stopped here.
+                ++num_errors;
+                std::cerr << "Event " << latencies.size() << ": " << error.what() << '\n';
+            }
+            const auto after = std::chrono::steady_clock::now();
+            fake.DiscardEvents();
+
+            const double ns = std::chrono::duration<double, std::nano>(after - before).count();
+            slowest.push_back({latencies.size(), record.m_time, ns, record.GetEvent()});
+            latencies.push_back(ns);
+
+            // Keep the ten slowest.
+            std::sort(slowest.begin(), slowest.end(), [](const Sample& a, const Sample& b) { return a.m_ns > b.m_ns; });
+            if (slowest.size() > 10)
+            {
+                slowest.pop_back();
+            }
+        }
+
+        std::cout.rdbuf(out);
+
+        // 3. Report.
+        double total = 0.0;
+        for (const double ns : latencies)
+        {
+            total += ns;
+        }
+        std::printf("%zu events, %zu recorded requests, %zu errors\n", latencies.size(), num_requests, num_errors);
+        std::printf("handler time: total %.3f ms, p50 %.0f ns, p99 %.0f ns, max %.0f ns\n",
+                    total / 1e6, Percentile(latencies, 0.5), Percentile(latencies, 0.99),
+                    latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end()));
+
+        std::printf("slowest events:\n");
+        for (const Sample& sample : slowest)
+        {
+            std::printf("  #%-8zu at %10.3f ms  %10.0f ns  %s\n", sample.m_index,
+                        static_cast<double>(sample.m_time.count()) / 1e6, sample.m_ns,
+                        ToString(sample.m_event).c_str());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}